@@ -16,7 +16,7 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
 /* Set shader_id as default background shader for scene_id.
  * Note that shader_id is the ID for the shader specific to this scene.
@@ -26,11 +26,12 @@ extern std::vector<CCScene> scenes;
  */
 void cycles_scene_set_background_shader(unsigned int client_id, unsigned int scene_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_scene_set_background_shader, client_id, scene_id, shader_id);
 	SCENE_FIND(scene_id)
 		sce->default_background = shader_id;
 		sce->background->shader = shader_id;
 		sce->background->tag_update(sce);
-		logger.logit(client_id, "Scene ", scene_id, " set background shader ", shader_id);
+		CCLOG_TRACE(client_id, "Scene ", scene_id, " set background shader ", shader_id);
 	SCENE_FIND_END()
 }
 
@@ -44,27 +45,30 @@ unsigned int cycles_scene_get_background_shader(unsigned int client_id, unsigned
 
 void cycles_scene_set_background_ao_factor(unsigned int client_id, unsigned int scene_id, float ao_factor)
 {
+	CCCAPTURE(cycles_scene_set_background_ao_factor, client_id, scene_id, ao_factor);
 	SCENE_FIND(scene_id)
 		sce->background->ao_factor = ao_factor;
 		sce->background->tag_update(sce);
-		logger.logit(client_id, "Scene ", scene_id, " set background ao factor ", ao_factor);
+		CCLOG_TRACE(client_id, "Scene ", scene_id, " set background ao factor ", ao_factor);
 	SCENE_FIND_END()
 }
 
 void cycles_scene_set_background_ao_distance(unsigned int client_id, unsigned int scene_id, float ao_distance)
 {
+	CCCAPTURE(cycles_scene_set_background_ao_distance, client_id, scene_id, ao_distance);
 	SCENE_FIND(scene_id)
 		sce->background->ao_distance = ao_distance;
 		sce->background->tag_update(sce);
-		logger.logit(client_id, "Scene ", scene_id, " set background ao distance ", ao_distance);
+		CCLOG_TRACE(client_id, "Scene ", scene_id, " set background ao distance ", ao_distance);
 	SCENE_FIND_END()
 }
 
 void cycles_scene_set_background_visibility(unsigned int client_id, unsigned int scene_id, unsigned int path_ray_flag)
 {
+	CCCAPTURE(cycles_scene_set_background_visibility, client_id, scene_id, path_ray_flag);
 	SCENE_FIND(scene_id)
 		sce->background->visibility = (ccl::PathRayFlag)path_ray_flag;
 		sce->background->tag_update(sce);
-		logger.logit(client_id, "Scene ", scene_id, " set background path ray visibility ", path_ray_flag);
+		CCLOG_TRACE(client_id, "Scene ", scene_id, " set background path ray visibility ", path_ray_flag);
 	SCENE_FIND_END()
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <cmath>
+
+#include "internal_types.h"
+
+#include "half.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CCYCLES_CONVERT_SSE2
+#include <emmintrin.h>
+#endif
+
+unsigned int buffer_format_component_size(buffer_format format)
+{
+	switch (format) {
+		case buffer_format::HALF:
+			return sizeof(unsigned short);
+		case buffer_format::RGBA8_SRGB:
+			return sizeof(unsigned char);
+		case buffer_format::FLOAT:
+		default:
+			return sizeof(float);
+	}
+}
+
+/* Linear to sRGB lookup, indexed by the top bits of the float representation:
+ * all exponents from SRGB_MIN up to 1.0 with 8 bits of mantissa each. That
+ * keeps results within one step of the exact 8-bit value over the whole
+ * range. Anything below SRGB_MIN encodes to 0 anyway.
+ */
+static const float SRGB_MIN{ 1.0f / 8192.0f };
+static const float SRGB_MAX{ 0.99999994f };
+static const unsigned int SRGB_MIN_BITS{ (127 - 13) << 23 };
+static const int SRGB_SHIFT{ 23 - 8 };
+static const int SRGB_TABLE_SIZE{ 13 << 8 };
+
+struct SrgbTable {
+	unsigned char values[SRGB_TABLE_SIZE];
+
+	SrgbTable()
+	{
+		for (int i = 0; i < SRGB_TABLE_SIZE; i++) {
+			/* Center of the range of floats that map to this entry. */
+			unsigned int bits = SRGB_MIN_BITS + ((unsigned int)i << SRGB_SHIFT) + (1u << (SRGB_SHIFT - 1));
+			float linear;
+			memcpy(&linear, &bits, sizeof(float));
+
+			float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+			values[i] = (unsigned char)std::min(255.0f, srgb * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const SrgbTable& srgb_table()
+{
+	static const SrgbTable table;
+	return table;
+}
+
+static inline unsigned char linear_to_srgb8(const SrgbTable& table, float v)
+{
+	/* Written so that NaN ends up at SRGB_MIN. */
+	v = v > SRGB_MIN ? v : SRGB_MIN;
+	v = v < SRGB_MAX ? v : SRGB_MAX;
+	unsigned int bits;
+	memcpy(&bits, &v, sizeof(float));
+	return table.values[(bits - SRGB_MIN_BITS) >> SRGB_SHIFT];
+}
+
+static inline unsigned char unit_to_u8(float v)
+{
+	v = v > 0.0f ? v : 0.0f;
+	v = v < 1.0f ? v : 1.0f;
+	return (unsigned char)(v * 255.0f + 0.5f);
+}
+
+#if defined(CCYCLES_CONVERT_SSE2)
+/* Four floats to half, results in the low 16 bits of each lane. Normals
+ * round to nearest with ties away from zero, denormals get whatever the FPU
+ * rounding mode gives. Close to half(float) but not bit exact: denormal and
+ * tie cases can be one step off, and tiny negative values give -0.
+ */
+static inline __m128i float_to_half_sse2(__m128 f)
+{
+	const __m128i mask_sign = _mm_set1_epi32(0x80000000u);
+	const __m128i f16max = _mm_set1_epi32((127 + 16) << 23);
+	const __m128i nanbit = _mm_set1_epi32(0x200);
+	const __m128i infinity = _mm_set1_epi32(0x7c00);
+	const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+	const __m128i subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i normal_bias = _mm_set1_epi32(0x1000 - ((127 - 15) << 23));
+
+	__m128 justsign = _mm_and_ps(_mm_castsi128_ps(mask_sign), f);
+	__m128 absf = _mm_xor_ps(f, justsign);
+	__m128i absf_int = _mm_castps_si128(absf);
+
+	__m128 is_nan = _mm_cmpunord_ps(absf, absf);
+	__m128i is_regular = _mm_cmpgt_epi32(f16max, absf_int);
+	__m128i inf_or_nan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(is_nan), nanbit), infinity);
+
+	/* Result is a denormal half: let the FPU do the rounding. */
+	__m128i is_subnormal = _mm_cmpgt_epi32(min_normal, absf_int);
+	__m128 subnorm1 = _mm_add_ps(absf, _mm_castsi128_ps(subnorm_magic));
+	__m128i subnorm2 = _mm_sub_epi32(_mm_castps_si128(subnorm1), subnorm_magic);
+
+	/* Result is a normal half: rebias exponent and round mantissa. */
+	__m128i normal = _mm_srli_epi32(_mm_add_epi32(absf_int, normal_bias), 13);
+
+	__m128i nonspecial = _mm_or_si128(_mm_and_si128(subnorm2, is_subnormal), _mm_andnot_si128(is_subnormal, normal));
+	__m128i joined = _mm_or_si128(_mm_and_si128(nonspecial, is_regular), _mm_andnot_si128(is_regular, inf_or_nan));
+
+	__m128i sign = _mm_srai_epi32(_mm_castps_si128(justsign), 16);
+	return _mm_or_si128(joined, sign);
+}
+#endif
+
+static void convert_to_half(unsigned short* dst, const float* src, size_t count)
+{
+	size_t i{ 0 };
+
+#if defined(CCYCLES_CONVERT_SSE2)
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = float_to_half_sse2(_mm_loadu_ps(&src[i]));
+		__m128i hi = float_to_half_sse2(_mm_loadu_ps(&src[i + 4]));
+		/* Sign extended 16 bit values, the signed pack doesn't saturate them. */
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_packs_epi32(lo, hi));
+	}
+#endif
+
+	for (; i < count; i++) {
+		dst[i] = ::half(src[i]).bits();
+	}
+}
+
+static void convert_to_srgb8(unsigned char* dst, const float* src, size_t pixel_count)
+{
+	const SrgbTable& table = srgb_table();
+	size_t p{ 0 };
+
+#if defined(CCYCLES_CONVERT_SSE2)
+	const __m128 lo = _mm_set1_ps(SRGB_MIN);
+	const __m128 hi = _mm_set1_ps(SRGB_MAX);
+	const __m128i min_bits = _mm_set1_epi32(SRGB_MIN_BITS);
+	const __m128 alpha_scale = _mm_set1_ps(255.0f);
+	const __m128 half_ = _mm_set1_ps(0.5f);
+
+	/* Clamp and table index for a whole pixel at once, only the lookups
+	 * themselves are scalar. Alpha isn't gamma encoded.
+	 */
+	alignas(16) int idx[4];
+	alignas(16) int alpha[4];
+	for (; p < pixel_count; p++) {
+		__m128 v = _mm_loadu_ps(&src[p * 4]);
+		__m128 c = _mm_min_ps(_mm_max_ps(v, lo), hi);
+		__m128i bits = _mm_srli_epi32(_mm_sub_epi32(_mm_castps_si128(c), min_bits), SRGB_SHIFT);
+		_mm_store_si128((__m128i*)idx, bits);
+
+		__m128 a = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		_mm_store_si128((__m128i*)alpha, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(a, alpha_scale), half_)));
+
+		unsigned char* out = &dst[p * 4];
+		out[0] = table.values[idx[0]];
+		out[1] = table.values[idx[1]];
+		out[2] = table.values[idx[2]];
+		out[3] = (unsigned char)alpha[3];
+	}
+#endif
+
+	for (; p < pixel_count; p++) {
+		const float* in = &src[p * 4];
+		unsigned char* out = &dst[p * 4];
+		out[0] = linear_to_srgb8(table, in[0]);
+		out[1] = linear_to_srgb8(table, in[1]);
+		out[2] = linear_to_srgb8(table, in[2]);
+		out[3] = unit_to_u8(in[3]);
+	}
+}
+
+void convert_pixels(buffer_format format, unsigned char* dst, const float* src, size_t pixel_count, unsigned int components)
+{
+	switch (format) {
+		case buffer_format::HALF:
+			convert_to_half((unsigned short*)dst, src, pixel_count * components);
+			break;
+		case buffer_format::RGBA8_SRGB:
+			/* Only RGBA is meaningful for sRGB. */
+			if (components == 4) {
+				convert_to_srgb8(dst, src, pixel_count);
+			}
+			break;
+		case buffer_format::FLOAT:
+		default:
+			memcpy(dst, src, pixel_count * components * sizeof(float));
+			break;
+	}
+}
@@ -16,10 +16,11 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
 void cycles_camera_set_size(unsigned int client_id, unsigned int scene_id, unsigned int width, unsigned int height)
 {
+	CCCAPTURE(cycles_camera_set_size, client_id, scene_id, width, height);
 	SCENE_FIND(scene_id)
 		sce->camera->width = width;
 		sce->camera->height = height;
@@ -49,6 +50,7 @@ unsigned int cycles_camera_get_height(unsigned int client_id, unsigned int scene
 
 void cycles_camera_set_type(unsigned int client_id, unsigned int scene_id, camera_type type)
 {
+	CCCAPTURE(cycles_camera_set_type, client_id, scene_id, type);
 	SCENE_FIND(scene_id)
 		sce->camera->type = (ccl::CameraType)type;
 	SCENE_FIND_END()
@@ -56,6 +58,7 @@ void cycles_camera_set_type(unsigned int client_id, unsigned int scene_id, camer
 
 void cycles_camera_set_panorama_type(unsigned int client_id, unsigned int scene_id, panorama_type type)
 {
+	CCCAPTURE(cycles_camera_set_panorama_type, client_id, scene_id, type);
 	SCENE_FIND(scene_id)
 		sce->camera->panorama_type = (ccl::PanoramaType)type;
 	SCENE_FIND_END()
@@ -68,9 +71,10 @@ void cycles_camera_set_matrix(unsigned int client_id, unsigned int scene_id,
 	float m, float n, float o, float p
 	)
 {
+	CCCAPTURE(cycles_camera_set_matrix, client_id, scene_id, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
 	SCENE_FIND(scene_id)
 		ccl::Transform mat = ccl::make_transform(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
-		logger.logit(client_id, "Setting camera matrix in scene ", scene_id, " to\n",
+		CCLOG_TRACE(client_id, "Setting camera matrix in scene ", scene_id, " to\n",
 			"\t[", a, ",", b, ",", c, ",", d, "\n",
 			"\t ", e, ",", f, ",", g, ",", h, "\n",
 			"\t ", i, ",", j, ",", k, ",", l, "\n",
@@ -82,16 +86,18 @@ void cycles_camera_set_matrix(unsigned int client_id, unsigned int scene_id,
 
 void cycles_camera_compute_auto_viewplane(unsigned int client_id, unsigned int scene_id)
 {
+	CCCAPTURE(cycles_camera_compute_auto_viewplane, client_id, scene_id);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Computing auto viewplane for scene ", scene_id); 
+		CCLOG_TRACE(client_id, "Computing auto viewplane for scene ", scene_id); 
 		sce->camera->compute_auto_viewplane();
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_viewplane(unsigned int client_id, unsigned int scene_id, float left, float right, float top, float bottom)
 {
+	CCCAPTURE(cycles_camera_set_viewplane, client_id, scene_id, left, right, top, bottom);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Set viewplane for scene ", scene_id, " to ", left, ":", right, ":", top, ":", bottom); 
+		CCLOG_TRACE(client_id, "Set viewplane for scene ", scene_id, " to ", left, ":", right, ":", top, ":", bottom); 
 		sce->camera->viewplane.left = left;
 		sce->camera->viewplane.right = right;
 		sce->camera->viewplane.top = top;
@@ -102,8 +108,9 @@ void cycles_camera_set_viewplane(unsigned int client_id, unsigned int scene_id,
 
 void cycles_camera_update(unsigned int client_id, unsigned int scene_id)
 {
+	CCCAPTURE(cycles_camera_update, client_id, scene_id);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Updating camera for scene ", scene_id); 
+		CCLOG_TRACE(client_id, "Updating camera for scene ", scene_id); 
 		sce->camera->need_update = true;
 		sce->camera->update();
 	SCENE_FIND_END()
@@ -111,104 +118,117 @@ void cycles_camera_update(unsigned int client_id, unsigned int scene_id)
 
 void cycles_camera_set_fov(unsigned int client_id, unsigned int scene_id, float fov)
 {
+	CCCAPTURE(cycles_camera_set_fov, client_id, scene_id, fov);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera fov to ", fov);
+		CCLOG_TRACE(client_id, "Setting camera fov to ", fov);
 		sce->camera->fov = fov;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_sensor_width(unsigned int client_id, unsigned int scene_id, float sensor_width)
 {
+	CCCAPTURE(cycles_camera_set_sensor_width, client_id, scene_id, sensor_width);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera sensor_width to ", sensor_width);
+		CCLOG_TRACE(client_id, "Setting camera sensor_width to ", sensor_width);
 		sce->camera->sensorwidth = sensor_width;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_sensor_height(unsigned int client_id, unsigned int scene_id, float sensor_height)
 {
+	CCCAPTURE(cycles_camera_set_sensor_height, client_id, scene_id, sensor_height);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera sensor_height to ", sensor_height);
+		CCLOG_TRACE(client_id, "Setting camera sensor_height to ", sensor_height);
 		sce->camera->sensorheight = sensor_height;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_nearclip(unsigned int client_id, unsigned int scene_id, float nearclip)
 {
+	CCCAPTURE(cycles_camera_set_nearclip, client_id, scene_id, nearclip);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera nearclip to ", nearclip);
+		CCLOG_TRACE(client_id, "Setting camera nearclip to ", nearclip);
 		sce->camera->nearclip = nearclip;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_farclip(unsigned int client_id, unsigned int scene_id, float farclip)
 {
+	CCCAPTURE(cycles_camera_set_farclip, client_id, scene_id, farclip);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera farclip to ", farclip);
+		CCLOG_TRACE(client_id, "Setting camera farclip to ", farclip);
 		sce->camera->farclip = farclip;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_aperturesize(unsigned int client_id, unsigned int scene_id, float aperturesize)
 {
+	CCCAPTURE(cycles_camera_set_aperturesize, client_id, scene_id, aperturesize);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera aperturesize to ", aperturesize);
+		CCLOG_TRACE(client_id, "Setting camera aperturesize to ", aperturesize);
 		sce->camera->aperturesize = aperturesize;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_aperture_ratio(unsigned int client_id, unsigned int scene_id, float aperture_ratio)
 {
+	CCCAPTURE(cycles_camera_set_aperture_ratio, client_id, scene_id, aperture_ratio);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera aperture_ratio to ", aperture_ratio);
+		CCLOG_TRACE(client_id, "Setting camera aperture_ratio to ", aperture_ratio);
 		sce->camera->aperture_ratio = aperture_ratio;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_blades(unsigned int client_id, unsigned int scene_id, unsigned int blades)
 {
+	CCCAPTURE(cycles_camera_set_blades, client_id, scene_id, blades);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera blades to ", blades);
+		CCLOG_TRACE(client_id, "Setting camera blades to ", blades);
 		sce->camera->blades = blades;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_bladesrotation(unsigned int client_id, unsigned int scene_id, float bladesrotation)
 {
+	CCCAPTURE(cycles_camera_set_bladesrotation, client_id, scene_id, bladesrotation);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera bladesrotation to ", bladesrotation);
+		CCLOG_TRACE(client_id, "Setting camera bladesrotation to ", bladesrotation);
 		sce->camera->bladesrotation = bladesrotation;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_focaldistance(unsigned int client_id, unsigned int scene_id, float focaldistance)
 {
+	CCCAPTURE(cycles_camera_set_focaldistance, client_id, scene_id, focaldistance);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera focaldistance to ", focaldistance);
+		CCLOG_TRACE(client_id, "Setting camera focaldistance to ", focaldistance);
 		sce->camera->focaldistance = focaldistance;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_shuttertime(unsigned int client_id, unsigned int scene_id, float shuttertime)
 {
+	CCCAPTURE(cycles_camera_set_shuttertime, client_id, scene_id, shuttertime);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera shuttertime to ", shuttertime);
+		CCLOG_TRACE(client_id, "Setting camera shuttertime to ", shuttertime);
 		sce->camera->shuttertime = shuttertime;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_fisheye_fov(unsigned int client_id, unsigned int scene_id, float fisheye_fov)
 {
+	CCCAPTURE(cycles_camera_set_fisheye_fov, client_id, scene_id, fisheye_fov);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera fisheye_fov to ", fisheye_fov);
+		CCLOG_TRACE(client_id, "Setting camera fisheye_fov to ", fisheye_fov);
 		sce->camera->fisheye_fov = fisheye_fov;
 	SCENE_FIND_END()
 }
 
 void cycles_camera_set_fisheye_lens(unsigned int client_id, unsigned int scene_id, float fisheye_lens)
 {
+	CCCAPTURE(cycles_camera_set_fisheye_lens, client_id, scene_id, fisheye_lens);
 	SCENE_FIND(scene_id)
-		logger.logit(client_id, "Setting camera fisheye_lens to ", fisheye_lens);
+		CCLOG_TRACE(client_id, "Setting camera fisheye_lens to ", fisheye_lens);
 		sce->camera->fisheye_lens = fisheye_lens;
 	SCENE_FIND_END()
 }
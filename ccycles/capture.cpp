@@ -0,0 +1,63 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "internal_types.h"
+
+CCCapture capture;
+
+thread_local int CCCaptureScope::depth{ 0 };
+
+bool CCCapture::start(const char* path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (out.is_open()) out.close();
+	out.clear();
+	out.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out) {
+		on.store(false, std::memory_order_relaxed);
+		return false;
+	}
+
+	CCCaptureWriter writer(out);
+	writer.value(CAPTURE_MAGIC);
+	writer.value(CAPTURE_VERSION);
+	writer.value((unsigned int)capture_call::COUNT);
+
+	on.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+void CCCapture::stop()
+{
+	on.store(false, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (out.is_open()) out.close();
+}
+
+unsigned int cycles_capture_start(const char* path)
+{
+	CCTRACE_API();
+	if (path == nullptr) return 0;
+	return capture.start(path) ? 1 : 0;
+}
+
+void cycles_capture_stop()
+{
+	CCTRACE_API();
+	capture.stop();
+}
@@ -0,0 +1,200 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+
+/* API calls recorded by cycles_capture_start, in call id order. Include
+ * with CCCAPTURE_CALL(name) defined. Only append to this list, a call id
+ * is its position here and ids are stored in capture logs.
+ *
+ * Queries, drawing and callback setters are left out, replaying them
+ * changes nothing.
+ */
+
+CCCAPTURE_CALL(cycles_initialise)
+CCCAPTURE_CALL(cycles_path_init)
+CCCAPTURE_CALL(cycles_shutdown)
+CCCAPTURE_CALL(cycles_new_client)
+CCCAPTURE_CALL(cycles_release_client)
+CCCAPTURE_CALL(cycles_scene_params_create)
+CCCAPTURE_CALL(cycles_scene_params_set_bvh_type)
+CCCAPTURE_CALL(cycles_scene_params_set_bvh_spatial_split)
+CCCAPTURE_CALL(cycles_scene_params_set_qbvh)
+CCCAPTURE_CALL(cycles_scene_params_set_shadingsystem)
+CCCAPTURE_CALL(cycles_scene_params_set_persistent_data)
+CCCAPTURE_CALL(cycles_scene_add_mesh)
+CCCAPTURE_CALL(cycles_scene_add_mesh_object)
+CCCAPTURE_CALL(cycles_scene_add_meshes_batch)
+CCCAPTURE_CALL(cycles_scene_add_object)
+CCCAPTURE_CALL(cycles_scene_object_set_matrix)
+CCCAPTURE_CALL(cycles_scene_object_set_mesh)
+CCCAPTURE_CALL(cycles_scene_add_mesh_instance)
+CCCAPTURE_CALL(cycles_scene_object_set_visibility)
+CCCAPTURE_CALL(cycles_scene_object_set_is_shadowcatcher)
+CCCAPTURE_CALL(cycles_object_tag_update)
+CCCAPTURE_CALL(cycles_integrator_tag_update)
+CCCAPTURE_CALL(cycles_integrator_set_max_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_min_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_no_caustics)
+CCCAPTURE_CALL(cycles_integrator_set_transparent_shadows)
+CCCAPTURE_CALL(cycles_integrator_set_diffuse_samples)
+CCCAPTURE_CALL(cycles_integrator_set_glossy_samples)
+CCCAPTURE_CALL(cycles_integrator_set_transmission_samples)
+CCCAPTURE_CALL(cycles_integrator_set_ao_samples)
+CCCAPTURE_CALL(cycles_integrator_set_mesh_light_samples)
+CCCAPTURE_CALL(cycles_integrator_set_subsurface_samples)
+CCCAPTURE_CALL(cycles_integrator_set_volume_samples)
+CCCAPTURE_CALL(cycles_integrator_set_max_diffuse_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_max_glossy_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_max_transmission_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_max_volume_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_transparent_min_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_transparent_max_bounce)
+CCCAPTURE_CALL(cycles_integrator_set_aa_samples)
+CCCAPTURE_CALL(cycles_integrator_set_filter_glossy)
+CCCAPTURE_CALL(cycles_integrator_set_method)
+CCCAPTURE_CALL(cycles_integrator_set_sample_all_lights_direct)
+CCCAPTURE_CALL(cycles_integrator_set_sample_all_lights_indirect)
+CCCAPTURE_CALL(cycles_integrator_set_volume_step_size)
+CCCAPTURE_CALL(cycles_integrator_set_volume_max_steps)
+CCCAPTURE_CALL(cycles_integrator_set_seed)
+CCCAPTURE_CALL(cycles_integrator_set_sampling_pattern)
+CCCAPTURE_CALL(cycles_integrator_set_sample_clamp_direct)
+CCCAPTURE_CALL(cycles_integrator_set_sample_clamp_indirect)
+CCCAPTURE_CALL(cycles_camera_set_size)
+CCCAPTURE_CALL(cycles_camera_set_type)
+CCCAPTURE_CALL(cycles_camera_set_panorama_type)
+CCCAPTURE_CALL(cycles_camera_set_matrix)
+CCCAPTURE_CALL(cycles_camera_compute_auto_viewplane)
+CCCAPTURE_CALL(cycles_camera_set_viewplane)
+CCCAPTURE_CALL(cycles_camera_update)
+CCCAPTURE_CALL(cycles_camera_set_fov)
+CCCAPTURE_CALL(cycles_camera_set_sensor_width)
+CCCAPTURE_CALL(cycles_camera_set_sensor_height)
+CCCAPTURE_CALL(cycles_camera_set_nearclip)
+CCCAPTURE_CALL(cycles_camera_set_farclip)
+CCCAPTURE_CALL(cycles_camera_set_aperturesize)
+CCCAPTURE_CALL(cycles_camera_set_aperture_ratio)
+CCCAPTURE_CALL(cycles_camera_set_blades)
+CCCAPTURE_CALL(cycles_camera_set_bladesrotation)
+CCCAPTURE_CALL(cycles_camera_set_focaldistance)
+CCCAPTURE_CALL(cycles_camera_set_shuttertime)
+CCCAPTURE_CALL(cycles_camera_set_fisheye_fov)
+CCCAPTURE_CALL(cycles_camera_set_fisheye_lens)
+CCCAPTURE_CALL(cycles_session_create)
+CCCAPTURE_CALL(cycles_session_reset)
+CCCAPTURE_CALL(cycles_session_reset_region)
+CCCAPTURE_CALL(cycles_session_set_keep_raw_buffer)
+CCCAPTURE_CALL(cycles_session_import_raw_buffer)
+CCCAPTURE_CALL(cycles_session_cancel)
+CCCAPTURE_CALL(cycles_session_start)
+CCCAPTURE_CALL(cycles_session_wait)
+CCCAPTURE_CALL(cycles_session_set_pause)
+CCCAPTURE_CALL(cycles_session_set_samples)
+CCCAPTURE_CALL(cycles_session_set_adaptive_sampling)
+CCCAPTURE_CALL(cycles_session_destroy)
+CCCAPTURE_CALL(cycles_session_pool_set_capacity)
+CCCAPTURE_CALL(cycles_session_pool_prewarm)
+CCCAPTURE_CALL(cycles_session_pool_clear)
+CCCAPTURE_CALL(cycles_session_set_buffer_format)
+CCCAPTURE_CALL(cycles_session_add_pass)
+CCCAPTURE_CALL(cycles_progress_reset)
+CCCAPTURE_CALL(cycles_session_params_create)
+CCCAPTURE_CALL(cycles_session_params_set_device)
+CCCAPTURE_CALL(cycles_session_params_set_background)
+CCCAPTURE_CALL(cycles_session_params_set_progressive_refine)
+CCCAPTURE_CALL(cycles_session_params_set_output_path)
+CCCAPTURE_CALL(cycles_session_params_set_progressive)
+CCCAPTURE_CALL(cycles_session_params_set_experimental)
+CCCAPTURE_CALL(cycles_session_params_set_samples)
+CCCAPTURE_CALL(cycles_session_params_set_tile_size)
+CCCAPTURE_CALL(cycles_session_params_set_tile_order)
+CCCAPTURE_CALL(cycles_session_params_set_start_resolution)
+CCCAPTURE_CALL(cycles_session_params_set_threads)
+CCCAPTURE_CALL(cycles_session_params_set_display_buffer_linear)
+CCCAPTURE_CALL(cycles_session_params_set_skip_linear_to_srgb_conversion)
+CCCAPTURE_CALL(cycles_session_params_set_cancel_timeout)
+CCCAPTURE_CALL(cycles_session_params_set_reset_timeout)
+CCCAPTURE_CALL(cycles_session_params_set_text_timeout)
+CCCAPTURE_CALL(cycles_session_params_set_shadingsystem)
+CCCAPTURE_CALL(cycles_session_params_set_time_limit)
+CCCAPTURE_CALL(cycles_scene_create)
+CCCAPTURE_CALL(cycles_scene_set_background_shader)
+CCCAPTURE_CALL(cycles_scene_set_background_ao_factor)
+CCCAPTURE_CALL(cycles_scene_set_background_ao_distance)
+CCCAPTURE_CALL(cycles_scene_set_background_visibility)
+CCCAPTURE_CALL(cycles_scene_reset)
+CCCAPTURE_CALL(cycles_mesh_set_verts)
+CCCAPTURE_CALL(cycles_mesh_set_tris)
+CCCAPTURE_CALL(cycles_mesh_set_verts_float4)
+CCCAPTURE_CALL(cycles_mesh_set_tris_bulk)
+CCCAPTURE_CALL(cycles_mesh_add_triangle)
+CCCAPTURE_CALL(cycles_mesh_set_uvs)
+CCCAPTURE_CALL(cycles_mesh_set_vertex_normals)
+CCCAPTURE_CALL(cycles_mesh_set_smooth)
+CCCAPTURE_CALL(cycles_mesh_clear)
+CCCAPTURE_CALL(cycles_mesh_tag_rebuild)
+CCCAPTURE_CALL(cycles_mesh_set_shader)
+CCCAPTURE_CALL(cycles_create_shader)
+CCCAPTURE_CALL(cycles_scene_tag_shader)
+CCCAPTURE_CALL(cycles_scene_add_shader)
+CCCAPTURE_CALL(cycles_scene_set_default_surface_shader)
+CCCAPTURE_CALL(cycles_add_shader_node)
+CCCAPTURE_CALL(cycles_shadernode_set_attribute_int)
+CCCAPTURE_CALL(cycles_shadernode_set_attribute_float)
+CCCAPTURE_CALL(cycles_shadernode_set_attribute_vec)
+CCCAPTURE_CALL(cycles_shadernode_set_attribute_string)
+CCCAPTURE_CALL(cycles_shadernode_set_enum)
+CCCAPTURE_CALL(cycles_shadernode_texmapping_set_transformation)
+CCCAPTURE_CALL(cycles_shadernode_texmapping_set_mapping)
+CCCAPTURE_CALL(cycles_shadernode_texmapping_set_projection)
+CCCAPTURE_CALL(cycles_shadernode_texmapping_set_type)
+CCCAPTURE_CALL(cycles_shadernode_set_member_bool)
+CCCAPTURE_CALL(cycles_shadernode_set_member_float)
+CCCAPTURE_CALL(cycles_shadernode_set_member_int)
+CCCAPTURE_CALL(cycles_shadernode_set_member_vec)
+CCCAPTURE_CALL(cycles_shadernode_set_member_vec4_at_index)
+CCCAPTURE_CALL(cycles_shadernode_set_member_float_img)
+CCCAPTURE_CALL(cycles_shadernode_set_member_byte_img)
+CCCAPTURE_CALL(cycles_shader_set_name)
+CCCAPTURE_CALL(cycles_shader_set_use_mis)
+CCCAPTURE_CALL(cycles_shader_set_use_transparent_shadow)
+CCCAPTURE_CALL(cycles_shader_set_heterogeneous_volume)
+CCCAPTURE_CALL(cycles_shader_new_graph)
+CCCAPTURE_CALL(cycles_shader_connect_nodes)
+CCCAPTURE_CALL(cycles_create_light)
+CCCAPTURE_CALL(cycles_light_set_type)
+CCCAPTURE_CALL(cycles_light_set_spot_angle)
+CCCAPTURE_CALL(cycles_light_set_spot_smooth)
+CCCAPTURE_CALL(cycles_light_set_cast_shadow)
+CCCAPTURE_CALL(cycles_light_set_use_mis)
+CCCAPTURE_CALL(cycles_light_set_samples)
+CCCAPTURE_CALL(cycles_light_set_max_bounces)
+CCCAPTURE_CALL(cycles_light_set_map_resolution)
+CCCAPTURE_CALL(cycles_light_set_sizeu)
+CCCAPTURE_CALL(cycles_light_set_sizev)
+CCCAPTURE_CALL(cycles_light_set_axisu)
+CCCAPTURE_CALL(cycles_light_set_axisv)
+CCCAPTURE_CALL(cycles_light_set_size)
+CCCAPTURE_CALL(cycles_light_set_dir)
+CCCAPTURE_CALL(cycles_light_set_co)
+CCCAPTURE_CALL(cycles_light_tag_update)
+CCCAPTURE_CALL(cycles_film_set_exposure)
+CCCAPTURE_CALL(cycles_film_set_filter)
+CCCAPTURE_CALL(cycles_film_set_use_sample_clamp)
+CCCAPTURE_CALL(cycles_film_tag_update)
+CCCAPTURE_CALL(cycles_scene_load_xml)
+CCCAPTURE_CALL(cycles_mesh_load_binary)
+CCCAPTURE_CALL(cycles_scene_destroy)
@@ -0,0 +1,298 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+
+#ifndef __CAPTURE_FORMAT__H__
+#define __CAPTURE_FORMAT__H__
+
+/* Binary log written by cycles_capture_start and read by ccycles_replay.
+ *
+ * The log starts with CAPTURE_MAGIC, CAPTURE_VERSION and the number of
+ * calls in capture_calls.h, as unsigned ints. Then one record per call: the
+ * call id as unsigned short and the arguments in parameter order. How an
+ * argument is stored follows from the parameter type of the API function,
+ * see CCCaptureArg, so records carry no type information.
+ *
+ * Values are in host byte order.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <ostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+static const unsigned int CAPTURE_MAGIC{ 0x50414343 }; /* "CCAP" */
+static const unsigned int CAPTURE_VERSION{ 1 };
+/* Array count stored for a NULL pointer. */
+static const unsigned int CAPTURE_NULL{ UINT_MAX };
+
+enum class capture_call : unsigned short {
+#define CCCAPTURE_CALL(name) name,
+#include "capture_calls.h"
+#undef CCCAPTURE_CALL
+	COUNT
+};
+
+/* Pointer argument with its element count, what gets recorded for it. */
+template <typename T>
+struct CCCaptureArray {
+	const T* data;
+	unsigned int count;
+};
+
+template <typename T>
+CCCaptureArray<T> capture_array(const T* data, size_t count)
+{
+	return CCCaptureArray<T>{ data, data ? (unsigned int)count : CAPTURE_NULL };
+}
+
+class CCCaptureWriter final {
+public:
+	explicit CCCaptureWriter(std::ostream& out_) : out(out_) {}
+
+	void bytes(const void* data, size_t size) {
+		out.write((const char*)data, size);
+	}
+
+	template <typename T>
+	void value(const T& v) {
+		bytes(&v, sizeof(T));
+	}
+
+private:
+	std::ostream& out;
+};
+
+/* Reads records from a log in memory. Arrays are copied out so they are
+ * aligned and writable; they stay valid until release.
+ */
+class CCCaptureReader final {
+public:
+	CCCaptureReader(const unsigned char* data_, size_t size_)
+		: data{ data_ }, size{ size_ }, pos{ 0 }, failed{ false }
+	{  }
+
+	bool at_end() const { return pos >= size; }
+	bool ok() const { return !failed; }
+	size_t offset() const { return pos; }
+
+	void bytes(void* dst, size_t count) {
+		if (!has(count)) {
+			memset(dst, 0, count);
+			return;
+		}
+		memcpy(dst, data + pos, count);
+		pos += count;
+	}
+
+	template <typename T>
+	T value() {
+		T v;
+		bytes(&v, sizeof(T));
+		return v;
+	}
+
+	template <typename T>
+	T* alloc(size_t count) {
+		storage.emplace_back(std::max<size_t>(count, 1) * sizeof(T));
+		return (T*)storage.back().data();
+	}
+
+	/* Whether count more bytes are left, fails the reader if not. */
+	bool has(size_t count) {
+		if (failed || count > size - pos) failed = true;
+		return !failed;
+	}
+
+	/* Copy of the next count elements, nullptr if the log is too short. */
+	template <typename T>
+	T* array(size_t count) {
+		if (failed || count > (size - pos) / sizeof(T)) {
+			failed = true;
+			return nullptr;
+		}
+		T* v = alloc<T>(count);
+		bytes(v, sizeof(T) * count);
+		return v;
+	}
+
+	/* Drop the arrays of the previous record. */
+	void release() {
+		storage.clear();
+	}
+
+private:
+	const unsigned char* data;
+	size_t size;
+	size_t pos;
+	bool failed;
+	std::vector<std::vector<unsigned char>> storage;
+};
+
+/* Storage of one parameter type: put writes the value passed to the API,
+ * get reads it back as an argument for the same parameter.
+ */
+template <typename P, typename Enable = void>
+struct CCCaptureArg {
+	static_assert(std::is_arithmetic<P>::value, "no capture format for this parameter type");
+
+	static void put(CCCaptureWriter& out, P v) { out.value(v); }
+	static P get(CCCaptureReader& in) { return in.value<P>(); }
+};
+
+template <typename P>
+struct CCCaptureArg<P, typename std::enable_if<std::is_enum<P>::value>::type> {
+	static void put(CCCaptureWriter& out, P v) { out.value((int)v); }
+	static P get(CCCaptureReader& in) { return (P)in.value<int>(); }
+};
+
+template <>
+struct CCCaptureArg<bool> {
+	static void put(CCCaptureWriter& out, bool v) { out.value((unsigned char)(v ? 1 : 0)); }
+	static bool get(CCCaptureReader& in) { return in.value<unsigned char>() != 0; }
+};
+
+template <>
+struct CCCaptureArg<const char*> {
+	static void put(CCCaptureWriter& out, const char* v) {
+		unsigned int length = v ? (unsigned int)strlen(v) : CAPTURE_NULL;
+		out.value(length);
+		if (v) out.bytes(v, length);
+	}
+	static const char* get(CCCaptureReader& in) {
+		unsigned int length = in.value<unsigned int>();
+		if (length == CAPTURE_NULL) return nullptr;
+		const char* v = in.array<char>(length);
+		if (v == nullptr) return nullptr;
+
+		char* terminated = in.alloc<char>((size_t)length + 1);
+		memcpy(terminated, v, length);
+		terminated[length] = 0;
+		return terminated;
+	}
+};
+
+template <typename T>
+struct CCCaptureArg<T*, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+	typedef typename std::remove_const<T>::type Element;
+
+	static void put(CCCaptureWriter& out, const CCCaptureArray<Element>& v) {
+		out.value(v.count);
+		if (v.count != CAPTURE_NULL) out.bytes(v.data, sizeof(Element) * v.count);
+	}
+	static T* get(CCCaptureReader& in) {
+		unsigned int count = in.value<unsigned int>();
+		if (count == CAPTURE_NULL) return nullptr;
+		return in.array<Element>(count);
+	}
+};
+
+/* Mesh descriptions with the arrays they point to. */
+template <>
+struct CCCaptureArg<cycles_mesh_desc*> {
+	static void put(CCCaptureWriter& out, const CCCaptureArray<cycles_mesh_desc>& v) {
+		out.value(v.count);
+		if (v.count == CAPTURE_NULL) return;
+		for (unsigned int i = 0; i < v.count; i++) {
+			const cycles_mesh_desc& d = v.data[i];
+			out.value(d.mesh_id);
+			out.value(d.shader_id);
+			out.value(d.smooth);
+			CCCaptureArg<float*>::put(out, capture_array(d.verts, (size_t)d.vcount * 3));
+			CCCaptureArg<int*>::put(out, capture_array(d.faces, (size_t)d.fcount * 3));
+			CCCaptureArg<float*>::put(out, capture_array(d.vnormals, (size_t)d.vnormalcount * 3));
+			CCCaptureArg<float*>::put(out, capture_array(d.uvs, (size_t)d.uvcount * 2));
+		}
+	}
+	static cycles_mesh_desc* get(CCCaptureReader& in) {
+		unsigned int count = in.value<unsigned int>();
+		if (count == CAPTURE_NULL) return nullptr;
+		/* Fields and array counts, before any array data. */
+		if (!in.has((size_t)count * 7 * sizeof(unsigned int))) return nullptr;
+
+		cycles_mesh_desc* v = in.alloc<cycles_mesh_desc>(count);
+		for (unsigned int i = 0; i < count && in.ok(); i++) {
+			cycles_mesh_desc& d = v[i];
+			d.mesh_id = in.value<unsigned int>();
+			d.shader_id = in.value<unsigned int>();
+			d.smooth = in.value<unsigned int>();
+			d.verts = get_array<float>(in, 3, d.vcount);
+			d.faces = get_array<int>(in, 3, d.fcount);
+			d.vnormals = get_array<float>(in, 3, d.vnormalcount);
+			d.uvs = get_array<float>(in, 2, d.uvcount);
+		}
+		return v;
+	}
+
+private:
+	/* Read an array of count * stride elements, set count. */
+	template <typename T>
+	static T* get_array(CCCaptureReader& in, unsigned int stride, unsigned int& count) {
+		unsigned int elements = in.value<unsigned int>();
+		count = 0;
+		if (elements == CAPTURE_NULL) return nullptr;
+
+		T* v = in.array<T>(elements);
+		if (v != nullptr) count = elements / stride;
+		return v;
+	}
+};
+
+/* Write the record for a call to f with args. */
+template <typename R, typename... P, typename... A>
+void capture_write_call(CCCaptureWriter& out, capture_call id, R(*f)(P...), const A&... args)
+{
+	static_assert(sizeof...(P) == sizeof...(A), "capture arguments don't match the API function");
+	(void)f;
+
+	out.value((unsigned short)id);
+	/* Braced lists evaluate left to right. */
+	int order[] = { 0, (CCCaptureArg<P>::put(out, args), 0)... };
+	(void)order;
+}
+
+template <typename... P, size_t... I>
+void capture_read_args(CCCaptureReader& in, std::tuple<P...>& args, std::index_sequence<I...>)
+{
+	int order[] = { 0, (std::get<I>(args) = CCCaptureArg<P>::get(in), 0)... };
+	(void)order;
+}
+
+template <typename R, typename... P, size_t... I>
+void capture_apply(R(*f)(P...), std::tuple<P...>& args, std::index_sequence<I...>)
+{
+	f(std::get<I>(args)...);
+}
+
+/* Read the arguments of a call to f from its record and make the call.
+ * Returns false without calling f if the record is cut short.
+ */
+template <typename R, typename... P>
+bool capture_replay_call(CCCaptureReader& in, R(*f)(P...))
+{
+	std::tuple<P...> args;
+	capture_read_args(in, args, std::index_sequence_for<P...>());
+	if (!in.ok()) return false;
+
+	capture_apply(f, args, std::index_sequence_for<P...>());
+	return true;
+}
+
+#endif
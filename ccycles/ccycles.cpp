@@ -22,6 +22,7 @@ limitations under the License.
 extern void _cleanup_scenes();
 extern void _cleanup_sessions();
 extern void _cleanup_shaders();
+extern void _cleanup_images();
 extern void _init_shaders();
 
 std::ostream& operator<<(std::ostream& out, shadernode_type const &snt) {
@@ -40,9 +41,11 @@ bool initialised{ false };
 Logger logger;
 
 std::vector<LOGGER_FUNC_CB> loggers;
+std::mutex loggers_mutex;
 
 void _cleanup_loggers()
 {
+	std::lock_guard<std::mutex> lock(loggers_mutex);
 	for (int i = 0; i < loggers.size(); i++) {
 		loggers[i] = nullptr;
 	}
@@ -52,11 +55,15 @@ void _cleanup_loggers()
 
 void cycles_path_init(const char* path, const char* user_path)
 {
+	CCCAPTURE(cycles_path_init, path, user_path);
+	CCTRACE_API();
 	ccl::path_init(string(path), string(user_path));
 }
 
 void cycles_initialise()
 {
+	CCCAPTURE(cycles_initialise);
+	CCTRACE_API();
 	if (!initialised) {
 		devices = ccl::Device::available_devices();
 		_init_shaders();
@@ -65,6 +72,13 @@ void cycles_initialise()
 
 void cycles_shutdown()
 {
+	CCCAPTURE(cycles_shutdown);
+	CCTRACE_API();
+	/* Flush pending messages while the callbacks are still there. */
+	logger.stop();
+	/* A running capture ends with this call. */
+	capture.stop();
+
 	if (!initialised) {
 		return;
 	}
@@ -76,20 +90,33 @@ void cycles_shutdown()
 	_cleanup_scenes();
 	_cleanup_sessions();
 	_cleanup_shaders();
+	_cleanup_images();
 }
 
 void cycles_log_to_stdout(int tostdout)
 {
+	CCTRACE_API();
 	logger.tostdout = tostdout == 1;
 }
 
+void cycles_set_log_level(unsigned int level)
+{
+	CCTRACE_API();
+	logger.set_level(level);
+}
+
 void cycles_set_logger(unsigned int client_id, LOGGER_FUNC_CB logger_func_)
 {
+	CCTRACE_API();
+	std::lock_guard<std::mutex> lock(loggers_mutex);
 	loggers[client_id] = logger_func_;
 }
 
 unsigned int cycles_new_client()
 {
+	CCCAPTURE(cycles_new_client);
+	CCTRACE_API();
+	std::lock_guard<std::mutex> lock(loggers_mutex);
 	unsigned int logfunc_count{ 0 };
 	for(auto logfunc : loggers) {
 		if (logfunc == nullptr)
@@ -105,10 +132,14 @@ unsigned int cycles_new_client()
 
 void cycles_release_client(unsigned int client_id)
 {
+	CCCAPTURE(cycles_release_client, client_id);
+	CCTRACE_API();
+	std::lock_guard<std::mutex> lock(loggers_mutex);
 	loggers[client_id] = nullptr;
 }
 
 void cycles_f4_add(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
+	CCTRACE_API();
 	ccl::float4 r = a + b;
 	res.x = r.x;
 	res.y = r.y;
@@ -117,6 +148,7 @@ void cycles_f4_add(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
 }
 
 void cycles_f4_sub(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
+	CCTRACE_API();
 	ccl::float4 r = a - b;
 	res.x = r.x;
 	res.y = r.y;
@@ -125,6 +157,7 @@ void cycles_f4_sub(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
 }
 
 void cycles_f4_mul(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
+	CCTRACE_API();
 	ccl::float4 r = a * b;
 	res.x = r.x;
 	res.y = r.y;
@@ -133,6 +166,7 @@ void cycles_f4_mul(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
 }
 
 void cycles_f4_div(ccl::float4 a, ccl::float4 b, ccl::float4& res) {
+	CCTRACE_API();
 	ccl::float4 r = a / b;
 	res.x = r.x;
 	res.y = r.y;
@@ -163,6 +197,7 @@ static void _tfm_copy(const ccl::Transform& source, ccl::Transform& target) {
 }
 
 void cycles_tfm_inverse(const ccl::Transform& t, ccl::Transform& res) {
+	CCTRACE_API();
 	ccl::Transform r = ccl::transform_inverse(t);
 
 	_tfm_copy(t, res);
@@ -170,6 +205,7 @@ void cycles_tfm_inverse(const ccl::Transform& t, ccl::Transform& res) {
 
 void cycles_tfm_rotate_around_axis(float angle, const ccl::float3& axis, ccl::Transform& res)
 {
+	CCTRACE_API();
 	ccl::Transform r = ccl::transform_rotate(angle, axis);
 
 	_tfm_copy(r, res);
@@ -177,6 +213,7 @@ void cycles_tfm_rotate_around_axis(float angle, const ccl::float3& axis, ccl::Tr
 
 void cycles_tfm_lookat(const ccl::float3& position, const ccl::float3& look, const ccl::float3& up, ccl::Transform &res)
 {
+	CCTRACE_API();
 	ccl::Transform r = ccl::transform_identity();
 	r[0][3] = position.x;
 	r[1][3] = position.y;
@@ -84,6 +84,17 @@ extern "C" {
  */
 typedef void(__cdecl *LOGGER_FUNC_CB)(const char* msg);
 
+/**
+ * Log levels, see cycles_set_log_level. Lower is more verbose.
+ * \ingroup ccycles
+ */
+#define CCYCLES_LOG_TRACE 0
+#define CCYCLES_LOG_DEBUG 1
+#define CCYCLES_LOG_INFO 2
+#define CCYCLES_LOG_WARNING 3
+#define CCYCLES_LOG_ERROR 4
+#define CCYCLES_LOG_NONE 5
+
 /**
  * Status update function signature. Used to register a status
  * update callback function with CCycles using cycles_session_set_update_callback
@@ -113,6 +124,210 @@ typedef void(__cdecl *RENDER_TILE_CB)(unsigned int session_id, unsigned int x, u
  */
 typedef void(__cdecl *DISPLAY_UPDATE_CB)(unsigned int session_id, unsigned int sample);
 
+/**
+ * Area of a session pixel buffer, in pixels. Rows are counted as laid out
+ * in the buffer returned by cycles_session_copy_buffer.
+ * \ingroup ccycles ccycles_session
+ */
+struct cycles_rect {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+/**
+ * Sampling state of one render tile, see cycles_tilemanager_get_tile_sample_info.
+ * Coordinates are as passed to the render tile callbacks.
+ * \ingroup ccycles ccycles_session
+ */
+struct cycles_tile_info {
+	int x;
+	int y;
+	int width;
+	int height;
+	/** Samples rendered so far. */
+	unsigned int samples;
+	/** Estimated relative noise, FLT_MAX until known. */
+	float error;
+	/** 1 once error got below the adaptive sampling threshold. */
+	unsigned int converged;
+};
+
+/**
+ * Geometry sharing in a scene, see cycles_scene_get_instance_stats.
+ * \ingroup ccycles ccycles_object
+ */
+struct cycles_instance_stats {
+	/** Objects in the scene. */
+	unsigned int objects;
+	/** Meshes in the scene. */
+	unsigned int meshes;
+	/** Meshes used by more than one object. */
+	unsigned int instanced_meshes;
+	/** Objects using one of the instanced meshes. */
+	unsigned int instances;
+	/** Bytes of geometry data of all meshes in use, each counted once. */
+	unsigned long long bytes_stored;
+	/** Bytes that would have been stored additionally without sharing. */
+	unsigned long long bytes_saved;
+};
+
+/**
+ * One progress event of a session, see cycles_session_poll_events.
+ * \ingroup ccycles ccycles_session
+ */
+struct cycles_session_event {
+	/** A session_event value. */
+	unsigned int type;
+	/** Tile area for TILE_DONE and TILE_UPDATE, as passed to the render tile callbacks. */
+	int x;
+	int y;
+	int width;
+	int height;
+	/** Samples per pixel at the time of the event. */
+	int sample;
+	/** Seconds since the render started. */
+	double time;
+};
+
+/**
+ * Progress of a session in one go, see cycles_session_get_progress_snapshot.
+ * \ingroup ccycles ccycles_session
+ */
+struct cycles_progress_snapshot {
+	/** Increases with each update, 0 before the first one. */
+	unsigned long long generation;
+	/** 0 to 1. */
+	float progress;
+	/** Samples per pixel done. */
+	int sample;
+	int total_samples;
+	/** Tiles done over all passes, and tiles per pass. */
+	int tiles_done;
+	int total_tiles;
+	double total_time;
+	double render_time;
+	double tile_time;
+	/** 1 when the render completed all samples. */
+	unsigned int finished;
+	/** 1 when the render got cancelled. */
+	unsigned int cancelled;
+	/** 1 when the device reported an error, status holds the message. */
+	unsigned int error;
+	/** Events dropped because the queue was full. */
+	unsigned int events_dropped;
+	char status[128];
+	char substatus[128];
+};
+
+/** Buckets in cycles_session_stats::tile_time_histogram. */
+#define CCYCLES_TILE_HISTOGRAM_SIZE 16
+
+/**
+ * Throughput and timings of a session since its last reset, see
+ * cycles_session_get_stats. Times are in seconds.
+ * \ingroup ccycles ccycles_session
+ */
+struct cycles_session_stats {
+	/** Pixel samples rendered, and per second of render time. */
+	unsigned long long pixel_samples;
+	double samples_per_second;
+	double render_time;
+	/** Tiles timed, with their mean and longest render time. */
+	unsigned int tiles;
+	double tile_time_mean;
+	double tile_time_max;
+	/**
+	 * Tile render times. Bucket i counts tiles that took less than 2^i
+	 * milliseconds and at least half that, the last bucket everything longer.
+	 */
+	unsigned int tile_time_histogram[CCYCLES_TILE_HISTOGRAM_SIZE];
+	/** Time spent copying tiles to the session buffers. */
+	double copy_time;
+	/** Part of copy_time spent waiting for the pixel buffer lock. */
+	double pixels_lock_wait;
+	/**
+	 * Time from start until rendering began, and the part of it spent
+	 * loading images, compiling shaders and updating meshes (BVH builds
+	 * included), going by the status Cycles reports.
+	 */
+	double sync_time;
+	double image_time;
+	double shader_time;
+	double mesh_time;
+	/** Device memory in use now, and the most in use at any time. */
+	unsigned long long mem_used;
+	unsigned long long mem_peak;
+};
+
+/**
+ * Session pool use, see cycles_session_pool_get_stats.
+ * \ingroup ccycles ccycles_session
+ */
+struct cycles_session_pool_stats {
+	/** Sessions created from the pool. */
+	unsigned int hits;
+	/** Sessions created from scratch. */
+	unsigned int misses;
+	/** Sessions waiting in the pool. */
+	unsigned int idle;
+	/** Average time to construct a session, in seconds. */
+	double startup_seconds;
+	/** Construction time hits avoided, in seconds. */
+	double seconds_saved;
+};
+
+/**
+ * Geometry for one mesh in a cycles_scene_add_meshes_batch call. Layouts
+ * are the same as for the single mesh calls. Set a pointer to NULL to skip
+ * that array.
+ * \ingroup ccycles ccycles_mesh
+ */
+struct cycles_mesh_desc {
+	/** Mesh to fill, or UINT_MAX to create a new mesh. Receives the new id. */
+	unsigned int mesh_id;
+	/** Shader for all triangles, also the default shader of a new mesh. */
+	unsigned int shader_id;
+	/** 1 for smooth triangles. */
+	unsigned int smooth;
+	/** x,y,z per vertex. */
+	float* verts;
+	unsigned int vcount;
+	/** Three vertex indices per triangle. */
+	int* faces;
+	unsigned int fcount;
+	/** x,y,z per vertex. */
+	float* vnormals;
+	unsigned int vnormalcount;
+	/** u,v per triangle corner. */
+	float* uvs;
+	unsigned int uvcount;
+};
+
+/**
+ * Builtin image cache use, see cycles_image_cache_get_stats.
+ * \ingroup ccycles ccycles_shader
+ */
+struct cycles_image_cache_stats {
+	/** Images in the cache. */
+	unsigned int images;
+	/** Pixel buffers held. Images with equal pixels share one. */
+	unsigned int buffers;
+	/** References shader graphs hold on cached images. */
+	unsigned int references;
+	/** Bytes of pixel data held. */
+	unsigned long long bytes_held;
+	/** Bytes that would have been held additionally without sharing pixels. */
+	unsigned long long bytes_saved;
+	/** Images set on a node that were in the cache already. */
+	unsigned int hits;
+	/** Images set on a node that had to be added. */
+	unsigned int misses;
+	/** Images freed because no shader graph held them anymore. */
+	unsigned int evictions;
+};
+
 
 /**
  * Initialise Cycles by querying available devices.
@@ -134,7 +349,8 @@ CCL_CAPI void __cdecl cycles_path_init(const char* path, const char* user_path);
 CCL_CAPI void __cdecl cycles_shutdown();
 
 /**
- * Add a logger function. This will be called only in debug builds.
+ * Add a logger function. Messages are delivered from a background thread,
+ * shortly after they were logged. Release builds only log warnings and errors.
  * \ingroup ccycles
  */
 CCL_CAPI void __cdecl cycles_set_logger(unsigned int client_id, LOGGER_FUNC_CB logger_func_);
@@ -146,6 +362,49 @@ CCL_CAPI void __cdecl cycles_set_logger(unsigned int client_id, LOGGER_FUNC_CB l
  */
 CCL_CAPI void __cdecl cycles_log_to_stdout(int tostdout);
 
+/**
+ * Only log messages of level and up, one of the CCYCLES_LOG_* values.
+ * CCYCLES_LOG_NONE turns logging off. Levels left out of the build can't
+ * be turned on.
+ *
+ * Note that this is global to the logger.
+ * \ingroup ccycles
+ */
+CCL_CAPI void __cdecl cycles_set_log_level(unsigned int level);
+
+/**
+ * Start recording a Chrome trace of API calls and render pipeline phases.
+ * Spans recorded before are dropped.
+ *
+ * Note that tracing is global to all clients and sessions.
+ * \ingroup ccycles
+ */
+CCL_CAPI void __cdecl cycles_trace_start();
+
+/**
+ * Stop recording and write the trace to path as trace event JSON, for
+ * chrome://tracing or Perfetto. Returns 1 if the file was written, 0 if not.
+ * \ingroup ccycles
+ */
+CCL_CAPI unsigned int __cdecl cycles_trace_stop(const char* path);
+
+/**
+ * Record all following API calls that change state, with their array
+ * arguments, to a binary log at path. ccycles_replay replays the log
+ * without the host application. Start capturing before creating the
+ * client so object ids in the log resolve the same on replay.
+ *
+ * Returns 1 if the log was opened, 0 if not.
+ * \ingroup ccycles
+ */
+CCL_CAPI unsigned int __cdecl cycles_capture_start(const char* path);
+
+/**
+ * Stop recording and close the log. cycles_shutdown does this too.
+ * \ingroup ccycles
+ */
+CCL_CAPI void __cdecl cycles_capture_stop();
+
 /**
  * Create a new client.
  *
@@ -230,6 +489,18 @@ CCL_CAPI unsigned int __cdecl cycles_scene_add_mesh(unsigned int client_id, unsi
  * \ingroup ccycles_scene
  */
 CCL_CAPI unsigned int __cdecl cycles_scene_add_mesh_object(unsigned int client_id, unsigned int scene_id, unsigned int object_id, unsigned int shader_id);
+/**
+ * Fill count meshes in scene_id in one call. The meshes are filled in
+ * parallel on the Cycles task scheduler, so this scales with cores rather
+ * than with the number of meshes.
+ *
+ * Entries with mesh_id UINT_MAX get a new mesh, its id is written back to
+ * the entry. A mesh may appear only once per call.
+ *
+ * Returns the number of meshes filled.
+ * \ingroup ccycles_scene
+ */
+CCL_CAPI unsigned int __cdecl cycles_scene_add_meshes_batch(unsigned int client_id, unsigned int scene_id, cycles_mesh_desc *descs, unsigned int count);
 /**
  * Create a new object for scene_id
  * \ingroup ccycles_scene
@@ -255,6 +526,25 @@ CCL_CAPI void __cdecl cycles_scene_object_set_mesh(unsigned int client_id, unsig
  * \ingroup ccycles_object
  */
 CCL_CAPI unsigned int __cdecl cycles_scene_object_get_mesh(unsigned int client_id, unsigned int scene_id, unsigned int object_id);
+/**
+ * Create a new object in scene_id that uses the existing mesh_id, with the
+ * given transformation matrix. Any number of objects can share a mesh.
+ * Its geometry is then stored, uploaded and built into a BVH once.
+ *
+ * Returns the new object id, or UINT_MAX if mesh_id doesn't exist.
+ * \ingroup ccycles_object
+ */
+CCL_CAPI unsigned int __cdecl cycles_scene_add_mesh_instance(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id,
+	float a, float b, float c, float d,
+	float e, float f, float g, float h,
+	float i, float j, float k, float l,
+	float m, float n, float o, float p
+	);
+/**
+ * Get statistics on meshes shared between objects in scene_id.
+ * \ingroup ccycles_object
+ */
+CCL_CAPI void __cdecl cycles_scene_get_instance_stats(unsigned int client_id, unsigned int scene_id, cycles_instance_stats* stats);
 /**
  * Set visibility flag for object
  * \ingroup ccycles_object
@@ -399,11 +689,55 @@ CCL_CAPI void __cdecl cycles_camera_set_fisheye_fov(unsigned int client_id, unsi
 /** Set the lens for fisheye camera. */
 CCL_CAPI void __cdecl cycles_camera_set_fisheye_lens(unsigned int client_id, unsigned int scene_id, float fisheye_lens);
 
-/** Create a new session for scene id. */
+/** Create a new session for scene id.
+ *
+ * Returns UINT_MAX if scene id isn't valid. Session, scene, shader and parameter ids are handles:
+ * once destroyed, an id is rejected by all functions even after its slot gets reused.
+ */
 CCL_CAPI unsigned int __cdecl cycles_session_create(unsigned int client_id, unsigned int session_params_id, unsigned int scene_id);
 
 /** Reset session. */
 CCL_CAPI void __cdecl cycles_session_reset(unsigned int client_id, unsigned int session_id, unsigned int width, unsigned int height, unsigned int samples);
+/**
+ * Reset session to render only the width x height region at x, y of a
+ * full_width x full_height frame. x and y count from the top-left corner.
+ * The camera should be set up for the full frame. The session buffer and
+ * tile callbacks cover just the region, with coordinates relative to it.
+ *
+ * Lets several processes each render part of one frame, put the results
+ * together with cycles_merge_region.
+ */
+CCL_CAPI void __cdecl cycles_session_reset_region(unsigned int client_id, unsigned int session_id, unsigned int full_width, unsigned int full_height, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int samples);
+/**
+ * Copy region_buffer, a width x height region rendered with
+ * cycles_session_reset_region, into full_buffer at x, y. Both buffers have
+ * stride floats per pixel, rows top to bottom.
+ */
+CCL_CAPI void __cdecl cycles_merge_region(float* full_buffer, unsigned int full_width, unsigned int full_height, const float* region_buffer, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int stride);
+
+/**
+ * Keep the raw render buffer of session: all film passes un-normalized, as
+ * Cycles accumulates them, with the sample count of each pixel. Set before
+ * cycles_session_reset.
+ *
+ * Workers rendering the same frame with different integrator seeds can
+ * export their raw buffers, add them up with cycles_merge_raw_buffers and
+ * import the sum into one session. The result matches, in expectation, one
+ * render with all samples.
+ */
+CCL_CAPI void __cdecl cycles_session_set_keep_raw_buffer(unsigned int client_id, unsigned int session_id, unsigned int keep);
+/** Get size of the raw buffer of session. Buffer size in floats is width * height * pass_stride. */
+CCL_CAPI void __cdecl cycles_session_get_raw_buffer_info(unsigned int client_id, unsigned int session_id, unsigned int* width, unsigned int* height, unsigned int* pass_stride);
+/** Copy the raw buffer of session to buffer, and the sample count of each pixel to samples (width * height). */
+CCL_CAPI void __cdecl cycles_session_copy_raw_buffer(unsigned int client_id, unsigned int session_id, float* buffer, unsigned int* samples);
+/**
+ * Replace the raw buffer of session with buffer and samples, sized as
+ * cycles_session_get_raw_buffer_info reports, and update the session buffer
+ * and pass buffers from it. Call when the session isn't rendering.
+ */
+CCL_CAPI void __cdecl cycles_session_import_raw_buffer(unsigned int client_id, unsigned int session_id, const float* buffer, const unsigned int* samples);
+/** Add raw buffer src with src_samples to dst and dst_samples. */
+CCL_CAPI void __cdecl cycles_merge_raw_buffers(float* dst, unsigned int* dst_samples, const float* src, const unsigned int* src_samples, unsigned int pixel_count, unsigned int pass_stride);
 
 /** Set the status update callback for session. */
 CCL_CAPI void __cdecl cycles_session_set_update_callback(unsigned int client_id, unsigned int session_id, void(*update)(unsigned int));
@@ -415,6 +749,15 @@ CCL_CAPI void __cdecl cycles_session_set_update_tile_callback(unsigned int clien
 CCL_CAPI void __cdecl cycles_session_set_write_tile_callback(unsigned int client_id, unsigned int session_id, RENDER_TILE_CB write_tile_cb);
 /** Set the display update callback for session. */
 CCL_CAPI void __cdecl cycles_session_set_display_update_callback(unsigned int client_id, unsigned int session_id, DISPLAY_UPDATE_CB display_update_cb);
+/**
+ * Call the status, render tile and display update callbacks of session from
+ * a separate thread, at most rate times per second, instead of from the
+ * render threads. Notifications in between get coalesced: for each tile
+ * only the latest one is delivered, display and status updates once.
+ * cycles_session_wait returns only after everything got delivered.
+ * 0, the default, calls the callbacks directly.
+ */
+CCL_CAPI void __cdecl cycles_session_set_callback_rate(unsigned int client_id, unsigned int session_id, float rate);
 /** Cancel session with cancel_message for log. */
 CCL_CAPI void __cdecl cycles_session_cancel(unsigned int client_id, unsigned int session_id, const char *cancel_message);
 /** Start given session render process. */
@@ -425,25 +768,152 @@ CCL_CAPI void __cdecl cycles_session_wait(unsigned int client_id, unsigned int s
 CCL_CAPI void __cdecl cycles_session_set_pause(unsigned int client_id, unsigned int session_id, bool pause);
 /** Set session samples to render. */
 CCL_CAPI void __cdecl cycles_session_set_samples(unsigned int client_id, unsigned int session_id, int samples);
-/** Clear resources for session. */
+/** Enable adaptive sampling for session.
+ *
+ * A tile counts as converged once its estimated relative noise is below
+ * threshold and it has at least min_samples. When all tiles have converged
+ * the render ends, even if fewer samples were rendered than requested.
+ * Tiles are rendered in sample passes over the whole image, so this works
+ * with progressive rendering and progressive refine. Converged tiles keep
+ * being sampled until the whole image is done.
+ *
+ * A threshold of 0 disables adaptive sampling, that is the default.
+ */
+CCL_CAPI void __cdecl cycles_session_set_adaptive_sampling(unsigned int client_id, unsigned int session_id, float threshold, unsigned int min_samples);
+/** Clear resources for session. This also releases the id of the scene the session rendered. */
 CCL_CAPI void __cdecl cycles_session_destroy(unsigned int client_id, unsigned int session_id);
-/** Copy pixel data of session. */
-CCL_CAPI void __cdecl cycles_session_copy_buffer(unsigned int client_id, unsigned int session_id, float* pixel_buffer);
+
+/**
+ * Keep up to capacity destroyed sessions per device for reuse, 0 (the
+ * default) to not keep any. A pooled session keeps its device and threads,
+ * cycles_session_create hands it out again for session parameters that
+ * match the ones it was created with.
+ */
+CCL_CAPI void __cdecl cycles_session_pool_set_capacity(unsigned int client_id, unsigned int capacity);
+/** Create count sessions for session_params up front and put them in the pool, no more than it has room for. Returns the number created. */
+CCL_CAPI unsigned int __cdecl cycles_session_pool_prewarm(unsigned int client_id, unsigned int session_params_id, unsigned int count);
+/** Destroy all sessions in the pool. */
+CCL_CAPI void __cdecl cycles_session_pool_clear(unsigned int client_id);
+/** Get session pool hit rate and startup time saved. */
+CCL_CAPI void __cdecl cycles_session_pool_get_stats(unsigned int client_id, cycles_session_pool_stats* stats);
+/** Kinds of cycles_session_event. */
+enum class session_event : unsigned int {
+	/** A finished tile got copied to the session buffer. */
+	TILE_DONE = 0,
+	/** All pixels got another pass of samples. */
+	SAMPLE_DONE,
+	/** Status or substatus text changed. */
+	STATUS_CHANGED,
+	/** The render completed all samples. */
+	FINISHED,
+	/** The device reported an error, see the snapshot for the message. */
+	DEVICE_ERROR,
+	/** A tile still being rendered got its progress so far copied to the session buffer. */
+	TILE_UPDATE
+};
+
+/** Get throughput and timing statistics of session. */
+CCL_CAPI void __cdecl cycles_session_get_stats(unsigned int client_id, unsigned int session_id, cycles_session_stats* stats);
+
+/**
+ * Get up to max_events events of session that happened since the last
+ * call, oldest first. Returns the number written to events. Events are
+ * queued without locks, when the queue fills up new events are dropped
+ * and counted in cycles_progress_snapshot::events_dropped.
+ */
+CCL_CAPI unsigned int __cdecl cycles_session_poll_events(unsigned int client_id, unsigned int session_id, cycles_session_event* events, unsigned int max_events);
+/**
+ * Fill snapshot with the progress of session as of the latest update.
+ * Doesn't take any lock, meant to be called once per frame from UI threads
+ * in place of the individual progress getters.
+ */
+CCL_CAPI void __cdecl cycles_session_get_progress_snapshot(unsigned int client_id, unsigned int session_id, cycles_progress_snapshot* snapshot);
+
+/** Formats the pixel data of a session can be copied in. */
+enum class buffer_format : unsigned int {
+	/** 32-bit float RGBA, the default. */
+	FLOAT = 0,
+	/** 16-bit half float RGBA. */
+	HALF,
+	/** 8-bit RGBA, RGB sRGB encoded, alpha linear. */
+	RGBA8_SRGB
+};
+
+/** Set the format cycles_session_copy_buffer and cycles_session_copy_dirty_regions write pixel data in.
+ *
+ * Conversion happens once per tile as it arrives. cycles_session_get_buffer_info sizes are in
+ * components, one component is 4 bytes for FLOAT, 2 for HALF and 1 for RGBA8_SRGB.
+ */
+CCL_CAPI void __cdecl cycles_session_set_buffer_format(unsigned int client_id, unsigned int session_id, buffer_format format);
+/** Copy pixel data of session.
+ *
+ * This copies the most recently published complete frame. It doesn't wait for
+ * render threads, and never returns a partially written tile. Pixel data is in
+ * the format set with cycles_session_set_buffer_format.
+ */
+CCL_CAPI void __cdecl cycles_session_copy_buffer(unsigned int client_id, unsigned int session_id, void* pixel_buffer);
+/** Copy pixel data of session like cycles_session_copy_buffer, if pixel_buffer is buffer_bytes long.
+ *
+ * Return 1 when copied, 0 when buffer_bytes doesn't match the size of the buffer in the format
+ * the session is set to. Nothing gets written then.
+ */
+CCL_CAPI unsigned int __cdecl cycles_session_copy_buffer_sized(unsigned int client_id, unsigned int session_id, void* pixel_buffer, unsigned long long buffer_bytes);
+/** Copy only the pixel data of session that changed since the previous copy.
+ *
+ * pixel_buffer is the full size buffer previously filled by cycles_session_copy_buffer or
+ * cycles_session_copy_dirty_regions. Only the changed areas are written, and reported
+ * in rects. When more than max_rects areas changed they are merged into their bounding box.
+ * The first call after a reset reports the complete buffer.
+ *
+ * Returns the number of rects written, 0 when nothing changed.
+ */
+CCL_CAPI int __cdecl cycles_session_copy_dirty_regions(unsigned int client_id, unsigned int session_id, void* pixel_buffer, cycles_rect* rects, int max_rects);
+/** Get the generation of the most recently published frame of session.
+ *
+ * The generation increases with each published update, and is 0 when nothing has been
+ * rendered yet. Use it to skip cycles_session_copy_buffer when nothing changed.
+ */
+CCL_CAPI unsigned long long __cdecl cycles_session_get_buffer_generation(unsigned int client_id, unsigned int session_id);
 /** Get pixel data buffer information of session. */
 CCL_CAPI void __cdecl cycles_session_get_buffer_info(unsigned int client_id, unsigned int session_id, unsigned int* buffer_size, unsigned int* buffer_stride);
 CCL_CAPI void __cdecl cycles_session_draw(unsigned int client_id, unsigned int session_id, int width, int height);
 CCL_CAPI void __cdecl cycles_session_draw_nogl(unsigned int client_id, unsigned int session_id, int width, int height, bool isgpu);
 /** A (temporary) function to ensure we can draw into a Rhino viewport. */
 CCL_CAPI void __cdecl cycles_session_rhinodraw(unsigned int client_id, unsigned int session_id, int width, int height);
-/** Get pixel data buffer pointer. */
+/** Get pixel data buffer pointer.
+ *
+ * Note that this is the buffer render threads write into. Access to it isn't synchronised,
+ * use cycles_session_copy_buffer to get a consistent frame.
+ */
 CCL_CAPI float* __cdecl cycles_session_get_buffer(unsigned int client_id, unsigned int session_id);
 
+/**
+ * Register an additional render pass (AOV) for session. pass_type is a ccl::PassType.
+ *
+ * The pass is added to the film of the session scene and gets its own pixel buffer,
+ * filled from the same render tiles as the combined pass. Add passes before
+ * cycles_session_reset and cycles_session_start.
+ * \ingroup ccycles_session
+ */
+CCL_CAPI void __cdecl cycles_session_add_pass(unsigned int client_id, unsigned int session_id, unsigned int pass_type);
+/** Get pixel data buffer information for pass_type of session. Size and stride are 0 if pass isn't registered. */
+CCL_CAPI void __cdecl cycles_session_get_pass_buffer_info(unsigned int client_id, unsigned int session_id, unsigned int pass_type, unsigned int* buffer_size, unsigned int* buffer_stride);
+/** Get pixel data buffer pointer for pass_type of session. */
+CCL_CAPI float* __cdecl cycles_session_get_pass_buffer(unsigned int client_id, unsigned int session_id, unsigned int pass_type);
+/** Copy pixel data of pass_type of session. */
+CCL_CAPI void __cdecl cycles_session_copy_pass_buffer(unsigned int client_id, unsigned int session_id, unsigned int pass_type, float* pixel_buffer);
+
 
 /* session progress access. */
 CCL_CAPI void __cdecl cycles_progress_reset(unsigned int client_id, unsigned int session_id);
 CCL_CAPI int __cdecl cycles_progress_get_sample(unsigned int client_id, unsigned int session_id);
 CCL_CAPI void __cdecl cycles_progress_get_tile(unsigned int client_id, unsigned int session_id, int* tile, double* total_time, double* sample_time, double* tile_time);
 CCL_CAPI void __cdecl cycles_tilemanager_get_sample_info(unsigned int client_id, unsigned int session_id, unsigned int* samples, unsigned int* total_samples);
+/**
+ * Get per-tile sample counts and convergence state of session. Writes up
+ * to max_tiles entries to tiles and returns the number written.
+ */
+CCL_CAPI unsigned int __cdecl cycles_tilemanager_get_tile_sample_info(unsigned int client_id, unsigned int session_id, cycles_tile_info* tiles, unsigned int max_tiles);
 CCL_CAPI void __cdecl cycles_progress_get_progress(unsigned int client_id, unsigned int session_id, float* progress, double* total_time, double* render_time, double* tile_time);
 CCL_CAPI const char* __cdecl cycles_progress_get_status(unsigned int client_id, unsigned int session_id);
 CCL_CAPI const char* __cdecl cycles_progress_get_substatus(unsigned int client_id, unsigned int session_id);
@@ -467,9 +937,23 @@ CCL_CAPI void __cdecl cycles_session_params_set_cancel_timeout(unsigned int clie
 CCL_CAPI void __cdecl cycles_session_params_set_reset_timeout(unsigned int client_id, unsigned int session_params_id, double reset_timeout);
 CCL_CAPI void __cdecl cycles_session_params_set_text_timeout(unsigned int client_id, unsigned int session_params_id, double text_timeout);
 CCL_CAPI void __cdecl cycles_session_params_set_shadingsystem(unsigned int client_id, unsigned int session_params_id, unsigned int shadingsystem);
+/**
+ * Give sessions created with session_params a wall clock budget of time_limit
+ * seconds, 0 for none. The session renders with progressive refine and picks
+ * the largest sample count, up to the requested samples, that fits the budget
+ * based on the time the passes so far took. Every pass covers the whole frame,
+ * so the result is evenly sampled when the budget runs out.
+ */
+CCL_CAPI void __cdecl cycles_session_params_set_time_limit(unsigned int client_id, unsigned int session_params_id, double time_limit);
 
 /* Create a new scene for specified device. */
 CCL_CAPI unsigned int __cdecl cycles_scene_create(unsigned int client_id, unsigned int scene_params_id, unsigned int device_id);
+/**
+ * Free a scene no session was created for. A scene handed to
+ * cycles_session_create goes with cycles_session_destroy instead, for such
+ * a scene this does nothing.
+ */
+CCL_CAPI void __cdecl cycles_scene_destroy(unsigned int client_id, unsigned int scene_id);
 CCL_CAPI void __cdecl cycles_scene_set_background_shader(unsigned int client_id, unsigned int scene_id, unsigned int shader_id);
 CCL_CAPI unsigned int __cdecl cycles_scene_get_background_shader(unsigned int client_id, unsigned int scene_id);
 CCL_CAPI void __cdecl cycles_scene_set_background_ao_factor(unsigned int client_id, unsigned int scene_id, float ao_factor);
@@ -479,10 +963,36 @@ CCL_CAPI void __cdecl cycles_scene_reset(unsigned int client_id, unsigned int sc
 CCL_CAPI bool __cdecl cycles_scene_try_lock(unsigned int client_id, unsigned int scene_id);
 CCL_CAPI void __cdecl cycles_scene_lock(unsigned int client_id, unsigned int scene_id);
 CCL_CAPI void __cdecl cycles_scene_unlock(unsigned int client_id, unsigned int scene_id);
+/**
+ * Load the scene XML file at path into scene_id, in the format csycles_tester
+ * reads: camera, integrator, background, shaders, meshes, objects, lights and
+ * includes. The file is read in a single pass and mesh data is parsed straight
+ * into the Cycles meshes. Meshes get ids in document order, following the
+ * meshes already in the scene.
+ *
+ * Return 1 on success, 0 on failure. Parts read before a failure stay in the
+ * scene.
+ * \ingroup ccycles_scene
+ */
+CCL_CAPI unsigned int __cdecl cycles_scene_load_xml(unsigned int client_id, unsigned int scene_id, const char* path);
 
 /* Mesh geometry API */
 CCL_CAPI void __cdecl cycles_mesh_set_verts(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *verts, unsigned int vcount);
 CCL_CAPI void __cdecl cycles_mesh_set_tris(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, int *faces, unsigned int fcount, unsigned int shader_id, unsigned int smooth);
+/**
+ * Append vcount vertices given as x,y,z,w quadruplets. The w component is
+ * ignored. This matches the in-memory layout Cycles uses, so the vertices
+ * are copied in one go.
+ * \ingroup ccycles_mesh
+ */
+CCL_CAPI void __cdecl cycles_mesh_set_verts_float4(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *verts, unsigned int vcount);
+/**
+ * Append fcount triangles, each with its own shader and smooth flag.
+ * shader_ids needs fcount entries. smooth needs fcount entries, or can be
+ * NULL for all flat faces.
+ * \ingroup ccycles_mesh
+ */
+CCL_CAPI void __cdecl cycles_mesh_set_tris_bulk(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, int *faces, unsigned int fcount, unsigned int *shader_ids, unsigned char *smooth);
 CCL_CAPI void __cdecl cycles_mesh_add_triangle(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, unsigned int v0, unsigned int v1, unsigned int v2, unsigned int shader_id, unsigned int smooth);
 CCL_CAPI void __cdecl cycles_mesh_set_uvs(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *uvs, unsigned int uvcount);
 CCL_CAPI void __cdecl cycles_mesh_set_vertex_normals(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *vnormals, unsigned int vnormalcount);
@@ -490,6 +1000,29 @@ CCL_CAPI void __cdecl cycles_mesh_set_smooth(unsigned int client_id, unsigned in
 CCL_CAPI void __cdecl cycles_mesh_clear(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id);
 CCL_CAPI void __cdecl cycles_mesh_tag_rebuild(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id);
 CCL_CAPI void __cdecl cycles_mesh_set_shader(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, unsigned int shader_id);
+/**
+ * Replace the geometry of mesh_id with the binary mesh file at path, as
+ * written by cycles_mesh_save_binary. The file is memory mapped and copied
+ * into the mesh one array at a time.
+ *
+ * Shader ids in the file are scene shader ids, so the scene has to add its
+ * shaders in the same order as the scene the file was written from. Files
+ * using a shader id the scene doesn't have are rejected.
+ *
+ * Return 1 on success, 0 on failure. The mesh is left unchanged when the
+ * file can't be read or doesn't check out.
+ * \ingroup ccycles_mesh
+ */
+CCL_CAPI unsigned int __cdecl cycles_mesh_load_binary(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, const char* path);
+/**
+ * Write verts, triangles, shaders, smooth flags, vertex normals and UVs of
+ * mesh_id to path for cycles_mesh_load_binary. See mesh_cache_format.h for
+ * the layout.
+ *
+ * Return 1 on success, 0 on failure.
+ * \ingroup ccycles_mesh
+ */
+CCL_CAPI unsigned int __cdecl cycles_mesh_save_binary(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, const char* path);
 
 /* Shader API */
 
@@ -591,6 +1124,13 @@ CCL_CAPI void __cdecl cycles_shadernode_set_member_vec4_at_index(unsigned int cl
 
 CCL_CAPI void __cdecl cycles_shadernode_set_member_float_img(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, const char* img_name, float* img, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels);
 CCL_CAPI void __cdecl cycles_shadernode_set_member_byte_img(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, const char* img_name, unsigned char* img, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels);
+/**
+ * Get the size and hit rate of the builtin image cache. Images set with the
+ * set_member_*_img calls are shared by name and pixel content, and freed
+ * once the shader graphs they were set in are replaced or freed.
+ * \ingroup ccycles_shader
+ */
+CCL_CAPI void __cdecl cycles_image_cache_get_stats(unsigned int client_id, cycles_image_cache_stats* stats);
 
 CCL_CAPI void __cdecl cycles_shader_set_name(unsigned int client_id, unsigned int shader_id, const char* name);
 CCL_CAPI void __cdecl cycles_shader_set_use_mis(unsigned int client_id, unsigned int shader_id, unsigned int use_mis);
@@ -598,7 +1138,7 @@ CCL_CAPI void __cdecl cycles_shader_set_use_transparent_shadow(unsigned int clie
 CCL_CAPI void __cdecl cycles_shader_set_heterogeneous_volume(unsigned int client_id, unsigned int shader_id, unsigned int heterogeneous_volume);
 CCL_CAPI void __cdecl cycles_shader_new_graph(unsigned int client_id, unsigned int shader_id);
 
-CCL_CAPI void __cdecl cycles_shader_connect_nodes(unsigned int client_id, unsigned int shader_id, unsigned int from_id, const std::string from, unsigned int to_id, const std::string to);
+CCL_CAPI void __cdecl cycles_shader_connect_nodes(unsigned int client_id, unsigned int shader_id, unsigned int from_id, const char* from, unsigned int to_id, const char* to);
 
 /***** LIGHTS ****/
 
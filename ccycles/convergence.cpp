@@ -0,0 +1,130 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <cmath>
+
+#include "internal_types.h"
+
+/* Keeps dark pixels from dominating the relative error. */
+static const float ERROR_EPSILON{ 1e-4f };
+
+static inline float luminance(const float* rgba)
+{
+	return 0.2126f * rgba[0] + 0.7152f * rgba[1] + 0.0722f * rgba[2];
+}
+
+void CCConvergence::set_params(float threshold_, int min_samples_)
+{
+	ccl::thread_scoped_lock lock(mutex);
+
+	threshold = threshold_;
+	min_samples = min_samples_;
+}
+
+void CCConvergence::reset(int width_, int height_)
+{
+	ccl::thread_scoped_lock lock(mutex);
+
+	width = width_;
+	height = height_;
+	tiles.clear();
+	converged_pixels = 0;
+	all_converged = false;
+}
+
+bool CCConvergence::update(const float* tile_pixels, int tilex, int tiley, int tile_width, int tile_height, int samples)
+{
+	ccl::thread_scoped_lock lock(mutex);
+
+	if (tilex + tile_width > width || tiley + tile_height > height) {
+		return false;
+	}
+
+	CCTileConvergence& tile = tiles[(size_t)tiley * width + tilex];
+	size_t pixel_count = (size_t)tile_width * tile_height;
+
+	if (tile.width != tile_width || tile.height != tile_height) {
+		/* New tile, or the same origin with a different size. */
+		if (tile.converged) converged_pixels -= (size_t)tile.width * tile.height;
+		tile = CCTileConvergence{};
+		tile.x = tilex;
+		tile.y = tiley;
+		tile.width = tile_width;
+		tile.height = tile_height;
+	}
+
+	tile.samples = samples;
+
+	if (threshold <= 0.0f || tile.converged) {
+		return false;
+	}
+
+	if (tile.checkpoint == 0 || samples < tile.checkpoint) {
+		tile.reference.resize(pixel_count);
+		for (size_t i = 0; i < pixel_count; i++) {
+			tile.reference[i] = luminance(&tile_pixels[i * 4]);
+		}
+		tile.checkpoint = samples;
+		return false;
+	}
+
+	if (samples < tile.checkpoint * 2) {
+		return false;
+	}
+
+	double error_sum{ 0.0 };
+	for (size_t i = 0; i < pixel_count; i++) {
+		float l = luminance(&tile_pixels[i * 4]);
+		error_sum += fabsf(l - tile.reference[i]) / sqrtf(fmaxf(l, 0.0f) + ERROR_EPSILON);
+		tile.reference[i] = l;
+	}
+	tile.error = (float)(error_sum / pixel_count);
+	tile.checkpoint = samples;
+
+	if (tile.error < threshold && samples >= min_samples) {
+		tile.converged = true;
+		converged_pixels += pixel_count;
+	}
+
+	if (!all_converged && converged_pixels >= (size_t)width * height) {
+		all_converged = true;
+		return true;
+	}
+
+	return false;
+}
+
+unsigned int CCConvergence::get_tiles(cycles_tile_info* out, unsigned int max_tiles)
+{
+	ccl::thread_scoped_lock lock(mutex);
+
+	unsigned int count{ 0 };
+	for (const auto& it : tiles) {
+		if (count == max_tiles) break;
+
+		const CCTileConvergence& tile = it.second;
+		cycles_tile_info& info = out[count++];
+		info.x = tile.x;
+		info.y = tile.y;
+		info.width = tile.width;
+		info.height = tile.height;
+		info.samples = (unsigned int)tile.samples;
+		info.error = tile.error;
+		info.converged = tile.converged ? 1 : 0;
+	}
+
+	return count;
+}
@@ -19,10 +19,12 @@ limitations under the License.
 extern std::vector<ccl::DeviceInfo> devices;
 
 unsigned int cycles_number_devices() {
+	CCTRACE_API();
 	return (unsigned int)devices.size();
 }
 
 unsigned int cycles_number_cuda_devices() {
+	CCTRACE_API();
 	int i{ 0 };
 	for (ccl::DeviceInfo di : devices) {
 		if (di.type == ccl::DeviceType::DEVICE_CUDA) i++;
@@ -32,6 +34,7 @@ unsigned int cycles_number_cuda_devices() {
 }
 
 const char *cycles_device_description(int i) {
+	CCTRACE_API();
 	if (i>= 0 && i < devices.size())
 		return devices[i].description.c_str();
 	else
@@ -39,6 +42,7 @@ const char *cycles_device_description(int i) {
 }
 
 const char *cycles_device_id(int i) {
+	CCTRACE_API();
 	if (i >= 0 && i < devices.size())
 		return devices[i].id.c_str();
 	else
@@ -46,6 +50,7 @@ const char *cycles_device_id(int i) {
 }
 
 int cycles_device_num(int i) {
+	CCTRACE_API();
 	if (i >= 0 && i < devices.size())
 		return devices[i].num;
 	else
@@ -53,6 +58,7 @@ int cycles_device_num(int i) {
 }
 
 unsigned int cycles_device_advanced_shading(int i) {
+	CCTRACE_API();
 	if (i >= 0 && i < devices.size())
 		return devices[i].advanced_shading;
 	else
@@ -60,6 +66,7 @@ unsigned int cycles_device_advanced_shading(int i) {
 }
 
 unsigned int cycles_device_display_device(int i) {
+	CCTRACE_API();
 	if (i >= 0 && i < devices.size())
 		return devices[i].display_device;
 	else
@@ -67,6 +74,7 @@ unsigned int cycles_device_display_device(int i) {
 }
 
 unsigned int cycles_device_pack_images(int i) {
+	CCTRACE_API();
 	if (i >= 0 && i < devices.size())
 		return devices[i].pack_images;
 	else
@@ -74,6 +82,7 @@ unsigned int cycles_device_pack_images(int i) {
 }
 
 unsigned int cycles_device_type(int i) {
+	CCTRACE_API();
 	if (i >= 0 && i < devices.size())
 		return devices[i].type;
 	else
@@ -82,6 +91,7 @@ unsigned int cycles_device_type(int i) {
 
 
 const char* cycles_device_capabilities() {
+	CCTRACE_API();
 	static string capabilities = ccl::Device::device_capabilities();
 	return capabilities.c_str();
 }
\ No newline at end of file
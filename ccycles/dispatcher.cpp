@@ -0,0 +1,185 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+
+#include "internal_types.h"
+
+/* On a dispatcher thread, set once stop() was called from one of its own
+ * callbacks. It lives on the thread's stack, so run() can still read it
+ * after the dispatcher itself was destroyed.
+ */
+static thread_local bool* dispatcher_abandoned = nullptr;
+
+void CCDispatcher::set_rate(float rate)
+{
+	if (rate <= 0.0f) {
+		stop();
+		return;
+	}
+
+	std::lock_guard<std::mutex> control_lock(control_mutex);
+	std::lock_guard<std::mutex> lock(mutex);
+	interval = std::chrono::duration<double>(1.0 / rate);
+	if (!running) {
+		stopping = false;
+		running = true;
+		thread = std::thread(&CCDispatcher::run, this);
+	}
+}
+
+bool CCDispatcher::post_tile(const CCTileNotification& tile)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!running) return false;
+
+	unsigned long long key = ((unsigned long long)tile.write << 62) | ((unsigned long long)(unsigned int)tile.y << 31) | (unsigned int)tile.x;
+	tiles[key] = tile;
+	wakeup.notify_one();
+	return true;
+}
+
+bool CCDispatcher::post_display(int sample)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!running) return false;
+
+	display_sample = std::max(display_sample, sample);
+	wakeup.notify_one();
+	return true;
+}
+
+bool CCDispatcher::post_status()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!running) return false;
+
+	status = true;
+	wakeup.notify_one();
+	return true;
+}
+
+void CCDispatcher::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!running) return;
+
+	flushing = true;
+	wakeup.notify_one();
+	idle.wait(lock, [this] { return !running || (!pending() && !delivering); });
+	flushing = false;
+}
+
+void CCDispatcher::stop()
+{
+	std::lock_guard<std::mutex> control_lock(control_mutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!running) return;
+		/* Posts from now on go straight to the client, the thread delivers
+		 * what's already pending before it ends.
+		 */
+		running = false;
+		stopping = true;
+		wakeup.notify_one();
+		idle.notify_all();
+
+		/* A callback stopping the dispatcher, usually by destroying its
+		 * session, runs on the thread itself and can't join it. Leave the
+		 * thread to end on its own without touching the dispatcher again,
+		 * dropping what's still pending.
+		 */
+		if (std::this_thread::get_id() == thread.get_id()) {
+			*dispatcher_abandoned = true;
+			delivering = false;
+			thread.detach();
+			return;
+		}
+	}
+
+	thread.join();
+}
+
+bool CCDispatcher::pending() const
+{
+	return status || display_sample >= 0 || !tiles.empty();
+}
+
+void CCDispatcher::run()
+{
+	bool abandoned{ false };
+	dispatcher_abandoned = &abandoned;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	auto next = std::chrono::steady_clock::now();
+
+	while (!stopping) {
+		wakeup.wait(lock, [this] { return stopping || pending(); });
+
+		/* Hold back until the next delivery is due, letting more
+		 * notifications pile up and coalesce. A flush doesn't wait.
+		 */
+		if (!stopping && !flushing) {
+			wakeup.wait_until(lock, next, [this] { return stopping || flushing; });
+		}
+
+		if (!deliver(lock)) return;
+		next = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+	}
+
+	deliver(lock);
+}
+
+bool CCDispatcher::deliver(std::unique_lock<std::mutex>& lock)
+{
+	std::map<unsigned long long, CCTileNotification> tiles_;
+	tiles_.swap(tiles);
+	int sample = display_sample;
+	display_sample = -1;
+	bool status_ = status;
+	status = false;
+
+	delivering = true;
+	lock.unlock();
+
+	/* Callbacks are read now, the client may have changed them since. */
+	if (status_ && owner->status_cb != nullptr) {
+		CCTRACE("callback", "status_cb");
+		owner->status_cb(owner->id);
+		if (*dispatcher_abandoned) return false;
+	}
+
+	for (auto& it : tiles_) {
+		const CCTileNotification& t = it.second;
+		RENDER_TILE_CB cb = t.write ? owner->write_tile_cb : owner->update_tile_cb;
+		if (cb != nullptr) {
+			CCTRACE("callback", t.write ? "write_tile_cb" : "update_tile_cb");
+			cb(owner->id, t.x, t.y, t.width, t.height, 4, t.start_sample, t.num_samples, t.sample, t.resolution);
+			if (*dispatcher_abandoned) return false;
+		}
+	}
+
+	if (sample >= 0 && owner->display_update_cb != nullptr) {
+		CCTRACE("callback", "display_update_cb");
+		owner->display_update_cb(owner->id, sample);
+		if (*dispatcher_abandoned) return false;
+	}
+
+	lock.lock();
+	delivering = false;
+	idle.notify_all();
+	return true;
+}
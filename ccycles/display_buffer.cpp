@@ -0,0 +1,221 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+
+#include "internal_types.h"
+
+CCDisplayBuffer::~CCDisplayBuffer()
+{
+	for (int i = 0; i < 3; i++) {
+		delete[] slots[i];
+	}
+}
+
+void CCDisplayBuffer::reset(int width_, int height_, unsigned int pixel_size_)
+{
+	ccl::thread_scoped_lock reader_lock(reader_mutex);
+
+	size_t size = (size_t)(width_ * height_) * pixel_size_;
+	for (int i = 0; i < 3; i++) {
+		if (size != buffer_bytes) {
+			delete[] slots[i];
+			slots[i] = new unsigned char[size];
+		}
+		memset(slots[i], 0, size);
+		slot_generation[i] = 0;
+		pending[i].clear();
+		pending_full[i] = true;
+	}
+
+	buffer_bytes = size;
+	width = width_;
+	height = height_;
+	pixel_size = pixel_size_;
+
+	unpublished.clear();
+	unpublished_full = true;
+	{
+		ccl::thread_scoped_lock unread_lock(unread_mutex);
+		unread.clear();
+		unread_full = true;
+	}
+
+	back = 0;
+	front = 1;
+	middle.store(2);
+}
+
+void CCDisplayBuffer::add_rect(std::vector<CCRect>& rects, bool& full, const CCRect& rect)
+{
+	if (full) return;
+
+	/* Tiles get updated several times while rendering, don't record the
+	 * same area twice.
+	 */
+	for (const CCRect& r : rects) {
+		if (r.x == rect.x && r.y == rect.y && r.width == rect.width && r.height == rect.height) return;
+	}
+
+	if (rects.size() >= MAX_PENDING_RECTS) {
+		rects.clear();
+		full = true;
+	}
+	else {
+		rects.push_back(rect);
+	}
+}
+
+void CCDisplayBuffer::copy_rect(unsigned char* dst, const unsigned char* src, const CCRect& rect) const
+{
+	const size_t row_size = (size_t)rect.width * pixel_size;
+	for (int y = rect.y; y < rect.y + rect.height; y++) {
+		size_t idx = ((size_t)y * width + rect.x) * pixel_size;
+		memcpy(&dst[idx], &src[idx], row_size);
+	}
+}
+
+void CCDisplayBuffer::mark_dirty(const CCRect& rect)
+{
+	for (int i = 0; i < 3; i++) {
+		add_rect(pending[i], pending_full[i], rect);
+	}
+	add_rect(unpublished, unpublished_full, rect);
+}
+
+void CCDisplayBuffer::mark_all_dirty()
+{
+	for (int i = 0; i < 3; i++) {
+		pending[i].clear();
+		pending_full[i] = true;
+	}
+	unpublished.clear();
+	unpublished_full = true;
+}
+
+void CCDisplayBuffer::publish(const unsigned char* src)
+{
+	unsigned char* dst = slots[back];
+	if (dst == nullptr || src == nullptr) return;
+
+	if (pending_full[back]) {
+		memcpy(dst, src, buffer_bytes);
+	}
+	else {
+		for (const CCRect& rect : pending[back]) {
+			copy_rect(dst, src, rect);
+		}
+	}
+	pending[back].clear();
+	pending_full[back] = false;
+
+	/* Only the writer changes generation, and writers are serialised by
+	 * CCSession::pixels_mutex.
+	 */
+	unsigned long long frame_generation = generation.load() + 1;
+	slot_generation[back] = frame_generation;
+
+	back = middle.exchange(back | FRESH) & 3;
+	generation.store(frame_generation);
+
+	/* Hand the areas to readers only once the frame holding them is
+	 * published, so a reader taking them always acquires that frame or a
+	 * later one.
+	 */
+	{
+		ccl::thread_scoped_lock unread_lock(unread_mutex);
+		if (unpublished_full) {
+			unread.clear();
+			unread_full = true;
+		}
+		else {
+			for (const CCRect& rect : unpublished) {
+				add_rect(unread, unread_full, rect);
+			}
+		}
+	}
+	unpublished.clear();
+	unpublished_full = false;
+}
+
+const unsigned char* CCDisplayBuffer::acquire(unsigned long long& frame_generation)
+{
+	if (middle.load() & FRESH) {
+		front = middle.exchange(front) & 3;
+	}
+
+	frame_generation = slot_generation[front];
+	return slots[front];
+}
+
+int CCDisplayBuffer::copy_dirty(void* dst, CCRect* rects, int max_rects, unsigned long long& frame_generation)
+{
+	std::vector<CCRect> dirty;
+	bool dirty_full{ false };
+
+	/* Take the dirty areas before acquiring. publish adds areas only after
+	 * their frame is out, so the frame acquired below holds all of them. A
+	 * frame published in between leaves its areas for the next call, so at
+	 * worst we copy an area twice but never miss one.
+	 */
+	{
+		ccl::thread_scoped_lock unread_lock(unread_mutex);
+		dirty.swap(unread);
+		dirty_full = unread_full;
+		unread_full = false;
+	}
+
+	const unsigned char* frame = acquire(frame_generation);
+	if (frame == nullptr || max_rects < 1) return 0;
+
+	if (dirty_full) {
+		dirty.clear();
+		dirty.push_back(CCRect{ 0, 0, width, height });
+	}
+	else if (dirty.size() > (size_t)max_rects) {
+		int x0 = width, y0 = height, x1 = 0, y1 = 0;
+		for (const CCRect& rect : dirty) {
+			x0 = std::min(x0, rect.x);
+			y0 = std::min(y0, rect.y);
+			x1 = std::max(x1, rect.x + rect.width);
+			y1 = std::max(y1, rect.y + rect.height);
+		}
+		dirty.clear();
+		dirty.push_back(CCRect{ x0, y0, x1 - x0, y1 - y0 });
+	}
+
+	int count{ 0 };
+	for (const CCRect& rect : dirty) {
+		copy_rect((unsigned char*)dst, frame, rect);
+		rects[count++] = rect;
+	}
+
+	return count;
+}
+
+void CCDisplayBuffer::copy_all(void* dst, unsigned long long& frame_generation)
+{
+	{
+		ccl::thread_scoped_lock unread_lock(unread_mutex);
+		unread.clear();
+		unread_full = false;
+	}
+
+	const unsigned char* frame = acquire(frame_generation);
+	if (frame == nullptr) return;
+
+	memcpy(dst, frame, buffer_bytes);
+}
@@ -16,10 +16,11 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
 void cycles_film_set_exposure(unsigned int client_id, unsigned int scene_id, float exposure)
 {
+	CCCAPTURE(cycles_film_set_exposure, client_id, scene_id, exposure);
 	SCENE_FIND(scene_id)
 		sce->film->exposure = exposure;
 		sce->film->need_update = true;
@@ -28,6 +29,7 @@ void cycles_film_set_exposure(unsigned int client_id, unsigned int scene_id, flo
 
 void cycles_film_set_filter(unsigned int client_id, unsigned int scene_id, unsigned int filter_type, float filter_width)
 {
+	CCCAPTURE(cycles_film_set_filter, client_id, scene_id, filter_type, filter_width);
 	SCENE_FIND(scene_id)
 		sce->film->filter_type = (ccl::FilterType)filter_type;
 		if (sce->film->filter_type == ccl::FilterType::FILTER_BOX) sce->film->filter_width = 1.0f;
@@ -37,6 +39,7 @@ void cycles_film_set_filter(unsigned int client_id, unsigned int scene_id, unsig
 
 void cycles_film_set_use_sample_clamp(unsigned int client_id, unsigned int scene_id, bool use_sample_clamp)
 {
+	CCCAPTURE(cycles_film_set_use_sample_clamp, client_id, scene_id, use_sample_clamp);
 	SCENE_FIND(scene_id)
 		sce->film->use_sample_clamp = use_sample_clamp;
 	SCENE_FIND_END()
@@ -44,6 +47,7 @@ void cycles_film_set_use_sample_clamp(unsigned int client_id, unsigned int scene
 
 void cycles_film_tag_update(unsigned int client_id, unsigned int scene_id)
 {
+	CCCAPTURE(cycles_film_tag_update, client_id, scene_id);
 	SCENE_FIND(scene_id)
 		sce->film->tag_update(sce);
 	SCENE_FIND_END()
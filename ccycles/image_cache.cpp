@@ -0,0 +1,211 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <cstdio>
+#include <unordered_map>
+
+#include "internal_types.h"
+
+/* Builtin images handed to texture nodes by the set_member_*_img calls.
+ *
+ * Images are looked up by a hash of their name and pixels. Each time an
+ * image is set on a texture node the shader takes one reference, held until
+ * the graph with the node goes, and the image is freed when the last one
+ * goes. Images with equal pixels share one pixel buffer, whatever
+ * their names.
+ */
+static std::unordered_multimap<unsigned long long, CCImage*> images;
+static std::unordered_multimap<unsigned long long, CCImagePixels*> buffers;
+static ccl::thread_mutex images_mutex;
+
+static cycles_image_cache_stats cache_stats;
+
+/* MurmurHash64A. */
+static unsigned long long hash_bytes(const void* data, size_t size, unsigned long long seed)
+{
+	const unsigned long long m{ 0xc6a4a7935bd1e995ULL };
+	const int r{ 47 };
+
+	unsigned long long h = seed ^ (size * m);
+
+	const unsigned char* p = (const unsigned char*)data;
+	const unsigned char* end = p + (size & ~(size_t)7);
+	for (; p != end; p += 8) {
+		unsigned long long k;
+		memcpy(&k, p, sizeof(k));
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	switch (size & 7) {
+		case 7: h ^= (unsigned long long)p[6] << 48;
+		case 6: h ^= (unsigned long long)p[5] << 40;
+		case 5: h ^= (unsigned long long)p[4] << 32;
+		case 4: h ^= (unsigned long long)p[3] << 24;
+		case 3: h ^= (unsigned long long)p[2] << 16;
+		case 2: h ^= (unsigned long long)p[1] << 8;
+		case 1: h ^= (unsigned long long)p[0];
+			h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
+}
+
+static bool same_pixels(const CCImagePixels* px, const void* pixels, size_t size)
+{
+	return px->data.size() == size && (size == 0 || memcmp(px->data.data(), pixels, size) == 0);
+}
+
+CCImage* image_cache_acquire(const string& name, const void* pixels, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels, bool is_float)
+{
+	size_t size = (size_t)width * height * depth * channels * (is_float ? sizeof(float) : sizeof(unsigned char));
+	unsigned long long pixels_hash = hash_bytes(pixels, size, 0);
+	unsigned long long key = hash_bytes(name.data(), name.size(), pixels_hash);
+
+	ccl::thread_scoped_lock images_lock(images_mutex);
+
+	auto found = images.equal_range(key);
+	for (auto it = found.first; it != found.second; ++it) {
+		CCImage* img = it->second;
+		if (img->name == name && img->width == (int)width && img->height == (int)height && img->depth == (int)depth
+			&& img->channels == (int)channels && img->is_float == is_float && same_pixels(img->pixels, pixels, size)) {
+			img->refcount++;
+			cache_stats.references++;
+			cache_stats.hits++;
+			return img;
+		}
+	}
+
+	CCImagePixels* px{ nullptr };
+	auto shared = buffers.equal_range(pixels_hash);
+	for (auto it = shared.first; it != shared.second; ++it) {
+		if (same_pixels(it->second, pixels, size)) {
+			px = it->second;
+			break;
+		}
+	}
+
+	if (px == nullptr) {
+		px = new CCImagePixels();
+		px->data.resize(size);
+		if (size > 0) memcpy(px->data.data(), pixels, size);
+		px->hash = pixels_hash;
+		buffers.insert({ pixels_hash, px });
+		cache_stats.bytes_held += size;
+	}
+	else {
+		cache_stats.bytes_saved += size;
+	}
+	px->users++;
+
+	/* Cycles tells builtin images apart by name and pointer. The pixel hash
+	 * in the name keeps an image that reuses the address of a freed one from
+	 * picking up what Cycles loaded for the old one.
+	 */
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), "@%016llx", pixels_hash);
+
+	CCImage* img = new CCImage();
+	img->name = name;
+	img->filename = name + suffix;
+	img->builtin_data = px->data.data();
+	img->width = (int)width;
+	img->height = (int)height;
+	img->depth = (int)depth;
+	img->channels = (int)channels;
+	img->is_float = is_float;
+	img->key = key;
+	img->pixels = px;
+	img->refcount = 1;
+	images.insert({ key, img });
+
+	cache_stats.references++;
+	cache_stats.misses++;
+	return img;
+}
+
+void image_cache_release(CCImage* img)
+{
+	if (img == nullptr) return;
+
+	ccl::thread_scoped_lock images_lock(images_mutex);
+
+	cache_stats.references--;
+	if (--img->refcount > 0) return;
+
+	auto found = images.equal_range(img->key);
+	for (auto it = found.first; it != found.second; ++it) {
+		if (it->second == img) {
+			images.erase(it);
+			break;
+		}
+	}
+
+	CCImagePixels* px = img->pixels;
+	size_t size = px->data.size();
+	if (--px->users == 0) {
+		auto shared = buffers.equal_range(px->hash);
+		for (auto it = shared.first; it != shared.second; ++it) {
+			if (it->second == px) {
+				buffers.erase(it);
+				break;
+			}
+		}
+		cache_stats.bytes_held -= size;
+		delete px;
+	}
+	else {
+		cache_stats.bytes_saved -= size;
+	}
+
+	delete img;
+	cache_stats.evictions++;
+}
+
+void _cleanup_images()
+{
+	ccl::thread_scoped_lock images_lock(images_mutex);
+
+	for (auto& it : images) {
+		delete it.second;
+	}
+	images.clear();
+
+	for (auto& it : buffers) {
+		delete it.second;
+	}
+	buffers.clear();
+
+	cache_stats = cycles_image_cache_stats{};
+}
+
+void cycles_image_cache_get_stats(unsigned int client_id, cycles_image_cache_stats* stats)
+{
+	CCTRACE_API();
+	ccl::thread_scoped_lock images_lock(images_mutex);
+	*stats = cache_stats;
+	stats->images = (unsigned int)images.size();
+	stats->buffers = (unsigned int)buffers.size();
+}
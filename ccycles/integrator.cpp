@@ -16,10 +16,11 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
 void cycles_integrator_tag_update(unsigned int client_id, unsigned int scene_id)
 {
+	CCCAPTURE(cycles_integrator_tag_update, client_id, scene_id);
 	SCENE_FIND(scene_id)
 		sce->integrator->tag_update(sce);
 	SCENE_FIND_END()
@@ -28,6 +29,7 @@ void cycles_integrator_tag_update(unsigned int client_id, unsigned int scene_id)
 // Integrator settings
 void cycles_integrator_set_max_bounce(unsigned int client_id, unsigned int scene_id, int max_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_max_bounce, client_id, scene_id, max_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->max_bounce = max_bounce;
 	SCENE_FIND_END()
@@ -35,6 +37,7 @@ void cycles_integrator_set_max_bounce(unsigned int client_id, unsigned int scene
 
 void cycles_integrator_set_min_bounce(unsigned int client_id, unsigned int scene_id, int min_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_min_bounce, client_id, scene_id, min_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->min_bounce = min_bounce;
 	SCENE_FIND_END()
@@ -42,6 +45,7 @@ void cycles_integrator_set_min_bounce(unsigned int client_id, unsigned int scene
 
 void cycles_integrator_set_no_caustics(unsigned int client_id, unsigned int scene_id, bool no_caustics)
 {
+	CCCAPTURE(cycles_integrator_set_no_caustics, client_id, scene_id, no_caustics);
 	SCENE_FIND(scene_id)
 		sce->integrator->caustics_reflective = !no_caustics;
 		sce->integrator->caustics_refractive = !no_caustics;
@@ -50,6 +54,7 @@ void cycles_integrator_set_no_caustics(unsigned int client_id, unsigned int scen
 
 void cycles_integrator_set_transparent_shadows(unsigned int client_id, unsigned int scene_id, bool transparent_shadows)
 {
+	CCCAPTURE(cycles_integrator_set_transparent_shadows, client_id, scene_id, transparent_shadows);
 	SCENE_FIND(scene_id)
 		sce->integrator->transparent_shadows = transparent_shadows;
 	SCENE_FIND_END()
@@ -57,6 +62,7 @@ void cycles_integrator_set_transparent_shadows(unsigned int client_id, unsigned
 
 void cycles_integrator_set_diffuse_samples(unsigned int client_id, unsigned int scene_id, int diffuse_samples)
 {
+	CCCAPTURE(cycles_integrator_set_diffuse_samples, client_id, scene_id, diffuse_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->diffuse_samples = diffuse_samples;
 	SCENE_FIND_END()
@@ -64,6 +70,7 @@ void cycles_integrator_set_diffuse_samples(unsigned int client_id, unsigned int
 
 void cycles_integrator_set_glossy_samples(unsigned int client_id, unsigned int scene_id, int glossy_samples)
 {
+	CCCAPTURE(cycles_integrator_set_glossy_samples, client_id, scene_id, glossy_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->glossy_samples = glossy_samples;
 	SCENE_FIND_END()
@@ -71,6 +78,7 @@ void cycles_integrator_set_glossy_samples(unsigned int client_id, unsigned int s
 
 void cycles_integrator_set_transmission_samples(unsigned int client_id, unsigned int scene_id, int transmission_samples)
 {
+	CCCAPTURE(cycles_integrator_set_transmission_samples, client_id, scene_id, transmission_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->transmission_samples = transmission_samples;
 	SCENE_FIND_END()
@@ -78,6 +86,7 @@ void cycles_integrator_set_transmission_samples(unsigned int client_id, unsigned
 
 void cycles_integrator_set_ao_samples(unsigned int client_id, unsigned int scene_id, int ao_samples)
 {
+	CCCAPTURE(cycles_integrator_set_ao_samples, client_id, scene_id, ao_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->ao_samples = ao_samples;
 	SCENE_FIND_END()
@@ -85,6 +94,7 @@ void cycles_integrator_set_ao_samples(unsigned int client_id, unsigned int scene
 
 void cycles_integrator_set_mesh_light_samples(unsigned int client_id, unsigned int scene_id, int mesh_light_samples)
 {
+	CCCAPTURE(cycles_integrator_set_mesh_light_samples, client_id, scene_id, mesh_light_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->mesh_light_samples = mesh_light_samples;
 	SCENE_FIND_END()
@@ -92,6 +102,7 @@ void cycles_integrator_set_mesh_light_samples(unsigned int client_id, unsigned i
 
 void cycles_integrator_set_subsurface_samples(unsigned int client_id, unsigned int scene_id, int subsurface_samples)
 {
+	CCCAPTURE(cycles_integrator_set_subsurface_samples, client_id, scene_id, subsurface_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->subsurface_samples = subsurface_samples;
 	SCENE_FIND_END()
@@ -99,6 +110,7 @@ void cycles_integrator_set_subsurface_samples(unsigned int client_id, unsigned i
 
 void cycles_integrator_set_volume_samples(unsigned int client_id, unsigned int scene_id, int volume_samples)
 {
+	CCCAPTURE(cycles_integrator_set_volume_samples, client_id, scene_id, volume_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->volume_samples = volume_samples;
 	SCENE_FIND_END()
@@ -106,6 +118,7 @@ void cycles_integrator_set_volume_samples(unsigned int client_id, unsigned int s
 
 void cycles_integrator_set_max_diffuse_bounce(unsigned int client_id, unsigned int scene_id, int max_diffuse_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_max_diffuse_bounce, client_id, scene_id, max_diffuse_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->max_diffuse_bounce = max_diffuse_bounce;
 	SCENE_FIND_END()
@@ -113,6 +126,7 @@ void cycles_integrator_set_max_diffuse_bounce(unsigned int client_id, unsigned i
 
 void cycles_integrator_set_max_glossy_bounce(unsigned int client_id, unsigned int scene_id, int max_glossy_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_max_glossy_bounce, client_id, scene_id, max_glossy_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->max_glossy_bounce = max_glossy_bounce;
 	SCENE_FIND_END()
@@ -120,6 +134,7 @@ void cycles_integrator_set_max_glossy_bounce(unsigned int client_id, unsigned in
 
 void cycles_integrator_set_max_transmission_bounce(unsigned int client_id, unsigned int scene_id, int max_transmission_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_max_transmission_bounce, client_id, scene_id, max_transmission_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->max_transmission_bounce = max_transmission_bounce;
 	SCENE_FIND_END()
@@ -127,6 +142,7 @@ void cycles_integrator_set_max_transmission_bounce(unsigned int client_id, unsig
 
 void cycles_integrator_set_max_volume_bounce(unsigned int client_id, unsigned int scene_id, int max_volume_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_max_volume_bounce, client_id, scene_id, max_volume_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->max_volume_bounce = max_volume_bounce;
 	SCENE_FIND_END()
@@ -134,6 +150,7 @@ void cycles_integrator_set_max_volume_bounce(unsigned int client_id, unsigned in
 
 void cycles_integrator_set_transparent_min_bounce(unsigned int client_id, unsigned int scene_id, int transparent_min_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_transparent_min_bounce, client_id, scene_id, transparent_min_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->transparent_min_bounce = transparent_min_bounce;
 	SCENE_FIND_END()
@@ -141,6 +158,7 @@ void cycles_integrator_set_transparent_min_bounce(unsigned int client_id, unsign
 
 void cycles_integrator_set_transparent_max_bounce(unsigned int client_id, unsigned int scene_id, int transparent_max_bounce)
 {
+	CCCAPTURE(cycles_integrator_set_transparent_max_bounce, client_id, scene_id, transparent_max_bounce);
 	SCENE_FIND(scene_id)
 		sce->integrator->transparent_max_bounce = transparent_max_bounce;
 	SCENE_FIND_END()
@@ -148,6 +166,7 @@ void cycles_integrator_set_transparent_max_bounce(unsigned int client_id, unsign
 
 void cycles_integrator_set_aa_samples(unsigned int client_id, unsigned int scene_id, int aa_samples)
 {
+	CCCAPTURE(cycles_integrator_set_aa_samples, client_id, scene_id, aa_samples);
 	SCENE_FIND(scene_id)
 		sce->integrator->aa_samples = aa_samples;
 	SCENE_FIND_END()
@@ -155,6 +174,7 @@ void cycles_integrator_set_aa_samples(unsigned int client_id, unsigned int scene
 
 void cycles_integrator_set_filter_glossy(unsigned int client_id, unsigned int scene_id, float filter_glossy)
 {
+	CCCAPTURE(cycles_integrator_set_filter_glossy, client_id, scene_id, filter_glossy);
 	SCENE_FIND(scene_id)
 		sce->integrator->filter_glossy = filter_glossy;
 	SCENE_FIND_END()
@@ -162,6 +182,7 @@ void cycles_integrator_set_filter_glossy(unsigned int client_id, unsigned int sc
 
 void cycles_integrator_set_method(unsigned int client_id, unsigned int scene_id, int method)
 {
+	CCCAPTURE(cycles_integrator_set_method, client_id, scene_id, method);
 	SCENE_FIND(scene_id)
 		sce->integrator->method = (ccl::Integrator::Method)method;
 	SCENE_FIND_END()
@@ -169,6 +190,7 @@ void cycles_integrator_set_method(unsigned int client_id, unsigned int scene_id,
 
 void cycles_integrator_set_sample_all_lights_direct(unsigned int client_id, unsigned int scene_id, bool sample_all_lights_direct)
 {
+	CCCAPTURE(cycles_integrator_set_sample_all_lights_direct, client_id, scene_id, sample_all_lights_direct);
 	SCENE_FIND(scene_id)
 		sce->integrator->sample_all_lights_direct = sample_all_lights_direct;
 	SCENE_FIND_END()
@@ -176,6 +198,7 @@ void cycles_integrator_set_sample_all_lights_direct(unsigned int client_id, unsi
 
 void cycles_integrator_set_sample_all_lights_indirect(unsigned int client_id, unsigned int scene_id, bool sample_all_lights_indirect)
 {
+	CCCAPTURE(cycles_integrator_set_sample_all_lights_indirect, client_id, scene_id, sample_all_lights_indirect);
 	SCENE_FIND(scene_id)
 		sce->integrator->sample_all_lights_indirect = sample_all_lights_indirect;
 	SCENE_FIND_END()
@@ -183,6 +206,7 @@ void cycles_integrator_set_sample_all_lights_indirect(unsigned int client_id, un
 
 void cycles_integrator_set_volume_step_size(unsigned int client_id, unsigned int scene_id, float volume_step_size)
 {
+	CCCAPTURE(cycles_integrator_set_volume_step_size, client_id, scene_id, volume_step_size);
 	SCENE_FIND(scene_id)
 		sce->integrator->volume_step_size = volume_step_size;
 	SCENE_FIND_END()
@@ -190,6 +214,7 @@ void cycles_integrator_set_volume_step_size(unsigned int client_id, unsigned int
 
 void cycles_integrator_set_volume_max_steps(unsigned int client_id, unsigned int scene_id, int volume_max_steps)
 {
+	CCCAPTURE(cycles_integrator_set_volume_max_steps, client_id, scene_id, volume_max_steps);
 	SCENE_FIND(scene_id)
 		sce->integrator->volume_max_steps = volume_max_steps;
 	SCENE_FIND_END()
@@ -213,6 +238,7 @@ void cycles_integrator_set_caustics_refractive(unsigned int client_id, unsigned
 
 void cycles_integrator_set_seed(unsigned int client_id, unsigned int scene_id, int seed)
 {
+	CCCAPTURE(cycles_integrator_set_seed, client_id, scene_id, seed);
 	SCENE_FIND(scene_id)
 		sce->integrator->seed = seed;
 	SCENE_FIND_END()
@@ -220,6 +246,7 @@ void cycles_integrator_set_seed(unsigned int client_id, unsigned int scene_id, i
 
 void cycles_integrator_set_sampling_pattern(unsigned int client_id, unsigned int scene_id, sampling_pattern pattern)
 {
+	CCCAPTURE(cycles_integrator_set_sampling_pattern, client_id, scene_id, pattern);
 	SCENE_FIND(scene_id)
 		sce->integrator->sampling_pattern = (ccl::SamplingPattern)pattern;
 	SCENE_FIND_END()
@@ -227,6 +254,7 @@ void cycles_integrator_set_sampling_pattern(unsigned int client_id, unsigned int
 
 void cycles_integrator_set_sample_clamp_direct(unsigned int client_id, unsigned int scene_id, float sample_clamp_direct)
 {
+	CCCAPTURE(cycles_integrator_set_sample_clamp_direct, client_id, scene_id, sample_clamp_direct);
 	SCENE_FIND(scene_id)
 		sce->integrator->sample_clamp_direct = sample_clamp_direct;
 	SCENE_FIND_END()
@@ -234,6 +262,7 @@ void cycles_integrator_set_sample_clamp_direct(unsigned int client_id, unsigned
 
 void cycles_integrator_set_sample_clamp_indirect(unsigned int client_id, unsigned int scene_id, float sample_clamp_indirect)
 {
+	CCCAPTURE(cycles_integrator_set_sample_clamp_indirect, client_id, scene_id, sample_clamp_indirect);
 	SCENE_FIND(scene_id)
 		sce->integrator->sample_clamp_indirect = sample_clamp_indirect;
 	SCENE_FIND_END()
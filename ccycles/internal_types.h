@@ -15,10 +15,19 @@ limitations under the License.
 **/
 
 #include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <cfloat>
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <streambuf>
+#include <ostream>
+#include <fstream>
 
 #pragma warning ( push )
 
@@ -46,80 +55,521 @@ limitations under the License.
 #pragma warning ( pop )
 
 #include "ccycles.h"
+#include "capture_format.h"
 
 //extern LOGGER_FUNC_CB logger_func;
 extern std::vector<LOGGER_FUNC_CB> loggers;
 
 extern std::ostream& operator<<(std::ostream& out, shadernode_type const &snt);
 
-/* Simple class to help with debug logging. */
+/* Levels below CCYCLES_LOG_LEVEL compile to nothing, arguments included.
+ * Debug builds keep everything, release builds only warnings and errors.
+ * Define CCYCLES_LOG_LEVEL in the project to override.
+ */
+#ifndef CCYCLES_LOG_LEVEL
+#if defined(DEBUG)
+#define CCYCLES_LOG_LEVEL CCYCLES_LOG_TRACE
+#else
+#define CCYCLES_LOG_LEVEL CCYCLES_LOG_WARNING
+#endif
+#endif
+
+/* Fixed size output for formatting log messages in place. Output that
+ * doesn't fit is cut off.
+ */
+class LogStreamBuf : public std::streambuf {
+public:
+	LogStreamBuf(char* buf, size_t size) { setp(buf, buf + size); }
+	void reset() { setp(pbase(), epptr()); }
+	size_t length() const { return pptr() - pbase(); }
+};
+
+/* Asynchronous, level filtered logger.
+ *
+ * Messages are formatted on the calling thread into a thread-local buffer
+ * and copied into a bounded lock-free ring. A background thread drains the
+ * ring, adds the timestamp and hands the message to the logger callback of
+ * the client and to std::cout if wanted. Callers never wait for a lock or
+ * for the callbacks. When the ring is full the message is dropped and
+ * counted instead; the drain thread reports the count.
+ *
+ * Use the CCLOG_* macros rather than logit directly, so disabled levels
+ * cost nothing.
+ */
 class Logger {
 public:
-	bool tostdout{ false };
+	static const size_t MESSAGE_SIZE{ 480 };
+	static const size_t RING_SIZE{ 2048 };
 
-	/* Variadic template function so we can handle
-	 * any amount of arguments. Each subsequent call
-	 * adds the head to logger_msg.
-	 */
-	template<typename T, typename... Tail>
-	void logit(unsigned int client_id, T head, Tail... tail) {
-		m.lock();
-		/* reset logger_msg */
-		logger_msg.str("");
+	std::atomic<bool> tostdout{ false };
 
-		/* get current time as string. std::ctime returns char* that
-		 * has \n at the end. Make sure we don't have that, otherwise
-		 * our beautiful output gets broken up.
-		 */
-		auto t = std::chrono::system_clock::now();
-		std::time_t ts = std::chrono::system_clock::to_time_t(t);
-		auto tsstr = string{std::ctime(&ts)};
-		tsstr = tsstr.substr(0, tsstr.size() - 1);
+	Logger();
+	~Logger();
 
-		/* start our new logger_msg with timestamp and head, then
-		 * follow up :)
-		 */
-		logger_msg << tsstr << ": " << head;
-		logit_followup(client_id, tail...);
-	}
+	/* Runtime filter on top of CCYCLES_LOG_LEVEL. */
+	void set_level(unsigned int level) { min_level.store(level, std::memory_order_relaxed); }
+	bool enabled(unsigned int level) const { return level >= min_level.load(std::memory_order_relaxed); }
 
-private:
-	template<typename T, typename... Tail>
-	void logit_followup(unsigned int client_id, T head, Tail... tail) {
-		logger_msg << head;
-		logit_followup(client_id, tail...);
+	template<typename... Args>
+	void logit(unsigned int level, unsigned int client_id, const Args&... args) {
+		LocalBuffer& local = local_buffer();
+		local.sb.reset();
+		local.os.clear();
+
+		int expand[] = { 0, ((local.os << args), 0)... };
+		(void)expand;
+
+		push(level, client_id, local.data, local.sb.length());
 	}
 
-	/* The final logit function call that will realise the
-	 * stringstream constructed by the variadic template
-	 * function. Upon completion reset the logger_msg to
-	 * an empty string.
+	/* Deliver everything queued so far and stop the drain thread. It is
+	 * started again by the next message.
 	 */
-	void logit_followup(unsigned int client_id) {
-		LOGGER_FUNC_CB logger_func = loggers[client_id];
-#if defined(DEBUG)
-		if (logger_func) logger_func(logger_msg.str().c_str());
+	void stop();
 
-		// also print to std::cout if wanted
-		if (tostdout) std::cout << logger_msg.str().c_str() << std::endl;
-#endif
-		m.unlock();
-	}
+private:
+	struct Entry {
+		std::atomic<size_t> seq;
+		unsigned int level;
+		unsigned int client_id;
+		std::chrono::system_clock::time_point time;
+		size_t length;
+		char msg[MESSAGE_SIZE];
+	};
+
+	struct LocalBuffer {
+		char data[MESSAGE_SIZE];
+		LogStreamBuf sb{ data, MESSAGE_SIZE };
+		std::ostream os{ &sb };
+	};
+
+	static LocalBuffer& local_buffer();
 
-	stringstream logger_msg;
+	void push(unsigned int level, unsigned int client_id, const char* msg, size_t length);
+	void start();
+	void drain_thread();
+	bool drain();
+	void deliver(unsigned int client_id, const string& msg);
 
-	mutex m;
+	Entry* ring;
+	std::atomic<size_t> enqueue_pos{ 0 };
+	size_t dequeue_pos{ 0 };
+	std::atomic<size_t> dropped{ 0 };
+	std::atomic<unsigned int> min_level{ CCYCLES_LOG_TRACE };
+
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<bool> sleeping{ false };
+	/* Set from when stop claims the thread until its final drain is done.
+	 * Guarded by thread_mutex.
+	 */
+	bool stopping{ false };
+	std::mutex thread_mutex;
+	std::condition_variable wakeup;
 };
 
 /*
  * The logger facility to use.
  *
  * Usage:
- * logger.logit("This is a message", var, var2, " and some more", var3);
+ * CCLOG_DEBUG(client_id, "This is a message", var, var2, " and some more", var3);
  */
 extern Logger logger;
 
+/* Guards the loggers callback list, which the drain thread reads. */
+extern std::mutex loggers_mutex;
+
+#define CCLOG(level, client_id, ...) \
+	do { if (logger.enabled(level)) logger.logit(level, client_id, __VA_ARGS__); } while (0)
+
+#if CCYCLES_LOG_LEVEL <= CCYCLES_LOG_TRACE
+#define CCLOG_TRACE(client_id, ...) CCLOG(CCYCLES_LOG_TRACE, client_id, __VA_ARGS__)
+#else
+#define CCLOG_TRACE(client_id, ...) ((void)0)
+#endif
+
+#if CCYCLES_LOG_LEVEL <= CCYCLES_LOG_DEBUG
+#define CCLOG_DEBUG(client_id, ...) CCLOG(CCYCLES_LOG_DEBUG, client_id, __VA_ARGS__)
+#else
+#define CCLOG_DEBUG(client_id, ...) ((void)0)
+#endif
+
+#if CCYCLES_LOG_LEVEL <= CCYCLES_LOG_INFO
+#define CCLOG_INFO(client_id, ...) CCLOG(CCYCLES_LOG_INFO, client_id, __VA_ARGS__)
+#else
+#define CCLOG_INFO(client_id, ...) ((void)0)
+#endif
+
+#if CCYCLES_LOG_LEVEL <= CCYCLES_LOG_WARNING
+#define CCLOG_WARNING(client_id, ...) CCLOG(CCYCLES_LOG_WARNING, client_id, __VA_ARGS__)
+#else
+#define CCLOG_WARNING(client_id, ...) ((void)0)
+#endif
+
+#if CCYCLES_LOG_LEVEL <= CCYCLES_LOG_ERROR
+#define CCLOG_ERROR(client_id, ...) CCLOG(CCYCLES_LOG_ERROR, client_id, __VA_ARGS__)
+#else
+#define CCLOG_ERROR(client_id, ...) ((void)0)
+#endif
+
+/* Records timed spans into per-thread buffers while tracing is on, see
+ * cycles_trace_start. Written out in Chrome trace event format for
+ * chrome://tracing and similar timeline viewers.
+ */
+class CCTracer final {
+public:
+	struct Span {
+		/* String literals only, they're kept as pointers. */
+		const char* name;
+		const char* category;
+		long long start_us;
+		long long duration_us;
+		/* Optional text shown as args.detail. */
+		string detail;
+	};
+
+	bool enabled() const {
+		return on.load(std::memory_order_relaxed);
+	}
+
+	/* Microseconds since tracing started. */
+	long long now_us() const;
+	long long to_us(std::chrono::steady_clock::time_point t) const;
+
+	/* Add a finished span for the calling thread. */
+	void record(const char* name, const char* category, long long start_us, long long end_us, const string& detail = string());
+
+	/* Drop all spans and start recording. */
+	void start();
+	/* Stop recording and write all spans to path. Returns false if the file
+	 * couldn't be written.
+	 */
+	bool stop(const char* path);
+
+private:
+	struct ThreadBuffer {
+		std::mutex mutex;
+		unsigned int tid;
+		std::vector<Span> spans;
+	};
+
+	ThreadBuffer& local_buffer();
+
+	std::atomic<bool> on{ false };
+	/* Start of the trace in steady_clock ticks, read by any thread. */
+	std::atomic<long long> epoch{ 0 };
+	/* Buffers of all threads that ever recorded, kept when threads end. */
+	std::mutex buffers_mutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+extern CCTracer tracer;
+
+/* Records a span from construction to destruction when tracing is on. */
+class CCTraceScope final {
+public:
+	CCTraceScope(const char* name_, const char* category_)
+		: name{ name_ }, category{ category_ }, start_us{ tracer.enabled() ? tracer.now_us() : -1 }
+	{  }
+
+	~CCTraceScope() {
+		if (start_us >= 0 && tracer.enabled()) {
+			tracer.record(name, category, start_us, tracer.now_us());
+		}
+	}
+
+private:
+	const char* name;
+	const char* category;
+	long long start_us;
+};
+
+#define CCTRACE_CONCAT2(a, b) a##b
+#define CCTRACE_CONCAT(a, b) CCTRACE_CONCAT2(a, b)
+
+/* Trace the enclosing scope as name in category. */
+#define CCTRACE(category, name) CCTraceScope CCTRACE_CONCAT(cctrace_scope_, __LINE__)(name, category)
+
+/* Trace the enclosing API entry point. Every entry point traces itself once,
+ * with this or through the FIND and PARAM macros below, except
+ * cycles_trace_start and cycles_trace_stop, which switch tracing.
+ */
+#define CCTRACE_API() CCTRACE("api", __FUNCTION__)
+
+/* Records API calls to a log for ccycles_replay, see capture_format.h. */
+class CCCapture final {
+public:
+	bool enabled() const {
+		return on.load(std::memory_order_relaxed);
+	}
+
+	/* Start a new log at path, ending the current one. Returns false if
+	 * path couldn't be opened.
+	 */
+	bool start(const char* path);
+	/* End the log. */
+	void stop();
+
+	/* Append the record for a call to f. Calls from different threads end
+	 * up in the log in the order they get the lock.
+	 */
+	template <typename R, typename... P, typename... A>
+	void call(capture_call id, R(*f)(P...), const A&... args) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!out.is_open()) return;
+
+		CCCaptureWriter writer(out);
+		capture_write_call(writer, id, f, args...);
+	}
+
+private:
+	std::atomic<bool> on{ false };
+	std::mutex mutex;
+	std::ofstream out;
+};
+
+extern CCCapture capture;
+
+/* Tells whether the enclosing API call is the outermost one on this
+ * thread. Calls the API makes to itself happen again on replay, so only
+ * the outermost gets recorded.
+ */
+class CCCaptureScope final {
+public:
+	explicit CCCaptureScope(bool on_)
+		: on{ on_ }, outermost{ on_ && depth++ == 0 }
+	{  }
+
+	~CCCaptureScope() {
+		if (on) depth--;
+	}
+
+	const bool on;
+	const bool outermost;
+
+private:
+	static thread_local int depth;
+};
+
+/* Record the call to API function name when capturing. The remaining
+ * arguments are its parameters in order, pointers wrapped in capture_array
+ * with their element count.
+ */
+#define CCCAPTURE(name, ...) \
+	CCCaptureScope cccapture_scope(capture.enabled()); \
+	if (cccapture_scope.outermost) capture.call(capture_call::name, &name, ##__VA_ARGS__)
+
+/* Slot map handing out the unsigned int IDs the API uses for objects of
+ * type T. A handle holds the slot index in its low INDEX_BITS and the slot
+ * generation in the remaining bits. Removed slots go on a free list and are
+ * reused in O(1) with their generation bumped, so handles to a removed
+ * object no longer resolve. Generations start at 0, so the first handle
+ * for each slot equals the plain index handed out before.
+ *
+ * The free list is first in first out and only used once it holds
+ * MIN_FREE_SLOTS, so a slot is reused at most once per MIN_FREE_SLOTS
+ * removals. A stale handle only matches again after its slot went through
+ * all 2^(32 - INDEX_BITS) generations, a million create/destroy cycles,
+ * instead of after 256 cycles on the one hot slot.
+ *
+ * Slots live in chunks that are never moved or freed until the table goes,
+ * chunk k holding FIRST_CHUNK << k slots. A pointer returned by get stays
+ * valid while other threads insert. Lookups take no lock: they read the
+ * chunk pointer and the handle stored in the slot, both atomics published
+ * by the writer after the value is in place. Writers serialise on a mutex
+ * per table.
+ *
+ * Looking up a handle while another thread removes that same handle is
+ * still a client error, the value gets reset under the reader.
+ */
+template <typename T>
+class CCHandleTable final {
+public:
+	static const unsigned int INDEX_BITS{ 22 };
+	static const unsigned int INDEX_MASK{ (1u << INDEX_BITS) - 1 };
+	/* Removed slots kept waiting before reuse. */
+	static const unsigned int MIN_FREE_SLOTS{ 1024 };
+	/* Returned by insert when the table is full. */
+	static const unsigned int INVALID{ UINT_MAX };
+
+	CCHandleTable()
+	{
+		for (unsigned int k = 0; k < MAX_CHUNKS; k++) {
+			chunks[k].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	~CCHandleTable()
+	{
+		for (unsigned int k = 0; k < MAX_CHUNKS; k++) {
+			delete[] chunks[k].load(std::memory_order_relaxed);
+		}
+	}
+
+	/* Store value, return the handle for it. */
+	unsigned int insert(const T& value)
+	{
+		ccl::thread_scoped_lock writer_lock(writer_mutex);
+
+		unsigned int index;
+		/* Keep INDEX_MASK unused so no handle equals INVALID. */
+		if (free_slots.size() >= MIN_FREE_SLOTS || (!free_slots.empty() && slot_count >= INDEX_MASK)) {
+			index = free_slots.front();
+			free_slots.pop_front();
+		}
+		else {
+			if (slot_count >= INDEX_MASK) return INVALID;
+			index = slot_count;
+
+			unsigned int k, offset;
+			locate(index, k, offset);
+			if (chunks[k].load(std::memory_order_relaxed) == nullptr) {
+				chunks[k].store(new Slot[FIRST_CHUNK << k], std::memory_order_release);
+			}
+			slot_count++;
+		}
+
+		Slot& slot = slot_at(index);
+		slot.value = value;
+		unsigned int handle = (slot.generation << INDEX_BITS) | index;
+		/* Publish only after value is in place. */
+		slot.handle.store(handle, std::memory_order_release);
+		return handle;
+	}
+
+	/* Pointer to the value for handle, nullptr for stale or unknown handles. */
+	T* get(unsigned int handle)
+	{
+		if (handle == INVALID) return nullptr;
+
+		unsigned int k, offset;
+		locate(handle & INDEX_MASK, k, offset);
+		Slot* chunk = chunks[k].load(std::memory_order_acquire);
+		if (chunk == nullptr) return nullptr;
+
+		Slot& slot = chunk[offset];
+		if (slot.handle.load(std::memory_order_acquire) != handle) return nullptr;
+
+		return &slot.value;
+	}
+
+	/* Copy of the value for handle, T() for stale or unknown handles. */
+	T find(unsigned int handle)
+	{
+		T* value = get(handle);
+		return value ? *value : T();
+	}
+
+	/* Release the slot of handle. The value is reset to T(), the caller
+	 * frees whatever it pointed to.
+	 */
+	bool remove(unsigned int handle)
+	{
+		ccl::thread_scoped_lock writer_lock(writer_mutex);
+
+		if (get(handle) == nullptr) return false;
+
+		unsigned int index = handle & INDEX_MASK;
+		release(slot_at(index));
+		free_slots.push_back(index);
+		return true;
+	}
+
+	/* Call f(handle, value) for each live entry. Holds the writer lock, so
+	 * f must not insert into or remove from this table.
+	 */
+	template <typename F>
+	void for_each(F f)
+	{
+		ccl::thread_scoped_lock writer_lock(writer_mutex);
+
+		for (unsigned int index = 0; index < slot_count; index++) {
+			Slot& slot = slot_at(index);
+			unsigned int handle = slot.handle.load(std::memory_order_relaxed);
+			if (handle != INVALID) f(handle, slot.value);
+		}
+	}
+
+	/* Drop all entries. Generations are kept, so old handles stay invalid.
+	 * Chunks are kept for reuse.
+	 */
+	void clear()
+	{
+		ccl::thread_scoped_lock writer_lock(writer_mutex);
+
+		free_slots.clear();
+		for (unsigned int index = 0; index < slot_count; index++) {
+			Slot& slot = slot_at(index);
+			if (slot.handle.load(std::memory_order_relaxed) != INVALID) {
+				release(slot);
+			}
+			free_slots.push_back(index);
+		}
+	}
+
+private:
+	/* Slots in the first chunk, each next chunk doubles. 18 chunks cover
+	 * the full 22 bit index range.
+	 */
+	static const unsigned int FIRST_CHUNK_BITS{ 5 };
+	static const unsigned int FIRST_CHUNK{ 1u << FIRST_CHUNK_BITS };
+	static const unsigned int MAX_CHUNKS{ INDEX_BITS - FIRST_CHUNK_BITS + 1 };
+
+	struct Slot {
+		T value{};
+		/* Handle currently pointing to this slot, INVALID when unused.
+		 * The only field readers look at before trusting value.
+		 */
+		std::atomic<unsigned int> handle{ INVALID };
+		/* Generation the next handle for this slot gets. Writer only. */
+		unsigned int generation{ 0 };
+	};
+
+	/* Chunk k holds indices [FIRST_CHUNK * (2^k - 1), FIRST_CHUNK * (2^(k+1) - 1)). */
+	static void locate(unsigned int index, unsigned int& k, unsigned int& offset)
+	{
+		unsigned int biased = (index >> FIRST_CHUNK_BITS) + 1;
+		k = 0;
+		while (biased >>= 1) k++;
+		offset = index - FIRST_CHUNK * ((1u << k) - 1);
+	}
+
+	Slot& slot_at(unsigned int index)
+	{
+		unsigned int k, offset;
+		locate(index, k, offset);
+		return chunks[k].load(std::memory_order_relaxed)[offset];
+	}
+
+	/* Caller holds writer_mutex. */
+	void release(Slot& slot)
+	{
+		slot.handle.store(INVALID, std::memory_order_release);
+		slot.value = T();
+		slot.generation = (slot.generation + 1) & (UINT_MAX >> INDEX_BITS);
+	}
+
+	std::atomic<Slot*> chunks[MAX_CHUNKS];
+	/* Number of slots ever handed out, all in allocated chunks. Writer only. */
+	unsigned int slot_count{ 0 };
+	/* Indices of unused slots, reused first in first out. Writer only. */
+	std::deque<unsigned int> free_slots;
+	ccl::thread_mutex writer_mutex;
+};
+
+/* Pixel data of builtin images, shared by all images with equal pixels. */
+struct CCImagePixels {
+		vector<unsigned char> data;
+		unsigned long long hash;
+		/* Images using this buffer. */
+		unsigned int users;
+};
+
+/* Builtin image, owned by the image cache in image_cache.cpp. */
 struct CCImage {
+		/* Name the client gave the image. */
+		string name;
+		/* Name Cycles knows the image by. */
 		string filename;
 		void *builtin_data;
 
@@ -128,6 +578,430 @@ struct CCImage {
 		int depth;
 		int channels;
 		bool is_float;
+
+		unsigned long long key;
+		CCImagePixels* pixels;
+		/* Texture nodes using the image. */
+		unsigned int refcount;
+};
+
+/* Rectangle in session buffer pixel coordinates, origin top-left. */
+struct CCRect {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+/* Size in bytes of one pixel component in format. */
+unsigned int buffer_format_component_size(buffer_format format);
+
+/* Convert pixel_count pixels of components floats from src into format
+ * in dst. Uses SSE2 where available.
+ */
+void convert_pixels(buffer_format format, unsigned char* dst, const float* src, size_t pixel_count, unsigned int components);
+
+/* Triple buffered snapshot of a session pixel buffer for readers.
+ *
+ * Render threads write tiles into CCSession::pixels, record the changed
+ * area with mark_dirty and then publish. Readers acquire the most recently
+ * published frame without ever taking CCSession::pixels_mutex, so a slow
+ * reader can't stall tile writers and never sees a half-written tile.
+ *
+ * Of the three slots one is owned by the writer (back), one by the reader
+ * (front) and one holds the latest published frame (middle). publish and
+ * acquire atomically swap the middle slot with their own. Each slot keeps
+ * a list of rectangles changed since it was last brought up to date, so
+ * publishing only copies what changed.
+ */
+class CCDisplayBuffer final {
+public:
+	/* Serialise readers. Writers never take this. */
+	ccl::thread_mutex reader_mutex;
+
+	/* Size in bytes of one slot. */
+	size_t buffer_bytes{ 0 };
+
+	/* (Re)allocate slots for width x height pixels of pixel_size bytes.
+	 * Caller holds CCSession::pixels_mutex. Waits for current reader.
+	 */
+	void reset(int width, int height, unsigned int pixel_size);
+
+	/* Writer side, caller holds CCSession::pixels_mutex. Record an area of
+	 * the working buffer that changed since the last publish.
+	 */
+	void mark_dirty(const CCRect& rect);
+	void mark_all_dirty();
+
+	/* Writer side, caller holds CCSession::pixels_mutex. Bring the back slot
+	 * up to date with src and make it the latest published frame.
+	 */
+	void publish(const unsigned char* src);
+
+	/* Reader side, caller holds reader_mutex. Returns the latest published
+	 * frame, valid until the next acquire or reset.
+	 */
+	const unsigned char* acquire(unsigned long long& frame_generation);
+
+	/* Reader side, caller holds reader_mutex. Copy into dst only the areas
+	 * that changed since the previous copy_dirty or copy_all, and report
+	 * them in rects. When there are more than max_rects areas they get
+	 * merged into their bounding box. Returns the number of rects written.
+	 */
+	int copy_dirty(void* dst, CCRect* rects, int max_rects, unsigned long long& frame_generation);
+
+	/* Reader side, caller holds reader_mutex. Copy the complete latest frame
+	 * into dst. Clears the areas copy_dirty would report.
+	 */
+	void copy_all(void* dst, unsigned long long& frame_generation);
+
+	/* Generation of the most recently published frame, 0 if none yet. */
+	unsigned long long latest_generation() const { return generation.load(); }
+
+	~CCDisplayBuffer();
+
+private:
+	/* Flag in middle telling there is a frame the reader hasn't seen. */
+	static const unsigned int FRESH{ 4 };
+	/* More rectangles pending than this and we copy the full buffer. */
+	static const size_t MAX_PENDING_RECTS{ 64 };
+
+	unsigned char* slots[3]{ nullptr, nullptr, nullptr };
+	unsigned long long slot_generation[3]{ 0, 0, 0 };
+	std::vector<CCRect> pending[3];
+	bool pending_full[3]{ true, true, true };
+
+	/* Areas marked dirty since the last publish. Writer only. */
+	std::vector<CCRect> unpublished;
+	bool unpublished_full{ true };
+
+	/* Areas published but not yet handed out by copy_dirty. Moved here
+	 * from unpublished on publish.
+	 */
+	ccl::thread_mutex unread_mutex;
+	std::vector<CCRect> unread;
+	bool unread_full{ true };
+
+	static void add_rect(std::vector<CCRect>& rects, bool& full, const CCRect& rect);
+	void copy_rect(unsigned char* dst, const unsigned char* src, const CCRect& rect) const;
+
+	int width{ 0 };
+	int height{ 0 };
+	unsigned int pixel_size{ 0 };
+
+	unsigned int back{ 0 };
+	unsigned int front{ 1 };
+	std::atomic<unsigned int> middle{ 2 };
+	std::atomic<unsigned long long> generation{ 0 };
+};
+
+/* Output buffer for one additional render pass (AOV) of a CCSession.
+ * The combined pass lives in CCSession::pixels, all other registered
+ * passes get their own CCPass.
+ */
+class CCPass final {
+public:
+	ccl::PassType type;
+
+	/* Hold the pixel buffer for this pass. Gets updated by
+	 * CCSession::update_render_tile and CCSession::write_render_tile.
+	 */
+	float* pixels = nullptr;
+	unsigned int buffer_size{ 0 };
+	unsigned int buffer_stride{ 0 }; // number of float values for one pixel
+
+	int width{ 0 };
+	int height{ 0 };
+
+	/* Guard pixels. Each pass has its own mutex, so readers of one pass
+	 * don't hold up writers of another.
+	 */
+	ccl::thread_mutex pixels_mutex;
+
+	CCPass(ccl::PassType type_, unsigned int buffer_stride_)
+		: type{type_}, buffer_stride{buffer_stride_}
+	{  }
+
+	/* (Re)create pixels for given resolution. Caller holds pixels_mutex. */
+	void reset(int width, int height);
+
+	~CCPass() {
+		delete[] pixels;
+	}
+};
+
+/* Noise estimate for one tile, see CCConvergence. */
+struct CCTileConvergence {
+	int x{ 0 };
+	int y{ 0 };
+	int width{ 0 };
+	int height{ 0 };
+	/* Samples in the most recent update. */
+	int samples{ 0 };
+	/* Samples at the last checkpoint, and the luminance per pixel then. */
+	int checkpoint{ 0 };
+	std::vector<float> reference;
+	/* Estimated relative noise, FLT_MAX until the first checkpoint. */
+	float error{ FLT_MAX };
+	bool converged{ false };
+};
+
+/* Per-tile convergence tracking for adaptive sampling.
+ *
+ * Each time a tile has doubled its sample count since the last checkpoint
+ * its luminance is compared with the checkpoint. The difference between
+ * the mean of the first half of the samples and the mean of all of them,
+ * relative to the square root of the pixel value, estimates the remaining
+ * noise. A tile converges once the average over its pixels is below
+ * threshold, with at least min_samples taken.
+ */
+class CCConvergence final {
+public:
+	/* Set the error below which a tile counts as converged, 0 disables
+	 * adaptive sampling, and the samples a tile gets at least.
+	 */
+	void set_params(float threshold_, int min_samples_);
+
+	/* Forget all tiles, for a new render of width x height. */
+	void reset(int width_, int height_);
+
+	/* Feed tile pixels (RGBA, rows as Cycles has them) after samples.
+	 * Returns true when this update made the whole image converged.
+	 */
+	bool update(const float* tile_pixels, int tilex, int tiley, int tile_width, int tile_height, int samples);
+
+	/* Copy up to max_tiles tile states to tiles, returns the number copied. */
+	unsigned int get_tiles(cycles_tile_info* tiles, unsigned int max_tiles);
+
+private:
+	ccl::thread_mutex mutex;
+	float threshold{ 0.0f };
+	int min_samples{ 16 };
+	int width{ 0 };
+	int height{ 0 };
+	/* Keyed by tile y * width + x. */
+	std::map<size_t, CCTileConvergence> tiles;
+	size_t converged_pixels{ 0 };
+	bool all_converged{ false };
+};
+
+/* Bounded multi-producer queue of session events. Render threads push
+ * without locking, the polling thread pops. Same ring as the Logger uses.
+ */
+class CCEventQueue final {
+public:
+	static const size_t QUEUE_SIZE{ 1024 };
+
+	CCEventQueue();
+	~CCEventQueue();
+
+	/* Add event, dropping it when the queue is full. */
+	void push(const cycles_session_event& event);
+	/* Take up to max_events oldest events, returns the number taken. Only
+	 * one thread may pop at a time.
+	 */
+	unsigned int pop(cycles_session_event* events, unsigned int max_events);
+
+	std::atomic<unsigned int> dropped{ 0 };
+
+private:
+	static const size_t QUEUE_MASK{ QUEUE_SIZE - 1 };
+
+	struct Entry {
+		std::atomic<size_t> seq;
+		cycles_session_event event;
+	};
+
+	Entry* queue;
+	std::atomic<size_t> enqueue_pos{ 0 };
+	size_t dequeue_pos{ 0 };
+	ccl::thread_mutex pop_mutex;
+};
+
+/* Latest progress of a session behind a sequence lock: readers never block,
+ * they retry when an update happened while copying.
+ */
+class CCProgressSnapshot final {
+public:
+	/* Publish snapshot. Writers are serialized. */
+	void write(const cycles_progress_snapshot& snapshot);
+	/* Copy out the latest snapshot. */
+	void read(cycles_progress_snapshot& snapshot) const;
+
+private:
+	std::atomic<unsigned int> seq{ 0 };
+	cycles_progress_snapshot data{};
+	ccl::thread_mutex write_mutex;
+};
+
+/* Un-normalized render buffer contents of a session, all passes as Cycles
+ * accumulates them, with the number of samples in each pixel. Kept only
+ * when asked for with cycles_session_set_keep_raw_buffer. Rows top to
+ * bottom like the session pixels.
+ */
+class CCRawBuffer final {
+public:
+	bool enabled{ false };
+	int width{ 0 };
+	int height{ 0 };
+	/* Floats per pixel, BufferParams::get_passes_size. */
+	int pass_stride{ 0 };
+	std::vector<float> data;
+	std::vector<unsigned int> samples;
+
+	ccl::thread_mutex mutex;
+
+	/* Resize for a width x height render, clearing all data. Caller holds
+	 * mutex.
+	 */
+	void reset(int width_, int height_, int pass_stride_);
+
+	/* Copy the area of tile at regionx, regiony of the render region from
+	 * the tile buffers. Caller holds mutex.
+	 */
+	void copy_tile(ccl::RenderTile& tile, int regionx, int regiony);
+};
+
+/* Add the raw buffer src with src_samples to dst and dst_samples, both
+ * pixel_count pixels of pass_stride floats.
+ */
+void merge_raw_buffers(float* dst, unsigned int* dst_samples, const float* src, const unsigned int* src_samples, size_t pixel_count, unsigned int pass_stride);
+
+/* Counters behind cycles_session_get_stats. The tile path only touches
+ * atomics, the status based sync timing has its own lock.
+ */
+class CCSessionStats final {
+public:
+	CCSessionStats() {
+		reset();
+	}
+
+	/* Start over, for a new render. */
+	void reset();
+
+	/* A tile took seconds to render. */
+	void add_tile_time(double seconds);
+	/* copy_pixels_to_ccsession took seconds, of which lock_wait waiting
+	 * for pixels_mutex.
+	 */
+	void add_copy_time(double seconds, double lock_wait);
+	/* Status changed to status at total_time seconds into the session.
+	 * Time since the previous change gets attributed to the previous status.
+	 */
+	void status_changed(const string& status, double total_time);
+
+	/* Fill the ccycles side of stats. */
+	void get(cycles_session_stats* stats);
+
+	/* Bumped by reset, so per thread tile timing can tell renders apart. */
+	std::atomic<unsigned int> generation{ 0 };
+
+private:
+	std::atomic<unsigned int> tiles{ 0 };
+	std::atomic<unsigned long long> tile_time_us{ 0 };
+	std::atomic<unsigned long long> tile_time_max_us{ 0 };
+	std::atomic<unsigned int> histogram[CCYCLES_TILE_HISTOGRAM_SIZE];
+	std::atomic<unsigned long long> copy_time_us{ 0 };
+	std::atomic<unsigned long long> lock_wait_us{ 0 };
+
+	ccl::thread_mutex sync_mutex;
+	string current_status;
+	double status_start{ 0.0 };
+	double image_time{ 0.0 };
+	double shader_time{ 0.0 };
+	double mesh_time{ 0.0 };
+};
+
+class CCSession;
+
+/* Arguments of one render tile callback. */
+struct CCTileNotification {
+	/* Write tile callback, update tile callback otherwise. */
+	bool write;
+	int x;
+	int y;
+	int width;
+	int height;
+	int start_sample;
+	int num_samples;
+	int sample;
+	int resolution;
+};
+
+/* Calls the client callbacks of a session from its own thread, at most
+ * rate times per second. Render threads only post what happened: tile
+ * notifications for the same tile replace each other, display updates
+ * and status updates collapse into one. Render threads never wait for
+ * client code this way.
+ */
+class CCDispatcher final {
+public:
+	explicit CCDispatcher(CCSession* owner_)
+		: owner{ owner_ }
+	{  }
+
+	~CCDispatcher() {
+		stop();
+	}
+
+	/* Deliver at most rate times per second, starting the thread. 0 stops
+	 * it after delivering what's pending.
+	 */
+	void set_rate(float rate);
+
+	/* Queue a notification. Return false when the dispatcher isn't running,
+	 * the caller should call the client directly then.
+	 */
+	bool post_tile(const CCTileNotification& tile);
+	bool post_display(int sample);
+	bool post_status();
+
+	/* Wait until everything posted so far got delivered. */
+	void flush();
+
+	/* Deliver what's pending and end the thread. Called from a callback
+	 * the thread is left to end by itself instead, and may be destroyed
+	 * right after, as destroying the session from a callback does.
+	 */
+	void stop();
+
+private:
+	void run();
+	/* Call the client with all pending notifications. Lock is held on
+	 * entry and exit, but not during the calls. Return false, without the
+	 * lock, when a callback stopped the dispatcher.
+	 */
+	bool deliver(std::unique_lock<std::mutex>& lock);
+	bool pending() const;
+
+	CCSession* owner;
+
+	std::thread thread;
+	/* Serializes starting and stopping the thread. */
+	std::mutex control_mutex;
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::condition_variable idle;
+	bool running{ false };
+	bool stopping{ false };
+	bool flushing{ false };
+	bool delivering{ false };
+	std::chrono::duration<double> interval{ 0.0 };
+
+	/* Keyed by kind and tile corner. */
+	std::map<unsigned long long, CCTileNotification> tiles;
+	int display_sample{ -1 };
+	bool status{ false };
+};
+
+/* Session parameters as kept by the API: the Cycles ones plus those only
+ * ccycles acts on.
+ */
+struct CCSessionParams : public ccl::SessionParams {
+	/* Wall clock budget in seconds, 0 for none. See
+	 * cycles_session_params_set_time_limit.
+	 */
+	double time_limit{ 0.0 };
 };
 
 class CCSession final {
@@ -135,6 +1009,8 @@ public:
 	unsigned int id{ 0 };
 	ccl::SessionParams params;
 	ccl::Session* session = nullptr;
+	/* Started and not waited for yet. */
+	bool running{ false };
 
 	/* The status update handler for ccl::Session update callback.
 	 */
@@ -153,6 +1029,13 @@ public:
 	 */
 	void CCSession::display_update(int sample);
 
+	/* Callbacks registered through the API, nullptr when not set. */
+	STATUS_UPDATE_CB status_cb{ nullptr };
+	TEST_CANCEL_CB cancel_cb{ nullptr };
+	RENDER_TILE_CB update_tile_cb{ nullptr };
+	RENDER_TILE_CB write_tile_cb{ nullptr };
+	DISPLAY_UPDATE_CB display_update_cb{ nullptr };
+
 	/* Hold the pixel buffer with the final result for the attached session.
 	 * Gets updated by update_render_tile and write_render_tile.
 	 */
@@ -163,6 +1046,89 @@ public:
 	int width{ 0 };
 	int height{ 0 };
 
+	/* Format readers get pixels in, set with cycles_session_set_buffer_format. */
+	buffer_format format{ buffer_format::FLOAT };
+	/* pixels converted to format. Stays nullptr for FLOAT, then pixels gets
+	 * published as is.
+	 */
+	unsigned char* converted = nullptr;
+
+	/* Published snapshots of pixels for readers. */
+	CCDisplayBuffer display;
+
+	/* Convert rect of pixels to format and publish it. Caller holds
+	 * pixels_mutex.
+	 */
+	void publish_rect(const CCRect& rect);
+	/* Convert all of pixels to format and publish it. Caller holds
+	 * pixels_mutex.
+	 */
+	void publish_all();
+	/* Switch to format, reallocating converted and display. Caller holds
+	 * pixels_mutex.
+	 */
+	void set_format(buffer_format format_);
+
+	/* Adaptive sampling state, set up with cycles_session_set_adaptive_sampling. */
+	CCConvergence convergence;
+
+	/* Progress events and snapshot, read with cycles_session_poll_events
+	 * and cycles_session_get_progress_snapshot.
+	 */
+	CCEventQueue events;
+	CCProgressSnapshot snapshot;
+	/* State for spotting changes in update_progress, which runs from
+	 * status_update (serialized by ccl::Progress) and after wait. Reset
+	 * clears the flags from the client thread.
+	 */
+	string last_status;
+	string last_substatus;
+	/* When last_status started, in trace time. -1 when not tracing. */
+	long long status_trace_start{ -1 };
+	std::atomic<int> last_sample{ -1 };
+	std::atomic<bool> finished_sent{ false };
+	std::atomic<bool> error_sent{ false };
+
+	/* Queue an event of type for session. */
+	void push_event(session_event type, int x, int y, int width, int height);
+	/* Refresh snapshot from ccl::Session and queue events for what changed. */
+	void update_progress();
+
+	/* Timings for cycles_session_get_stats. */
+	CCSessionStats stats;
+
+	/* Delivers client callbacks when cycles_session_set_callback_rate is used. */
+	CCDispatcher dispatcher{ this };
+
+	/* Raw accumulation buffer for merging renders of several processes. */
+	CCRawBuffer raw;
+
+	/* Replace the render result with raw, normalized the way Cycles does
+	 * for a finished render. Used after importing merged raw data.
+	 */
+	void resolve_raw();
+
+	/* Wall clock budget in seconds from the session parameters, 0 for none. */
+	double time_limit{ 0.0 };
+	/* Samples asked for with the last reset or set_samples. The budget
+	 * never goes above this.
+	 */
+	int requested_samples{ 0 };
+	/* Sample count the budget last handed to ccl::Session::set_samples. */
+	int budget_samples{ 0 };
+	ccl::thread_mutex budget_mutex;
+
+	/* Fit the sample count to time_limit, using the time the passes so far
+	 * took. Called from status_update.
+	 */
+	void apply_time_limit();
+
+	/* Additional passes registered with cycles_session_add_pass. */
+	std::vector<CCPass*> passes;
+
+	/* Find the CCPass for type, nullptr if no such pass was registered. */
+	CCPass* find_pass(ccl::PassType type);
+
 	/* Create a new CCSession, initialise all necessary memory. */
 	static CCSession* create(int width, int height, unsigned int buffer_stride);
 
@@ -174,7 +1140,13 @@ public:
 	ccl::thread_mutex pixels_mutex;
 
 	~CCSession() {
+		/* No more client calls once the session is going away. */
+		dispatcher.stop();
 		delete[] pixels;
+		delete[] converted;
+		for (CCPass* pass : passes) {
+			delete pass;
+		}
 		delete session;
 	}
 
@@ -207,6 +1179,12 @@ struct CCShader {
 	ccl::ShaderGraph* graph = new ccl::ShaderGraph();
 	/* Map shader ID in scene to scene ID. */
 	std::map<unsigned int, unsigned int> scene_mapping;
+	/* Builtin images handed to texture nodes of graph, each holding a
+	 * reference in the image cache. Kept until graph goes, since Cycles
+	 * keeps the image slot of a node, and the CCImage as its builtin_data,
+	 * until the node is deleted.
+	 */
+	std::vector<CCImage*> images;
 };
 
 /********************************/
@@ -214,36 +1192,48 @@ struct CCShader {
 /********************************/
 
 #define SCENE_FIND(scid) \
-	if (0 <= (scid) && (scid) < scenes.size()) { \
-		ccl::Scene* sce = scenes[(scid)].scene; 
+	{ CCTRACE_API(); \
+	CCScene* ccscene = scenes.get(scid); \
+	if (ccscene != nullptr && ccscene->scene != nullptr) { \
+		ccl::Scene* sce = ccscene->scene;
 
-#define SCENE_FIND_END() }
+#define SCENE_FIND_END() } }
 
 #define SESSION_FIND(sid) \
-	if (0 <= (sid) && (sid) < sessions.size()) { \
-		CCSession* ccsess = sessions[sid]; \
-		ccl::Session* session = sessions[sid]->session;
-#define SESSION_FIND_END() }
+	{ CCTRACE_API(); \
+	CCSession* ccsess = sessions.find(sid); \
+	if (ccsess != nullptr) { \
+		ccl::Session* session = ccsess->session;
+#define SESSION_FIND_END() } }
+
+#define SHADER_FIND(shid) \
+	{ CCTRACE_API(); \
+	CCShader* sh = shaders.find(shid); \
+	if (sh != nullptr) {
+#define SHADER_FIND_END() } }
 
 /* Set boolean parameter varname of param_type. */
 #define PARAM_BOOL(param_type, params_id, varname) \
-	if (0 <= params_id && params_id < param_type.size()) { \
-		param_type[params_id].##varname = varname == 1; \
-		logger.logit(client_id, "Set " #param_type " " #varname " to ", varname); \
+	if (auto* param = param_type.get(params_id)) { \
+		CCTRACE_API(); \
+		param->varname = varname == 1; \
+		CCLOG_TRACE(client_id, "Set " #param_type " " #varname " to ", varname); \
 	}
 
 /* Set parameter varname of param_type. */
 #define PARAM(param_type, params_id, varname) \
-	if (0 <= params_id && params_id < param_type.size()) { \
-		param_type[params_id].##varname = varname; \
-		logger.logit(client_id, "Set " #param_type " " #varname " to ", varname); \
+	if (auto* param = param_type.get(params_id)) { \
+		CCTRACE_API(); \
+		param->varname = varname; \
+		CCLOG_TRACE(client_id, "Set " #param_type " " #varname " to ", varname); \
 	}
 
 /* Set parameter varname of param_type, casting to typecast*/
 #define PARAM_CAST(param_type, params_id, typecast, varname) \
-	if (0 <= params_id && params_id < param_type.size()) { \
-		param_type[params_id].##varname = static_cast<typecast>(varname); \
-		logger.logit(client_id, "Set " #param_type " " #varname " to ", varname, " casting to " #typecast); \
+	if (auto* param = param_type.get(params_id)) { \
+		CCTRACE_API(); \
+		param->varname = static_cast<typecast>(varname); \
+		CCLOG_TRACE(client_id, "Set " #param_type " " #varname " to ", varname, " casting to " #typecast); \
 	}
 
 #define LIGHT_FIND(scene_id, light_id) \
@@ -256,12 +1246,13 @@ struct CCShader {
 
 /* Set a var of shader to val of type. */
 #define SHADER_SET(shid, type, var, val) \
-	CCShader* sh = shaders[shid]; \
-	sh->shader->##var = (type)(val); \
-	logger.logit(client_id, "Set " #var " of shader ", shid, " to ", val, " casting to " #type);
+	SHADER_FIND(shid) \
+		sh->shader->##var = (type)(val); \
+		CCLOG_TRACE(client_id, "Set " #var " of shader ", shid, " to ", val, " casting to " #type); \
+	SHADER_FIND_END()
 
 #define SHADERNODE_FIND(shader_id, shnode_id) \
-	CCShader* sh = shaders[shader_id]; \
+	SHADER_FIND(shader_id) \
 	list<ccl::ShaderNode*>::iterator psh = sh->graph->nodes.begin(); \
 	while (psh != sh->graph->nodes.end()) \
 	{ \
@@ -271,4 +1262,5 @@ struct CCShader {
 			break; \
 		} \
 		++psh; \
-	}
\ No newline at end of file
+	} \
+	SHADER_FIND_END()
\ No newline at end of file
@@ -16,15 +16,16 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
 unsigned int cycles_create_light(unsigned int client_id, unsigned int scene_id, unsigned int light_shader_id)
 {
+	CCCAPTURE(cycles_create_light, client_id, scene_id, light_shader_id);
 	SCENE_FIND(scene_id)
 		ccl::Light* l = new ccl::Light();
 		l->shader = (int)light_shader_id;
 		sce->lights.push_back(l);
-		logger.logit(client_id, "Adding light ", sce->lights.size() - 1, " to scene ", scene_id, " using light shader ", light_shader_id);
+		CCLOG_TRACE(client_id, "Adding light ", sce->lights.size() - 1, " to scene ", scene_id, " using light shader ", light_shader_id);
 		return (unsigned int)(sce->lights.size() - 1);
 	SCENE_FIND_END()
 
@@ -34,126 +35,142 @@ unsigned int cycles_create_light(unsigned int client_id, unsigned int scene_id,
 /* type = 0: point, 1: sun, 2: background, 3: area, 4: spot, 5: triangle. */
 void cycles_light_set_type(unsigned int client_id, unsigned int scene_id, unsigned int light_id, light_type type)
 {
+	CCCAPTURE(cycles_light_set_type, client_id, scene_id, light_id, type);
 	LIGHT_FIND(scene_id, light_id)
 		l->type = (ccl::LightType)type;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " type to ", (unsigned int)type);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " type to ", (unsigned int)type);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_cast_shadow(unsigned int client_id, unsigned int scene_id, unsigned int light_id, unsigned int cast_shadow)
 {
+	CCCAPTURE(cycles_light_set_cast_shadow, client_id, scene_id, light_id, cast_shadow);
 	LIGHT_FIND(scene_id, light_id)
 		l->cast_shadow = cast_shadow == 1;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " cast_shadow to ", cast_shadow == 1 ? "true" : "false");
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " cast_shadow to ", cast_shadow == 1 ? "true" : "false");
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_use_mis(unsigned int client_id, unsigned int scene_id, unsigned int light_id, unsigned int use_mis)
 {
+	CCCAPTURE(cycles_light_set_use_mis, client_id, scene_id, light_id, use_mis);
 	LIGHT_FIND(scene_id, light_id)
 		l->use_mis = use_mis == 1;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " use_mis to ", use_mis == 1 ? "true" : "false");
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " use_mis to ", use_mis == 1 ? "true" : "false");
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_samples(unsigned int client_id, unsigned int scene_id, unsigned int light_id, unsigned int samples)
 {
+	CCCAPTURE(cycles_light_set_samples, client_id, scene_id, light_id, samples);
 	LIGHT_FIND(scene_id, light_id)
 		l->samples = samples;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " samples to ", samples);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " samples to ", samples);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_max_bounces(unsigned int client_id, unsigned int scene_id, unsigned int light_id, unsigned int max_bounces)
 {
+	CCCAPTURE(cycles_light_set_max_bounces, client_id, scene_id, light_id, max_bounces);
 	LIGHT_FIND(scene_id, light_id)
 		l->max_bounces = max_bounces;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " max_bounces to ", max_bounces);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " max_bounces to ", max_bounces);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_map_resolution(unsigned int client_id, unsigned int scene_id, unsigned int light_id, unsigned int map_resolution)
 {
+	CCCAPTURE(cycles_light_set_map_resolution, client_id, scene_id, light_id, map_resolution);
 	LIGHT_FIND(scene_id, light_id)
 		l->map_resolution = map_resolution;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " map_resolution to ", map_resolution);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " map_resolution to ", map_resolution);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_spot_angle(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float spot_angle)
 {
+	CCCAPTURE(cycles_light_set_spot_angle, client_id, scene_id, light_id, spot_angle);
 	LIGHT_FIND(scene_id, light_id)
 		l->spot_angle = spot_angle;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " spot_angel to ", spot_angle);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " spot_angel to ", spot_angle);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_spot_smooth(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float spot_smooth)
 {
+	CCCAPTURE(cycles_light_set_spot_smooth, client_id, scene_id, light_id, spot_smooth);
 	LIGHT_FIND(scene_id, light_id)
 		l->spot_smooth = spot_smooth;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " spot_smooth to ", spot_smooth);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " spot_smooth to ", spot_smooth);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_sizeu(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float sizeu)
 {
+	CCCAPTURE(cycles_light_set_sizeu, client_id, scene_id, light_id, sizeu);
 	LIGHT_FIND(scene_id, light_id)
 		l->sizeu = sizeu;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " sizeu to ", sizeu);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " sizeu to ", sizeu);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_sizev(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float sizev)
 {
+	CCCAPTURE(cycles_light_set_sizev, client_id, scene_id, light_id, sizev);
 	LIGHT_FIND(scene_id, light_id)
 		l->sizev = sizev;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " sizev to ", sizev);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " sizev to ", sizev);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_axisu(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float axisux, float axisuy, float axisuz)
 {
+	CCCAPTURE(cycles_light_set_axisu, client_id, scene_id, light_id, axisux, axisuy, axisuz);
 	LIGHT_FIND(scene_id, light_id)
 		l->axisu = ccl::make_float3(axisux, axisuy, axisuz);
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " axisu to ", axisux, ",", axisuy, ",", axisuz);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " axisu to ", axisux, ",", axisuy, ",", axisuz);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_axisv(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float axisvx, float axisvy, float axisvz)
 {
+	CCCAPTURE(cycles_light_set_axisv, client_id, scene_id, light_id, axisvx, axisvy, axisvz);
 	LIGHT_FIND(scene_id, light_id)
 		l->axisv = ccl::make_float3(axisvx, axisvy, axisvz);
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " axisv to ", axisvx, ",", axisvy, ",", axisvz);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " axisv to ", axisvx, ",", axisvy, ",", axisvz);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_size(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float size)
 {
+	CCCAPTURE(cycles_light_set_size, client_id, scene_id, light_id, size);
 	LIGHT_FIND(scene_id, light_id)
 		l->size = size;
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " size to ", size);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " size to ", size);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_dir(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float dirx, float diry, float dirz)
 {
+	CCCAPTURE(cycles_light_set_dir, client_id, scene_id, light_id, dirx, diry, dirz);
 	LIGHT_FIND(scene_id, light_id)
 		l->dir = ccl::make_float3(dirx, diry, dirz);
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " dir to ", dirx, ",", diry, ",", dirz);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " dir to ", dirx, ",", diry, ",", dirz);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_set_co(unsigned int client_id, unsigned int scene_id, unsigned int light_id, float cox, float coy, float coz)
 {
+	CCCAPTURE(cycles_light_set_co, client_id, scene_id, light_id, cox, coy, coz);
 	LIGHT_FIND(scene_id, light_id)
 		l->co = ccl::make_float3(cox, coy, coz);
-		logger.logit(client_id, "Setting light ", light_id, " of scene ", scene_id, " co to ", cox, ",", coy, ",", coz);
+		CCLOG_TRACE(client_id, "Setting light ", light_id, " of scene ", scene_id, " co to ", cox, ",", coy, ",", coz);
 	LIGHT_FIND_END()
 }
 
 void cycles_light_tag_update(unsigned int client_id, unsigned int scene_id, unsigned int light_id)
 {
+	CCCAPTURE(cycles_light_tag_update, client_id, scene_id, light_id);
 	LIGHT_FIND(scene_id, light_id)
 		l->tag_update(sce);
 	LIGHT_FIND_END()
@@ -0,0 +1,207 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <iostream>
+#include <sstream>
+
+#include "internal_types.h"
+
+extern std::vector<LOGGER_FUNC_CB> loggers;
+
+static const size_t RING_MASK{ Logger::RING_SIZE - 1 };
+static_assert((Logger::RING_SIZE & RING_MASK) == 0, "Logger::RING_SIZE must be a power of two");
+
+/* Set while this thread delivers messages. A logger callback logging again
+ * leaves its message to the drain already running.
+ */
+static thread_local bool draining_here{ false };
+
+Logger::Logger()
+{
+	ring = new Entry[RING_SIZE];
+	for (size_t i = 0; i < RING_SIZE; i++) {
+		ring[i].seq.store(i, std::memory_order_relaxed);
+	}
+}
+
+Logger::~Logger()
+{
+	/* Joining here could deadlock on the loader lock when the DLL gets
+	 * unloaded, cycles_shutdown is where the thread gets stopped properly.
+	 */
+	if (thread.joinable()) thread.detach();
+	else delete [] ring;
+}
+
+Logger::LocalBuffer& Logger::local_buffer()
+{
+	static thread_local LocalBuffer local;
+	return local;
+}
+
+/* Bounded multi-producer ring: a producer claims a position by bumping
+ * enqueue_pos, fills the entry and then publishes it through the entry
+ * sequence number. Only the drain thread consumes.
+ */
+void Logger::push(unsigned int level, unsigned int client_id, const char* msg, size_t length)
+{
+	if (!running.load(std::memory_order_acquire) && !draining_here) start();
+
+	Entry* entry;
+	size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+	for (;;) {
+		entry = &ring[pos & RING_MASK];
+		size_t seq = entry->seq.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		}
+		else if (diff < 0) {
+			/* Full, the drain thread is behind. */
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else {
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	entry->level = level;
+	entry->client_id = client_id;
+	entry->time = std::chrono::system_clock::now();
+	entry->length = length;
+	memcpy(entry->msg, msg, length);
+	entry->seq.store(pos + 1, std::memory_order_release);
+
+	if (running.load(std::memory_order_acquire)) {
+		if (sleeping.load(std::memory_order_relaxed)) wakeup.notify_one();
+		return;
+	}
+
+	/* A stop got in between, the drain thread may have gone before seeing
+	 * this entry. While the stop is still going its final drain picks the
+	 * entry up, after that nothing would, so deliver it here. Drains outside
+	 * the drain thread only happen under thread_mutex with no thread running.
+	 */
+	if (draining_here) return;
+	std::lock_guard<std::mutex> lock(thread_mutex);
+	if (!stopping && !running.load(std::memory_order_relaxed)) drain();
+}
+
+void Logger::start()
+{
+	std::lock_guard<std::mutex> lock(thread_mutex);
+	/* Messages while stopping go through the final drain of stop. */
+	if (running.load(std::memory_order_relaxed) || stopping) return;
+
+	thread = std::thread(&Logger::drain_thread, this);
+	running.store(true, std::memory_order_release);
+}
+
+void Logger::stop()
+{
+	/* Claim the thread, so of several callers only one joins it. */
+	std::thread stopped;
+	{
+		std::lock_guard<std::mutex> lock(thread_mutex);
+		if (!running.load(std::memory_order_relaxed)) return;
+		stopping = true;
+		running.store(false, std::memory_order_release);
+		stopped = std::move(thread);
+	}
+	wakeup.notify_one();
+	stopped.join();
+
+	/* Entries pushed after the drain thread last looked. */
+	std::lock_guard<std::mutex> lock(thread_mutex);
+	drain();
+	stopping = false;
+}
+
+void Logger::drain_thread()
+{
+	for (;;) {
+		if (drain()) continue;
+
+		std::unique_lock<std::mutex> lock(thread_mutex);
+		if (stopping) break;
+
+		/* Producers only notify when they see us sleeping, the timeout
+		 * covers a message that slipped in right before.
+		 */
+		sleeping.store(true, std::memory_order_relaxed);
+		wakeup.wait_for(lock, std::chrono::milliseconds(10));
+		sleeping.store(false, std::memory_order_relaxed);
+	}
+
+	drain();
+}
+
+/* Deliver all published entries, returns false if there were none. */
+bool Logger::drain()
+{
+	bool any{ false };
+	draining_here = true;
+
+	for (;;) {
+		Entry& entry = ring[dequeue_pos & RING_MASK];
+		if (entry.seq.load(std::memory_order_acquire) != dequeue_pos + 1) break;
+
+		/* std::ctime ends with a newline, leave it out. */
+		std::time_t ts = std::chrono::system_clock::to_time_t(entry.time);
+		string tsstr{ std::ctime(&ts) };
+		tsstr = tsstr.substr(0, tsstr.size() - 1);
+
+		deliver(entry.client_id, tsstr + ": " + string(entry.msg, entry.length));
+
+		entry.seq.store(dequeue_pos + RING_SIZE, std::memory_order_release);
+		dequeue_pos++;
+		any = true;
+	}
+
+	size_t lost = dropped.exchange(0, std::memory_order_relaxed);
+	if (lost > 0) {
+		std::stringstream msg;
+		msg << lost << " log messages dropped";
+
+		std::vector<LOGGER_FUNC_CB> funcs;
+		{
+			std::lock_guard<std::mutex> lock(loggers_mutex);
+			funcs = loggers;
+		}
+		for (LOGGER_FUNC_CB func : funcs) {
+			if (func) func(msg.str().c_str());
+		}
+		if (tostdout) std::cout << msg.str() << std::endl;
+	}
+
+	draining_here = false;
+	return any;
+}
+
+void Logger::deliver(unsigned int client_id, const string& msg)
+{
+	/* Call outside the lock, a callback may well call back into the API. */
+	LOGGER_FUNC_CB func{ nullptr };
+	{
+		std::lock_guard<std::mutex> lock(loggers_mutex);
+		if (client_id < loggers.size()) func = loggers[client_id];
+	}
+	if (func) func(msg.c_str());
+
+	// also print to std::cout if wanted
+	if (tostdout) std::cout << msg << std::endl;
+}
@@ -16,17 +16,20 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+#include "util_task.h"
+
+extern CCHandleTable<CCScene> scenes;
 
 unsigned int cycles_scene_add_mesh(unsigned int client_id, unsigned int scene_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_scene_add_mesh, client_id, scene_id, shader_id);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* mesh = new ccl::Mesh();
 		
 		mesh->used_shaders.push_back(shader_id);
 		sce->meshes.push_back(mesh);
 
-		logger.logit(client_id, "Add mesh ", sce->meshes.size() - 1, " in scene ", scene_id, " using default surface shader ", shader_id);
+		CCLOG_DEBUG(client_id, "Add mesh ", sce->meshes.size() - 1, " in scene ", scene_id, " using default surface shader ", shader_id);
 
 		return (unsigned int)(sce->meshes.size() - 1);
 	SCENE_FIND_END()
@@ -36,6 +39,7 @@ unsigned int cycles_scene_add_mesh(unsigned int client_id, unsigned int scene_id
 
 unsigned int cycles_scene_add_mesh_object(unsigned int client_id, unsigned int scene_id, unsigned int object_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_scene_add_mesh_object, client_id, scene_id, object_id, shader_id);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* mesh = new ccl::Mesh();
 		
@@ -45,7 +49,7 @@ unsigned int cycles_scene_add_mesh_object(unsigned int client_id, unsigned int s
 		mesh->used_shaders.push_back(shader_id);
 		sce->meshes.push_back(mesh);
 
-		logger.logit(client_id, "Add mesh ", sce->meshes.size() - 1, " to object ", object_id, " in scene ", scene_id, " using default surface shader ", shader_id);
+		CCLOG_DEBUG(client_id, "Add mesh ", sce->meshes.size() - 1, " to object ", object_id, " in scene ", scene_id, " using default surface shader ", shader_id);
 
 		return (unsigned int)(sce->meshes.size() - 1);
 	SCENE_FIND_END()
@@ -55,6 +59,7 @@ unsigned int cycles_scene_add_mesh_object(unsigned int client_id, unsigned int s
 
 void cycles_mesh_set_shader(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_mesh_set_shader, client_id, scene_id, mesh_id, shader_id);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 
@@ -79,6 +84,7 @@ void cycles_mesh_set_shader(unsigned int client_id, unsigned int scene_id, unsig
 
 void cycles_mesh_clear(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id)
 {
+	CCCAPTURE(cycles_mesh_clear, client_id, scene_id, mesh_id);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 		me->clear();
@@ -87,6 +93,7 @@ void cycles_mesh_clear(unsigned int client_id, unsigned int scene_id, unsigned i
 
 void cycles_mesh_tag_rebuild(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id)
 {
+	CCCAPTURE(cycles_mesh_tag_rebuild, client_id, scene_id, mesh_id);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 		me->tag_update(sce, true);
@@ -95,50 +102,195 @@ void cycles_mesh_tag_rebuild(unsigned int client_id, unsigned int scene_id, unsi
 
 void cycles_mesh_set_smooth(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, unsigned int smooth)
 {
+	CCCAPTURE(cycles_mesh_set_smooth, client_id, scene_id, mesh_id, smooth);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 		me->smooth.resize(me->triangles.size(), smooth == 1);
 	SCENE_FIND_END()
 }
 
+static void append_verts(ccl::Mesh* me, const float* verts, size_t vcount)
+{
+	size_t offset = me->verts.size();
+	me->verts.resize(offset + vcount);
+	ccl::float3* dst = me->verts.data() + offset;
+
+	for (size_t i = 0; i < vcount; i++) {
+		dst[i] = ccl::make_float3(verts[i * 3], verts[i * 3 + 1], verts[i * 3 + 2]);
+	}
+}
+
+/* Grow the per-face arrays once up front, add_triangle then only appends. */
+static void reserve_triangles(ccl::Mesh* me, size_t fcount)
+{
+	size_t count = me->triangles.size() + fcount;
+	me->triangles.reserve(count);
+	me->shader.reserve(count);
+	me->smooth.reserve(count);
+}
+
+static void append_tris(ccl::Mesh* me, const int* faces, size_t fcount, unsigned int shader_id, bool smooth)
+{
+	reserve_triangles(me, fcount);
+
+	for (size_t i = 0; i < fcount * 3; i += 3) {
+		me->add_triangle(faces[i], faces[i + 1], faces[i + 2], shader_id, smooth);
+	}
+}
+
+static void fill_uvs(ccl::Mesh* me, const float* uvs, size_t uvcount)
+{
+	ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_UV, ccl::ustring("uvmap"));
+	ccl::float3* fdata = attr->data_float3();
+
+	for (size_t i = 0; i < uvcount; i++) {
+		fdata[i] = ccl::make_float3(uvs[i * 2], uvs[i * 2 + 1], 0.0f);
+	}
+}
+
+static void fill_vertex_normals(ccl::Mesh* me, const float* vnormals, size_t vnormalcount)
+{
+	ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
+	ccl::float3* fdata = attr->data_float3();
+
+	for (size_t i = 0; i < vnormalcount; i++) {
+		fdata[i] = ccl::make_float3(vnormals[i * 3], vnormals[i * 3 + 1], vnormals[i * 3 + 2]);
+	}
+}
+
 void cycles_mesh_set_verts(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *verts, unsigned int vcount)
 {
+	CCCAPTURE(cycles_mesh_set_verts, client_id, scene_id, mesh_id, capture_array(verts, (size_t)vcount * 3), vcount);
+	SCENE_FIND(scene_id)
+		ccl::Mesh* me = sce->meshes[mesh_id];
+
+		append_verts(me, verts, vcount);
+		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+
+		CCLOG_DEBUG(client_id, "Set ", vcount, " verts on mesh ", mesh_id, " in scene ", scene_id);
+	SCENE_FIND_END()
+}
+
+void cycles_mesh_set_verts_float4(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *verts, unsigned int vcount)
+{
+	CCCAPTURE(cycles_mesh_set_verts_float4, client_id, scene_id, mesh_id, capture_array(verts, (size_t)vcount * 4), vcount);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 
-		ccl::float3 f3;
+		size_t offset = me->verts.size();
+		me->verts.resize(offset + vcount);
+		ccl::float3* dst = me->verts.data() + offset;
 
-		for (int i = 0; i < (int)vcount*3; i+=3) {
-			f3.x = verts[i];
-			f3.y = verts[i+1];
-			f3.z = verts[i+2];
-			logger.logit(client_id, "v: ", f3.x, ",", f3.y, ",", f3.z);
-			me->verts.push_back(f3);
+		/* With SSE float3 is padded to four floats, so the client layout is
+		 * the in-memory layout.
+		 */
+		if (sizeof(ccl::float3) == 4 * sizeof(float)) {
+			memcpy(dst, verts, vcount * sizeof(ccl::float3));
+		}
+		else {
+			for (size_t i = 0; i < vcount; i++) {
+				dst[i] = ccl::make_float3(verts[i * 4], verts[i * 4 + 1], verts[i * 4 + 2]);
+			}
 		}
 		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+
+		CCLOG_DEBUG(client_id, "Set ", vcount, " float4 verts on mesh ", mesh_id, " in scene ", scene_id);
 	SCENE_FIND_END()
 }
 
 void cycles_mesh_set_tris(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, int *faces, unsigned int fcount, unsigned int shader_id, unsigned int smooth)
 {
+	CCCAPTURE(cycles_mesh_set_tris, client_id, scene_id, mesh_id, capture_array(faces, (size_t)fcount * 3), fcount, shader_id, smooth);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 
 		//cycles_mesh_set_shader(client_id, scene_id, mesh_id, shader_id);
 
-		for (int i = 0; i < (int)fcount*3; i += 3) {
-			logger.logit(client_id, "f: ", faces[i], ",", faces[i + 1], ",", faces[i + 2]);
-			me->add_triangle(faces[i], faces[i + 1], faces[i + 2], shader_id, smooth == 1);
-		}
+		append_tris(me, faces, fcount, shader_id, smooth == 1);
 		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+
+		CCLOG_DEBUG(client_id, "Set ", fcount, " tris on mesh ", mesh_id, " in scene ", scene_id, " with shader ", shader_id);
 		
 		// TODO: APIfy next call, right now keep here to be closer to PoC plugin
 		//me->attributes.remove(ccl::ATTR_STD_VERTEX_NORMAL);
 	SCENE_FIND_END()
 }
 
+void cycles_mesh_set_tris_bulk(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, int *faces, unsigned int fcount, unsigned int *shader_ids, unsigned char *smooth)
+{
+	CCCAPTURE(cycles_mesh_set_tris_bulk, client_id, scene_id, mesh_id, capture_array(faces, (size_t)fcount * 3), fcount, capture_array(shader_ids, fcount), capture_array(smooth, fcount));
+	SCENE_FIND(scene_id)
+		ccl::Mesh* me = sce->meshes[mesh_id];
+
+		reserve_triangles(me, fcount);
+
+		for (size_t i = 0; i < fcount; i++) {
+			const int* f = &faces[i * 3];
+			me->add_triangle(f[0], f[1], f[2], shader_ids[i], smooth != nullptr && smooth[i] != 0);
+		}
+		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+
+		CCLOG_DEBUG(client_id, "Set ", fcount, " tris with per-face shaders on mesh ", mesh_id, " in scene ", scene_id);
+	SCENE_FIND_END()
+}
+
+/* Worker for cycles_scene_add_meshes_batch. Same order as a client doing
+ * the single calls: attributes are sized from the verts and tris already
+ * on the mesh.
+ */
+static void fill_mesh(ccl::Mesh* me, const cycles_mesh_desc* desc)
+{
+	if (desc->verts) append_verts(me, desc->verts, desc->vcount);
+	if (desc->faces) append_tris(me, desc->faces, desc->fcount, desc->shader_id, desc->smooth == 1);
+	if (desc->vnormals) fill_vertex_normals(me, desc->vnormals, desc->vnormalcount);
+	if (desc->uvs) fill_uvs(me, desc->uvs, desc->uvcount);
+	me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+}
+
+unsigned int cycles_scene_add_meshes_batch(unsigned int client_id, unsigned int scene_id, cycles_mesh_desc *descs, unsigned int count)
+{
+	CCCAPTURE(cycles_scene_add_meshes_batch, client_id, scene_id, capture_array(descs, count), count);
+	SCENE_FIND(scene_id)
+		/* Create new meshes before any worker starts, sce->meshes must not
+		 * grow while they run.
+		 */
+		for (unsigned int i = 0; i < count; i++) {
+			if (descs[i].mesh_id != UINT_MAX) continue;
+
+			ccl::Mesh* mesh = new ccl::Mesh();
+			mesh->used_shaders.push_back(descs[i].shader_id);
+			sce->meshes.push_back(mesh);
+			descs[i].mesh_id = (unsigned int)(sce->meshes.size() - 1);
+		}
+
+		unsigned int filled{ 0 };
+		size_t tris{ 0 };
+
+		ccl::TaskScheduler::init();
+		{
+			ccl::TaskPool pool;
+			for (unsigned int i = 0; i < count; i++) {
+				if (descs[i].mesh_id >= sce->meshes.size()) continue;
+
+				pool.push(function_bind(&fill_mesh, sce->meshes[descs[i].mesh_id], &descs[i]));
+				filled++;
+				tris += descs[i].faces ? descs[i].fcount : 0;
+			}
+			pool.wait_work();
+		}
+		ccl::TaskScheduler::exit();
+
+		CCLOG_DEBUG(client_id, "Filled ", filled, " meshes with ", tris, " tris in scene ", scene_id);
+
+		return filled;
+	SCENE_FIND_END()
+
+	return 0;
+}
+
 void cycles_mesh_add_triangle(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, unsigned int v0, unsigned int v1, unsigned int v2, unsigned int shader_id, unsigned int smooth)
 {
+	CCCAPTURE(cycles_mesh_add_triangle, client_id, scene_id, mesh_id, v0, v1, v2, shader_id, smooth);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 		me->add_triangle((int)v0, (int)v1, (int)v2, shader_id, smooth == 1);
@@ -147,40 +299,22 @@ void cycles_mesh_add_triangle(unsigned int client_id, unsigned int scene_id, uns
 
 void cycles_mesh_set_uvs(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *uvs, unsigned int uvcount)
 {
+	CCCAPTURE(cycles_mesh_set_uvs, client_id, scene_id, mesh_id, capture_array(uvs, (size_t)uvcount * 2), uvcount);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 
-		ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_UV, ccl::ustring("uvmap"));
-		ccl::float3* fdata = attr->data_float3();
-
-		ccl::float3 f3;
-
-		for (int i = 0, j = 0; i < (int)uvcount * 2; i += 2, j++) {
-			f3.x = uvs[i];
-			f3.y = uvs[i + 1];
-			f3.z = 0.0f;
-			fdata[j] = f3;
-		}
+		fill_uvs(me, uvs, uvcount);
 		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
 	SCENE_FIND_END()
 }
 
 void cycles_mesh_set_vertex_normals(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, float *vnormals, unsigned int vnormalcount)
 {
+	CCCAPTURE(cycles_mesh_set_vertex_normals, client_id, scene_id, mesh_id, capture_array(vnormals, (size_t)vnormalcount * 3), vnormalcount);
 	SCENE_FIND(scene_id)
 		ccl::Mesh* me = sce->meshes[mesh_id];
 
-		ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
-		ccl::float3* fdata = attr->data_float3();
-
-		ccl::float3 f3;
-
-		for (int i = 0, j = 0; i < (int)vnormalcount * 3; i += 3, j++) {
-			f3.x = vnormals[i];
-			f3.y = vnormals[i + 1];
-			f3.z = vnormals[i + 2];
-			fdata[j] = f3;
-		}
+		fill_vertex_normals(me, vnormals, vnormalcount);
 		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
 	SCENE_FIND_END()
 }
\ No newline at end of file
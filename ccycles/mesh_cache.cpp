@@ -0,0 +1,362 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include "internal_types.h"
+
+#include "mesh_cache_format.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+extern CCHandleTable<CCScene> scenes;
+
+/* Read-only view of a whole file. */
+class MappedFile final {
+public:
+	const unsigned char* data{ nullptr };
+	size_t size{ 0 };
+
+	explicit MappedFile(const char* path)
+	{
+#if defined(_WIN32)
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return;
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return;
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) return;
+
+		data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data != nullptr) size = (size_t)file_size.QuadPart;
+#else
+		fd = open(path, O_RDONLY);
+		if (fd < 0) return;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0) return;
+
+		void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED) return;
+
+		madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+		data = (const unsigned char*)view;
+		size = (size_t)st.st_size;
+#endif
+	}
+
+	~MappedFile()
+	{
+#if defined(_WIN32)
+		if (data != nullptr) UnmapViewOfFile(data);
+		if (mapping != nullptr) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+		if (data != nullptr) munmap((void*)data, size);
+		if (fd >= 0) close(fd);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+#if defined(_WIN32)
+	HANDLE file{ INVALID_HANDLE_VALUE };
+	HANDLE mapping{ nullptr };
+#else
+	int fd{ -1 };
+#endif
+};
+
+/* Arrays of a mesh cache file, after checking they lie inside the file. */
+struct MeshCacheView {
+	const void* data[(unsigned int)mesh_cache_array::COUNT];
+	size_t count[(unsigned int)mesh_cache_array::COUNT];
+
+	template <typename T>
+	const T* get(mesh_cache_array a) const { return (const T*)data[(unsigned int)a]; }
+	size_t size(mesh_cache_array a) const { return count[(unsigned int)a]; }
+};
+
+static bool read_mesh_cache(unsigned int client_id, const char* path, const MappedFile& file, MeshCacheView& view)
+{
+	view = MeshCacheView{};
+
+	if (file.size < sizeof(MeshCacheHeader)) {
+		CCLOG_ERROR(client_id, path, " is not a mesh cache file");
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memcpy(&header, file.data, sizeof(header));
+	if (header.magic != MESH_CACHE_MAGIC) {
+		CCLOG_ERROR(client_id, path, " is not a mesh cache file");
+		return false;
+	}
+	if (header.version != MESH_CACHE_VERSION) {
+		CCLOG_ERROR(client_id, path, " has mesh cache version ", header.version, ", expected ", MESH_CACHE_VERSION);
+		return false;
+	}
+	if (header.array_count > (file.size - sizeof(header)) / sizeof(MeshCacheArray)) {
+		CCLOG_ERROR(client_id, path, " is truncated");
+		return false;
+	}
+
+	unsigned int known = std::min(header.array_count, (unsigned int)mesh_cache_array::COUNT);
+	for (unsigned int i = 0; i < known; i++) {
+		MeshCacheArray a;
+		memcpy(&a, file.data + sizeof(header) + i * sizeof(MeshCacheArray), sizeof(a));
+		if (a.count == 0) continue;
+
+		if (a.element_size != mesh_cache_element_size[i] || a.offset % MESH_CACHE_ALIGN != 0 ||
+			a.offset > file.size || a.count > (file.size - a.offset) / a.element_size) {
+			CCLOG_ERROR(client_id, path, " has a bad entry for array ", i);
+			return false;
+		}
+
+		view.data[i] = file.data + a.offset;
+		view.count[i] = (size_t)a.count;
+	}
+
+	size_t vcount = view.size(mesh_cache_array::VERTS);
+	size_t tcount = view.size(mesh_cache_array::TRIANGLES);
+	size_t normals = view.size(mesh_cache_array::VERTEX_NORMALS);
+	size_t uvs = view.size(mesh_cache_array::UVS);
+	if (view.size(mesh_cache_array::SHADERS) != tcount || view.size(mesh_cache_array::SMOOTH) != tcount ||
+		(normals != 0 && normals != vcount) || (uvs != 0 && uvs != tcount * 3)) {
+		CCLOG_ERROR(client_id, path, " has arrays of mismatching size");
+		return false;
+	}
+
+	const int* tris = view.get<int>(mesh_cache_array::TRIANGLES);
+	for (size_t i = 0; i < tcount * 3; i++) {
+		if (tris[i] < 0 || (size_t)tris[i] >= vcount) {
+			CCLOG_ERROR(client_id, path, " has triangle ", i / 3, " using a vertex out of range");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Shader ids index the scene shaders, a file written for another scene may
+ * use ids this one doesn't have.
+ */
+static bool check_shader_ids(unsigned int client_id, const char* path, const unsigned int* ids, size_t count, size_t shader_count)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (ids[i] >= shader_count) {
+			CCLOG_ERROR(client_id, path, " uses shader ", ids[i], ", the scene has ", shader_count);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* x,y,z,0 quadruplets to float3. With SSE float3 is padded to four floats,
+ * so this is a plain copy.
+ */
+static void copy_float3(ccl::float3* dst, const float* src, size_t count)
+{
+	if (sizeof(ccl::float3) == 4 * sizeof(float)) {
+		memcpy(dst, src, count * sizeof(ccl::float3));
+	}
+	else {
+		for (size_t i = 0; i < count; i++) {
+			dst[i] = ccl::make_float3(src[i * 4], src[i * 4 + 1], src[i * 4 + 2]);
+		}
+	}
+}
+
+unsigned int cycles_mesh_load_binary(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, const char* path)
+{
+	CCCAPTURE(cycles_mesh_load_binary, client_id, scene_id, mesh_id, path);
+	SCENE_FIND(scene_id)
+		CCTRACE("mesh", "load_binary");
+
+		if (mesh_id >= sce->meshes.size()) return 0;
+		ccl::Mesh* me = sce->meshes[mesh_id];
+
+		MappedFile file(path);
+		if (file.data == nullptr) {
+			CCLOG_ERROR(client_id, "Can't map ", path);
+			return 0;
+		}
+
+		MeshCacheView view;
+		if (!read_mesh_cache(client_id, path, file, view)) return 0;
+
+		static_assert(sizeof(ccl::Mesh::Triangle) == 3 * sizeof(int), "mesh cache triangles don't match ccl::Mesh::Triangle");
+
+		size_t vcount = view.size(mesh_cache_array::VERTS);
+		size_t tcount = view.size(mesh_cache_array::TRIANGLES);
+
+		if (!check_shader_ids(client_id, path, view.get<unsigned int>(mesh_cache_array::SHADERS), tcount, sce->shaders.size()) ||
+			!check_shader_ids(client_id, path, view.get<unsigned int>(mesh_cache_array::USED_SHADERS), view.size(mesh_cache_array::USED_SHADERS), sce->shaders.size())) {
+			return 0;
+		}
+
+		me->clear();
+
+		const unsigned int* used = view.get<unsigned int>(mesh_cache_array::USED_SHADERS);
+		me->used_shaders.assign(used, used + view.size(mesh_cache_array::USED_SHADERS));
+
+		me->verts.resize(vcount);
+		copy_float3(me->verts.data(), view.get<float>(mesh_cache_array::VERTS), vcount);
+
+		me->triangles.resize(tcount);
+		if (tcount > 0) memcpy(me->triangles.data(), view.get<int>(mesh_cache_array::TRIANGLES), tcount * sizeof(ccl::Mesh::Triangle));
+
+		const unsigned int* shader = view.get<unsigned int>(mesh_cache_array::SHADERS);
+		me->shader.assign(shader, shader + tcount);
+		const unsigned char* smooth = view.get<unsigned char>(mesh_cache_array::SMOOTH);
+		me->smooth.assign(smooth, smooth + tcount);
+
+		/* Attributes are sized from the verts and tris, so they come last. */
+		if (view.size(mesh_cache_array::VERTEX_NORMALS) > 0) {
+			ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_VERTEX_NORMAL);
+			copy_float3(attr->data_float3(), view.get<float>(mesh_cache_array::VERTEX_NORMALS), vcount);
+		}
+		if (view.size(mesh_cache_array::UVS) > 0) {
+			ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_UV, ccl::ustring("uvmap"));
+			copy_float3(attr->data_float3(), view.get<float>(mesh_cache_array::UVS), tcount * 3);
+		}
+
+		me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+
+		CCLOG_DEBUG(client_id, "Loaded ", vcount, " verts and ", tcount, " tris from ", path, " into mesh ", mesh_id, " in scene ", scene_id);
+		return 1;
+	SCENE_FIND_END()
+
+	return 0;
+}
+
+/* Array data of one entry, written at the next aligned offset. */
+struct MeshCacheWriteArray {
+	const void* data;
+	size_t count;
+};
+
+/* float3 array as x,y,z,0 quadruplets, copied only when float3 isn't padded. */
+static MeshCacheWriteArray float3_array(const ccl::float3* src, size_t count, vector<float>& scratch)
+{
+	if (sizeof(ccl::float3) == 4 * sizeof(float)) return MeshCacheWriteArray{ src, count };
+
+	scratch.resize(count * 4);
+	for (size_t i = 0; i < count; i++) {
+		scratch[i * 4] = src[i].x;
+		scratch[i * 4 + 1] = src[i].y;
+		scratch[i * 4 + 2] = src[i].z;
+		scratch[i * 4 + 3] = 0.0f;
+	}
+	return MeshCacheWriteArray{ scratch.data(), count };
+}
+
+/* The attribute if it has one float3 per expected element. */
+static const ccl::float3* float3_attribute(ccl::Mesh* me, ccl::AttributeStandard std, size_t count)
+{
+	ccl::Attribute* attr = me->attributes.find(std);
+	if (attr == nullptr || count == 0 || attr->buffer.size() != count * sizeof(ccl::float3)) return nullptr;
+	return attr->data_float3();
+}
+
+unsigned int cycles_mesh_save_binary(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id, const char* path)
+{
+	SCENE_FIND(scene_id)
+		CCTRACE("mesh", "save_binary");
+
+		if (mesh_id >= sce->meshes.size()) return 0;
+		ccl::Mesh* me = sce->meshes[mesh_id];
+
+		size_t vcount = me->verts.size();
+		size_t tcount = me->triangles.size();
+
+		vector<float> verts_scratch, normals_scratch, uvs_scratch;
+		vector<unsigned char> smooth(me->smooth.begin(), me->smooth.end());
+		smooth.resize(tcount, 0);
+		vector<unsigned int> shader(me->shader.begin(), me->shader.end());
+		shader.resize(tcount, me->used_shaders.empty() ? 0 : me->used_shaders[0]);
+
+		MeshCacheWriteArray arrays[(unsigned int)mesh_cache_array::COUNT]{};
+		arrays[(unsigned int)mesh_cache_array::VERTS] = float3_array(me->verts.data(), vcount, verts_scratch);
+		arrays[(unsigned int)mesh_cache_array::TRIANGLES] = MeshCacheWriteArray{ me->triangles.data(), tcount };
+		arrays[(unsigned int)mesh_cache_array::SHADERS] = MeshCacheWriteArray{ shader.data(), tcount };
+		arrays[(unsigned int)mesh_cache_array::SMOOTH] = MeshCacheWriteArray{ smooth.data(), tcount };
+		arrays[(unsigned int)mesh_cache_array::USED_SHADERS] = MeshCacheWriteArray{ me->used_shaders.data(), me->used_shaders.size() };
+
+		if (const ccl::float3* normals = float3_attribute(me, ccl::ATTR_STD_VERTEX_NORMAL, vcount)) {
+			arrays[(unsigned int)mesh_cache_array::VERTEX_NORMALS] = float3_array(normals, vcount, normals_scratch);
+		}
+		if (const ccl::float3* uvs = float3_attribute(me, ccl::ATTR_STD_UV, tcount * 3)) {
+			arrays[(unsigned int)mesh_cache_array::UVS] = float3_array(uvs, tcount * 3, uvs_scratch);
+		}
+
+		MeshCacheHeader header{ MESH_CACHE_MAGIC, MESH_CACHE_VERSION, (unsigned int)mesh_cache_array::COUNT, 0 };
+		MeshCacheArray entries[(unsigned int)mesh_cache_array::COUNT]{};
+
+		unsigned long long offset = sizeof(header) + sizeof(entries);
+		for (unsigned int i = 0; i < (unsigned int)mesh_cache_array::COUNT; i++) {
+			if (arrays[i].count == 0) continue;
+			offset = (offset + MESH_CACHE_ALIGN - 1) / MESH_CACHE_ALIGN * MESH_CACHE_ALIGN;
+			entries[i] = MeshCacheArray{ offset, arrays[i].count, mesh_cache_element_size[i], 0 };
+			offset += arrays[i].count * mesh_cache_element_size[i];
+		}
+
+		std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!out) {
+			CCLOG_ERROR(client_id, "Can't write ", path);
+			return 0;
+		}
+
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)entries, sizeof(entries));
+
+		static const char padding[MESH_CACHE_ALIGN]{};
+		unsigned long long written = sizeof(header) + sizeof(entries);
+		for (unsigned int i = 0; i < (unsigned int)mesh_cache_array::COUNT; i++) {
+			if (arrays[i].count == 0) continue;
+			out.write(padding, (std::streamsize)(entries[i].offset - written));
+			out.write((const char*)arrays[i].data, (std::streamsize)(arrays[i].count * mesh_cache_element_size[i]));
+			written = entries[i].offset + arrays[i].count * mesh_cache_element_size[i];
+		}
+
+		out.close();
+		if (!out) {
+			CCLOG_ERROR(client_id, "Failed writing ", path);
+			return 0;
+		}
+
+		CCLOG_DEBUG(client_id, "Saved mesh ", mesh_id, " in scene ", scene_id, " with ", vcount, " verts and ", tcount, " tris to ", path);
+		return 1;
+	SCENE_FIND_END()
+
+	return 0;
+}
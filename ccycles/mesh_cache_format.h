@@ -0,0 +1,88 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+
+#ifndef __MESH_CACHE_FORMAT__H__
+#define __MESH_CACHE_FORMAT__H__
+
+/* Binary mesh file written by cycles_mesh_save_binary and read by
+ * cycles_mesh_load_binary.
+ *
+ * The file starts with a MeshCacheHeader followed by array_count
+ * MeshCacheArray entries, indexed by mesh_cache_array. Each entry gives
+ * where the array data is, how many elements it has and the size of one
+ * element. Array data starts at a multiple of MESH_CACHE_ALIGN. An array
+ * with count 0 isn't in the file.
+ *
+ * The element layouts are the in-memory layouts of the Cycles mesh, so a
+ * mapped file can be copied into a mesh array by array:
+ *
+ *   VERTS           x,y,z,0 as floats per vertex
+ *   TRIANGLES       three vertex indices as ints per triangle
+ *   SHADERS         scene shader id as unsigned int per triangle
+ *   SMOOTH          1 or 0 as unsigned char per triangle
+ *   VERTEX_NORMALS  x,y,z,0 as floats per vertex
+ *   UVS             u,v,0,0 as floats per triangle corner
+ *   USED_SHADERS    scene shader ids as unsigned int, the shaders of the mesh
+ *
+ * Arrays added later get appended to mesh_cache_array, readers skip entries
+ * they don't know. MESH_CACHE_VERSION changes when existing arrays change.
+ *
+ * Values are in host byte order.
+ */
+
+static const unsigned int MESH_CACHE_MAGIC{ 0x434d4343 }; /* "CCMC" */
+static const unsigned int MESH_CACHE_VERSION{ 1 };
+static const unsigned int MESH_CACHE_ALIGN{ 16 };
+
+enum class mesh_cache_array : unsigned int {
+	VERTS,
+	TRIANGLES,
+	SHADERS,
+	SMOOTH,
+	VERTEX_NORMALS,
+	UVS,
+	USED_SHADERS,
+	COUNT
+};
+
+struct MeshCacheHeader {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int array_count;
+	unsigned int reserved;
+};
+
+struct MeshCacheArray {
+	/** Byte offset from the start of the file. */
+	unsigned long long offset;
+	unsigned long long count;
+	unsigned int element_size;
+	unsigned int reserved;
+};
+
+/* Element size of each array in this version. */
+static const unsigned int mesh_cache_element_size[(unsigned int)mesh_cache_array::COUNT] = {
+	4 * sizeof(float),
+	3 * sizeof(int),
+	sizeof(unsigned int),
+	sizeof(unsigned char),
+	4 * sizeof(float),
+	4 * sizeof(float),
+	sizeof(unsigned int),
+};
+
+#endif
@@ -14,19 +14,22 @@ See the License for the specific language governing permissions and
 limitations under the License.
 **/
 
+#include <unordered_map>
+
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
 unsigned int cycles_scene_add_object(unsigned int client_id, unsigned int scene_id)
 {
+	CCCAPTURE(cycles_scene_add_object, client_id, scene_id);
 	SCENE_FIND(scene_id)
 		ccl::Object* ob = new ccl::Object();
 		// TODO: APIfy object matrix setting, for now hard-code to be closer to PoC plugin
 		ob->tfm = ccl::transform_identity();
 		sce->objects.push_back(ob);
 
-		logger.logit(client_id, "Added object ", sce->objects.size() - 1, " to scene ", scene_id);
+		CCLOG_DEBUG(client_id, "Added object ", sce->objects.size() - 1, " to scene ", scene_id);
 
 		ob->tag_update(sce);
 
@@ -38,6 +41,7 @@ unsigned int cycles_scene_add_object(unsigned int client_id, unsigned int scene_
 
 void cycles_scene_object_set_mesh(unsigned int client_id, unsigned int scene_id, unsigned int object_id, unsigned int mesh_id)
 {
+	CCCAPTURE(cycles_scene_object_set_mesh, client_id, scene_id, object_id, mesh_id);
 	SCENE_FIND(scene_id)
 		ccl::Object* ob = sce->objects[object_id];
 		ccl::Mesh* me = sce->meshes[mesh_id];
@@ -46,8 +50,80 @@ void cycles_scene_object_set_mesh(unsigned int client_id, unsigned int scene_id,
 	SCENE_FIND_END()
 }
 
+unsigned int cycles_scene_add_mesh_instance(unsigned int client_id, unsigned int scene_id, unsigned int mesh_id,
+	float a, float b, float c, float d,
+	float e, float f, float g, float h,
+	float i, float j, float k, float l,
+	float m, float n, float o, float p
+	)
+{
+	CCCAPTURE(cycles_scene_add_mesh_instance, client_id, scene_id, mesh_id, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
+	SCENE_FIND(scene_id)
+		if (mesh_id >= sce->meshes.size()) return UINT_MAX;
+
+		ccl::Object* ob = new ccl::Object();
+		ob->mesh = sce->meshes[mesh_id];
+		ob->tfm = ccl::make_transform(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
+		sce->objects.push_back(ob);
+
+		CCLOG_DEBUG(client_id, "Added instance ", sce->objects.size() - 1, " of mesh ", mesh_id, " to scene ", scene_id);
+
+		ob->tag_update(sce);
+
+		return (unsigned int)(sce->objects.size() - 1);
+	SCENE_FIND_END()
+
+	return UINT_MAX;
+}
+
+/* Bytes of geometry data held by me, as it gets uploaded to the device. */
+static unsigned long long mesh_data_size(const ccl::Mesh* me)
+{
+	unsigned long long size = 0;
+
+	size += me->verts.size() * sizeof(me->verts[0]);
+	size += me->triangles.size() * sizeof(me->triangles[0]);
+	size += me->shader.size() * sizeof(me->shader[0]);
+	size += (me->smooth.size() + 7) / 8;
+
+	for (const ccl::Attribute& attr : me->attributes.attributes) {
+		size += attr.buffer.size();
+	}
+
+	return size;
+}
+
+void cycles_scene_get_instance_stats(unsigned int client_id, unsigned int scene_id, cycles_instance_stats* stats)
+{
+	*stats = cycles_instance_stats{};
+
+	SCENE_FIND(scene_id)
+		std::unordered_map<const ccl::Mesh*, unsigned int> users;
+		for (const ccl::Object* ob : sce->objects) {
+			if (ob->mesh) users[ob->mesh]++;
+		}
+
+		stats->objects = (unsigned int)sce->objects.size();
+		stats->meshes = (unsigned int)sce->meshes.size();
+
+		for (const auto& it : users) {
+			unsigned long long size = mesh_data_size(it.first);
+
+			stats->bytes_stored += size;
+			if (it.second > 1) {
+				stats->instanced_meshes++;
+				stats->instances += it.second;
+				stats->bytes_saved += size * (it.second - 1);
+			}
+		}
+
+		CCLOG_DEBUG(client_id, "Scene ", scene_id, " has ", stats->instances, " instances of ", stats->instanced_meshes, " meshes, saving ", stats->bytes_saved, " bytes");
+	SCENE_FIND_END()
+}
+
 void cycles_object_tag_update(unsigned int client_id, unsigned int scene_id, unsigned int object_id)
 {
+	CCCAPTURE(cycles_object_tag_update, client_id, scene_id, object_id);
 	SCENE_FIND(scene_id)
 		ccl::Object* ob = sce->objects[object_id];
 		ob->tag_update(sce);
@@ -65,6 +141,7 @@ unsigned int cycles_scene_object_get_mesh(unsigned int client_id, unsigned int s
 			if ((*cmeshit) == ob->mesh) {
 				return i;
 			}
+			++cmeshit;
 			++i;
 		}
 	SCENE_FIND_END()
@@ -73,6 +150,7 @@ unsigned int cycles_scene_object_get_mesh(unsigned int client_id, unsigned int s
 
 void cycles_scene_object_set_visibility(unsigned int client, unsigned int scene_id, unsigned int object_id, unsigned int visibility)
 {
+	CCCAPTURE(cycles_scene_object_set_visibility, client, scene_id, object_id, visibility);
 	SCENE_FIND(scene_id)
 		ccl::Object* ob = sce->objects[object_id];
 		ob->visibility = visibility;
@@ -82,6 +160,7 @@ void cycles_scene_object_set_visibility(unsigned int client, unsigned int scene_
 
 void cycles_scene_object_set_is_shadowcatcher(unsigned int client, unsigned int scene_id, unsigned int object_id, bool is_shadowcatcher)
 {
+	CCCAPTURE(cycles_scene_object_set_is_shadowcatcher, client, scene_id, object_id, is_shadowcatcher);
 	SCENE_FIND(scene_id)
 		ccl::Object* ob = sce->objects[object_id];
 		ob->is_shadow_catcher = is_shadowcatcher;
@@ -96,6 +175,7 @@ void cycles_scene_object_set_matrix(unsigned int client_id, unsigned int scene_i
 	float m, float n, float o, float p
 	)
 {
+	CCCAPTURE(cycles_scene_object_set_matrix, client_id, scene_id, object_id, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
 	SCENE_FIND(scene_id)
 		ccl::Object* ob = sce->objects[object_id];
 		ccl::Transform mat = ccl::make_transform(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
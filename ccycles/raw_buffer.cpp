@@ -0,0 +1,69 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+
+#include "internal_types.h"
+
+void CCRawBuffer::reset(int width_, int height_, int pass_stride_)
+{
+	width = width_;
+	height = height_;
+	pass_stride = pass_stride_;
+
+	data.assign((size_t)width * height * pass_stride, 0.0f);
+	samples.assign((size_t)width * height, 0);
+}
+
+void CCRawBuffer::copy_tile(ccl::RenderTile& tile, int regionx, int regiony)
+{
+	ccl::RenderBuffers* buffers = tile.buffers;
+	if (buffers->params.get_passes_size() != pass_stride) return;
+
+	/* Tile coordinates relative to the render region. */
+	int tilex = tile.x - regionx;
+	int tiley = tile.y - regiony;
+	if (tilex < 0 || tiley < 0 || tilex + tile.w > width || tiley + tile.h > height) return;
+
+	const float* src_buffer = (const float*)buffers->buffer.data_pointer;
+	const size_t row_size = (size_t)tile.w * pass_stride * sizeof(float);
+
+	for (int y = 0; y < tile.h; y++) {
+		/* Tile buffers may cover more than this tile, offset and stride
+		 * take care of that.
+		 */
+		const float* src = &src_buffer[((size_t)tile.offset + tile.x + (size_t)(tile.y + y) * tile.stride) * pass_stride];
+		/* Flip rows, Cycles has its origin bottom-left. */
+		size_t row = (size_t)(height - (tiley + y) - 1) * width + tilex;
+
+		memcpy(&data[row * pass_stride], src, row_size);
+		std::fill_n(&samples[row], tile.w, (unsigned int)tile.sample);
+	}
+}
+
+void merge_raw_buffers(float* dst, unsigned int* dst_samples, const float* src, const unsigned int* src_samples, size_t pixel_count, unsigned int pass_stride)
+{
+	/* All passes are plain sums over samples, so summing the sums gives
+	 * the same expected result as rendering all samples in one go.
+	 */
+	size_t count = pixel_count * pass_stride;
+	for (size_t i = 0; i < count; i++) {
+		dst[i] += src[i];
+	}
+	for (size_t p = 0; p < pixel_count; p++) {
+		dst_samples[p] += src_samples[p];
+	}
+}
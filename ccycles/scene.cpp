@@ -19,8 +19,9 @@ limitations under the License.
 // need access to devices
 extern std::vector<ccl::DeviceInfo> devices;
 
-extern std::vector<ccl::SceneParams> scene_params;
-std::vector<CCScene> scenes;
+extern CCHandleTable<ccl::SceneParams> scene_params;
+CCHandleTable<CCScene> scenes;
+extern CCHandleTable<CCSession*> sessions;
 
 /* implement CCScene methods*/
 
@@ -37,14 +38,14 @@ void CCScene::builtin_image_info(const string& builtin_name, void* builtin_data,
 bool CCScene::builtin_image_pixels(const string& builtin_name, void* builtin_data, unsigned char* pixels)
 {
 	CCImage* img = static_cast<CCImage*>(builtin_data);
-	memcpy(pixels, img->builtin_data, img->width*img->height*img->channels*sizeof(unsigned char));
+	memcpy(pixels, img->builtin_data, img->pixels->data.size());
 	return false;
 }
 
 bool CCScene::builtin_image_float_pixels(const string& builtin_name, void* builtin_data, float* pixels)
 {
 	CCImage* img = static_cast<CCImage*>(builtin_data);
-	memcpy(pixels, img->builtin_data, img->width*img->height*img->channels*sizeof(float));
+	memcpy(pixels, img->builtin_data, img->pixels->data.size());
 	return false;
 }
 
@@ -55,16 +56,18 @@ void _cleanup_scenes()
 	// clear out scene params vector
 	scene_params.clear();
 
-	// loop over scenes, free the ccl::Scenes before clearing out vector
-	for (CCScene sce : scenes) {
+	// loop over scenes, free the ccl::Scenes before clearing out the table
+	scenes.for_each([](unsigned int scene_id, CCScene& sce) {
 		delete sce.scene;
-	}
+	});
 
 	scenes.clear();
 }
 
 unsigned int cycles_scene_create(unsigned int client_id, unsigned int scene_params_id, unsigned int device_id)
 {
+	CCCAPTURE(cycles_scene_create, client_id, scene_params_id, device_id);
+	CCTRACE_API();
 	CCScene scene;
 
 	ccl::SceneParams params;
@@ -73,8 +76,8 @@ unsigned int cycles_scene_create(unsigned int client_id, unsigned int scene_para
 	bool found_params{ false };
 	bool found_di{ false };
 
-	if (0 <= scene_params_id && scene_params_id < scene_params.size()) {
-		params = scene_params[scene_params_id];
+	if (ccl::SceneParams* sp = scene_params.get(scene_params_id)) {
+		params = *sp;
 		found_params = true;
 	}
 
@@ -84,35 +87,19 @@ unsigned int cycles_scene_create(unsigned int client_id, unsigned int scene_para
 	}
 
 	if (found_di && found_params) {
-		int cscid{ -1 };
-		if (scenes.size() > 0) {
-			int hid{ 0 };
-
-			auto scend = scenes.end();
-			auto scit = scenes.begin();
-
-			while (scit != scend) {
-				if ((*scit).scene == nullptr) {
-					cscid = hid;
-					break;
-				}
-				++hid;
-				++scit;
-			}
-
-		} 
-		if (cscid == -1) {
-			scenes.push_back(scene);
-			cscid = (unsigned int)(scenes.size() - 1);
+		scene.scene = new ccl::Scene(params, di);
+		scene.params_id = scene_params_id;
+		scene.scene->image_manager->builtin_image_info_cb = function_bind(&CCScene::builtin_image_info, scene, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7);
+		scene.scene->image_manager->builtin_image_pixels_cb = function_bind(&CCScene::builtin_image_pixels, scene, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		scene.scene->image_manager->builtin_image_float_pixels_cb = function_bind(&CCScene::builtin_image_float_pixels, scene, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+
+		unsigned int cscid = scenes.insert(scene);
+		if (cscid == scenes.INVALID) {
+			delete scene.scene;
+			return UINT_MAX;
 		}
 
-		scenes[cscid].scene = new ccl::Scene(params, di);
-		scenes[cscid].params_id = scene_params_id;
-		scenes[cscid].scene->image_manager->builtin_image_info_cb = function_bind(&CCScene::builtin_image_info, scenes[cscid], std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7);
-		scenes[cscid].scene->image_manager->builtin_image_pixels_cb = function_bind(&CCScene::builtin_image_pixels, scenes[cscid], std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-		scenes[cscid].scene->image_manager->builtin_image_float_pixels_cb = function_bind(&CCScene::builtin_image_float_pixels, scenes[cscid], std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-
-		logger.logit(client_id, "Created scene ", cscid, " with scene_params ", scene_params_id, " and device ", di.id);
+		CCLOG_DEBUG(client_id, "Created scene ", cscid, " with scene_params ", scene_params_id, " and device ", di.id);
 		return cscid;
 	}
 	else {
@@ -122,9 +109,10 @@ unsigned int cycles_scene_create(unsigned int client_id, unsigned int scene_para
 
 void cycles_scene_set_default_surface_shader(unsigned int client_id, unsigned int scene_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_scene_set_default_surface_shader, client_id, scene_id, shader_id);
 	SCENE_FIND(scene_id)
 		sce->default_surface = (int)shader_id;
-		logger.logit(client_id, "Scene ", scene_id, " set default surface shader ", shader_id);
+		CCLOG_DEBUG(client_id, "Scene ", scene_id, " set default surface shader ", shader_id);
 	SCENE_FIND_END()
 }
 
@@ -137,8 +125,28 @@ unsigned int cycles_scene_get_default_surface_shader(unsigned int client_id, uns
 	return UINT_MAX;
 }
 
+void cycles_scene_destroy(unsigned int client_id, unsigned int scene_id)
+{
+	CCCAPTURE(cycles_scene_destroy, client_id, scene_id);
+	SCENE_FIND(scene_id)
+		bool in_session{ false };
+		sessions.for_each([&](unsigned int session_id, CCSession* se) {
+			if (se->session != nullptr && se->session->scene == sce) in_session = true;
+		});
+		if (in_session) {
+			CCLOG_WARNING(client_id, "Scene ", scene_id, " belongs to a session, destroy the session instead");
+			return;
+		}
+
+		scenes.remove(scene_id);
+		delete sce;
+		CCLOG_DEBUG(client_id, "Destroyed scene ", scene_id);
+	SCENE_FIND_END()
+}
+
 void cycles_scene_reset(unsigned int client_id, unsigned int scene_id)
 {
+	CCCAPTURE(cycles_scene_reset, client_id, scene_id);
 	SCENE_FIND(scene_id)
 		sce->reset();
 	SCENE_FIND_END()
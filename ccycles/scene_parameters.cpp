@@ -22,7 +22,7 @@ limitations under the License.
 #define SCENE_PARAM_CAST(scene_params_id, typecast, varname) \
 	PARAM_CAST(scene_params, scene_params_id, typecast, varname)
 
-std::vector<ccl::SceneParams> scene_params;
+CCHandleTable<ccl::SceneParams> scene_params;
 
 /* Create scene parameters, to be used when creating a new scene. */
 unsigned int cycles_scene_params_create(unsigned int client_id, 
@@ -30,6 +30,8 @@ unsigned int cycles_scene_params_create(unsigned int client_id,
 	unsigned int use_bvh_spatial_split, 
 	unsigned int use_qbvh, unsigned int persistent_data)
 {
+	CCCAPTURE(cycles_scene_params_create, client_id, shadingsystem, bvh_type, use_bvh_spatial_split, use_qbvh, persistent_data);
+	CCTRACE_API();
 	ccl::SceneParams params;
 
 	params.shadingsystem = (ccl::ShadingSystem)shadingsystem;
@@ -38,33 +40,38 @@ unsigned int cycles_scene_params_create(unsigned int client_id,
 	params.use_qbvh = use_qbvh == 1;
 	params.persistent_data = persistent_data == 1;
 
-	scene_params.push_back(params);
+	unsigned int scene_params_id = scene_params.insert(params);
 
-	logger.logit(client_id, "Created scene parameters ", scene_params.size() - 1, "\n\tshading system: ", params.shadingsystem, "\n\tbvh_type: ", params.bvh_type, "\n\tuse_bvh_spatial_split: ", params.use_bvh_spatial_split, "\n\tuse_qbvh: ", params.use_qbvh, "\n\tpersistent data: ", params.persistent_data);
+	CCLOG_DEBUG(client_id, "Created scene parameters ", scene_params_id, "\n\tshading system: ", params.shadingsystem, "\n\tbvh_type: ", params.bvh_type, "\n\tuse_bvh_spatial_split: ", params.use_bvh_spatial_split, "\n\tuse_qbvh: ", params.use_qbvh, "\n\tpersistent data: ", params.persistent_data);
 
-	return (unsigned int)(scene_params.size() - 1);
+	return scene_params_id;
 }
 
 /* Set scene parameters*/
 void cycles_scene_params_set_bvh_type(unsigned int client_id, unsigned int scene_params_id, unsigned int bvh_type)
 {
+	CCCAPTURE(cycles_scene_params_set_bvh_type, client_id, scene_params_id, bvh_type);
 	SCENE_PARAM_CAST(scene_params_id, ccl::SceneParams::BVHType, bvh_type)
 }
 
 void cycles_scene_params_set_bvh_spatial_split(unsigned int client_id, unsigned int scene_params_id, unsigned int use_bvh_spatial_split)
 {
+	CCCAPTURE(cycles_scene_params_set_bvh_spatial_split, client_id, scene_params_id, use_bvh_spatial_split);
 	SCENE_PARAM_BOOL(scene_params_id, use_bvh_spatial_split)
 }
 void cycles_scene_params_set_qbvh(unsigned int client_id, unsigned int scene_params_id, unsigned int use_qbvh)
 {
+	CCCAPTURE(cycles_scene_params_set_qbvh, client_id, scene_params_id, use_qbvh);
 	SCENE_PARAM_BOOL(scene_params_id, use_qbvh)
 }
 
 void cycles_scene_params_set_shadingsystem(unsigned int client_id, unsigned int scene_params_id, unsigned int shadingsystem)
 {
+	CCCAPTURE(cycles_scene_params_set_shadingsystem, client_id, scene_params_id, shadingsystem);
 	SCENE_PARAM_CAST(scene_params_id, ccl::ShadingSystem, shadingsystem)
 }
 void cycles_scene_params_set_persistent_data(unsigned int client_id, unsigned int scene_params_id, unsigned int persistent_data)
 {
+	CCCAPTURE(cycles_scene_params_set_persistent_data, client_id, scene_params_id, persistent_data);
 	SCENE_PARAM_BOOL(scene_params_id, persistent_data)
 }
\ No newline at end of file
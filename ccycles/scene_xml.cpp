@@ -0,0 +1,1199 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "internal_types.h"
+
+extern CCHandleTable<CCScene> scenes;
+extern CCHandleTable<CCShader*> shaders;
+
+/* Reader for the scene XML csycles_tester reads. The document is scanned
+ * once with a pull parser, elements are handled as they are reached and no
+ * tree is built. Attribute values are slices of the file buffer, mesh
+ * arrays are parsed from there straight into the ccl::Mesh.
+ */
+
+namespace {
+
+/* Part of the document buffer. */
+struct XmlText {
+	const char* begin;
+	const char* end;
+
+	size_t size() const { return (size_t)(end - begin); }
+	bool empty() const { return begin == end; }
+
+	bool operator==(const char* s) const
+	{
+		size_t n = strlen(s);
+		return size() == n && memcmp(begin, s, n) == 0;
+	}
+
+	/* Copy with the predefined entities replaced. */
+	string str() const
+	{
+		static const struct { const char* name; char c; } entities[] = {
+			{ "&lt;", '<' }, { "&gt;", '>' }, { "&amp;", '&' }, { "&quot;", '"' }, { "&apos;", '\'' }
+		};
+
+		string s;
+		s.reserve(size());
+		for (const char* p = begin; p < end; p++) {
+			if (*p == '&') {
+				bool replaced{ false };
+				for (const auto& e : entities) {
+					size_t n = strlen(e.name);
+					if ((size_t)(end - p) >= n && memcmp(p, e.name, n) == 0) {
+						s += e.c;
+						p += n - 1;
+						replaced = true;
+						break;
+					}
+				}
+				if (replaced) continue;
+			}
+			s += *p;
+		}
+		return s;
+	}
+};
+
+struct XmlAttribute {
+	XmlText name;
+	XmlText value;
+};
+
+enum class xml_event {
+	START,
+	END,
+	DONE,
+	FAILED
+};
+
+/* Pull parser over a document in memory. Only elements are reported, text,
+ * comments, processing instructions and the doctype are skipped. A self
+ * closing element gives START followed by END.
+ */
+class XmlPullParser {
+public:
+	XmlText name{ nullptr, nullptr };
+	vector<XmlAttribute> attributes;
+
+	XmlPullParser(const char* begin, const char* end) : start(begin), pos(begin), end(end) {}
+
+	xml_event next()
+	{
+		if (pending_end) {
+			pending_end = false;
+			return xml_event::END;
+		}
+
+		attributes.clear();
+		for (;;) {
+			pos = (const char*)memchr(pos, '<', end - pos);
+			if (pos == nullptr) {
+				pos = end;
+				return xml_event::DONE;
+			}
+
+			if (starts_with("<!--")) {
+				if (!skip_past("-->")) return xml_event::FAILED;
+			}
+			else if (starts_with("<?")) {
+				if (!skip_past("?>")) return xml_event::FAILED;
+			}
+			else if (starts_with("<![CDATA[")) {
+				if (!skip_past("]]>")) return xml_event::FAILED;
+			}
+			else if (starts_with("<!")) {
+				if (!skip_past(">")) return xml_event::FAILED;
+			}
+			else if (starts_with("</")) {
+				pos += 2;
+				if (!read_name(name)) return xml_event::FAILED;
+				skip_space();
+				if (pos == end || *pos != '>') return xml_event::FAILED;
+				pos++;
+				return xml_event::END;
+			}
+			else {
+				pos++;
+				return read_start();
+			}
+		}
+	}
+
+	const XmlText* attribute(const char* attr_name) const
+	{
+		for (const XmlAttribute& a : attributes) {
+			if (a.name == attr_name) return &a.value;
+		}
+		return nullptr;
+	}
+
+	/* Line of the current position, for messages. */
+	int line() const
+	{
+		return 1 + (int)std::count(start, pos, '\n');
+	}
+
+private:
+	const char* start;
+	const char* pos;
+	const char* end;
+	bool pending_end{ false };
+
+	bool starts_with(const char* s) const
+	{
+		size_t n = strlen(s);
+		return (size_t)(end - pos) >= n && memcmp(pos, s, n) == 0;
+	}
+
+	bool skip_past(const char* s)
+	{
+		size_t n = strlen(s);
+		for (const char* p = pos; (size_t)(end - p) >= n; p++) {
+			if (memcmp(p, s, n) == 0) {
+				pos = p + n;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void skip_space()
+	{
+		while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) pos++;
+	}
+
+	bool read_name(XmlText& text)
+	{
+		text.begin = pos;
+		while (pos < end && *pos != '>' && *pos != '/' && *pos != '=' && *pos != ' ' && *pos != '\t' && *pos != '\n' && *pos != '\r') pos++;
+		text.end = pos;
+		return !text.empty();
+	}
+
+	xml_event read_start()
+	{
+		if (!read_name(name)) return xml_event::FAILED;
+
+		for (;;) {
+			skip_space();
+			if (pos == end) return xml_event::FAILED;
+
+			if (*pos == '>') {
+				pos++;
+				return xml_event::START;
+			}
+			if (*pos == '/') {
+				if (end - pos < 2 || pos[1] != '>') return xml_event::FAILED;
+				pos += 2;
+				pending_end = true;
+				return xml_event::START;
+			}
+
+			XmlAttribute a;
+			if (!read_name(a.name)) return xml_event::FAILED;
+			skip_space();
+			if (pos == end || *pos != '=') return xml_event::FAILED;
+			pos++;
+			skip_space();
+			if (pos == end || (*pos != '"' && *pos != '\'')) return xml_event::FAILED;
+
+			const char* value_end = (const char*)memchr(pos + 1, *pos, end - pos - 1);
+			if (value_end == nullptr) return xml_event::FAILED;
+			a.value.begin = pos + 1;
+			a.value.end = value_end;
+			pos = value_end + 1;
+
+			attributes.push_back(a);
+		}
+	}
+};
+
+/* Numbers in attributes are separated by white space, commas are allowed
+ * too ("0.8, 0.8, 0.8").
+ */
+static inline bool is_separator(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+}
+
+static inline const char* skip_separators(const char* p, const char* end)
+{
+	while (p < end && is_separator(*p)) p++;
+	return p;
+}
+
+static size_t count_numbers(const XmlText& text)
+{
+	size_t count{ 0 };
+	bool in_number{ false };
+	for (const char* p = text.begin; p < text.end; p++) {
+		bool sep = is_separator(*p);
+		if (!sep && !in_number) count++;
+		in_number = !sep;
+	}
+	return count;
+}
+
+static const double powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Locale independent decimal float parser. Mantissas of up to 18 digits
+ * are scaled exactly in double, which leaves at most one rounding step
+ * when going to float. Anything else, inf and nan included, goes through
+ * strtod.
+ */
+static bool parse_float(const char*& p, const char* end, float& value)
+{
+	p = skip_separators(p, end);
+	if (p == end) return false;
+
+	const char* number = p;
+	bool negative{ false };
+	if (*p == '-' || *p == '+') {
+		negative = *p == '-';
+		p++;
+	}
+
+	unsigned long long mantissa{ 0 };
+	int exponent{ 0 };
+	int digits{ 0 };
+	for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+		if (mantissa < 100000000000000000ULL) mantissa = mantissa * 10 + (unsigned int)(*p - '0');
+		else exponent++;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+			if (mantissa < 100000000000000000ULL) {
+				mantissa = mantissa * 10 + (unsigned int)(*p - '0');
+				exponent--;
+			}
+		}
+	}
+
+	if (digits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+		const char* e = p + 1;
+		bool e_negative{ false };
+		if (e < end && (*e == '-' || *e == '+')) {
+			e_negative = *e == '-';
+			e++;
+		}
+		if (e < end && *e >= '0' && *e <= '9') {
+			int e_value{ 0 };
+			for (; e < end && *e >= '0' && *e <= '9'; e++) {
+				if (e_value < 10000) e_value = e_value * 10 + (*e - '0');
+			}
+			exponent += e_negative ? -e_value : e_value;
+			p = e;
+		}
+	}
+
+	if (digits == 0 || (p < end && !is_separator(*p))) {
+		char buffer[64];
+		const char* token_end = number;
+		while (token_end < end && !is_separator(*token_end)) token_end++;
+		size_t n = std::min((size_t)(token_end - number), sizeof(buffer) - 1);
+		memcpy(buffer, number, n);
+		buffer[n] = '\0';
+		char* parsed;
+		double d = strtod(buffer, &parsed);
+		if (parsed == buffer) return false;
+		p = number + (parsed - buffer);
+		value = (float)d;
+		return true;
+	}
+
+	double d = (double)mantissa;
+	if (exponent < 0 && exponent >= -22) d /= powers_of_ten[-exponent];
+	else if (exponent > 0 && exponent <= 22) d *= powers_of_ten[exponent];
+	else if (exponent != 0) d *= pow(10.0, (double)exponent);
+
+	value = (float)(negative ? -d : d);
+	return true;
+}
+
+static bool parse_int(const char*& p, const char* end, int& value)
+{
+	p = skip_separators(p, end);
+	if (p == end) return false;
+
+	bool negative{ false };
+	if (*p == '-' || *p == '+') {
+		negative = *p == '-';
+		p++;
+	}
+
+	const char* digits = p;
+	long long v{ 0 };
+	for (; p < end && *p >= '0' && *p <= '9'; p++) {
+		if (v <= INT_MAX) v = v * 10 + (*p - '0');
+	}
+	if (p == digits || v > INT_MAX || (p < end && !is_separator(*p))) return false;
+
+	value = (int)(negative ? -v : v);
+	return true;
+}
+
+/* Parse up to max floats of text into values, returns how many were read. */
+static int parse_floats(const XmlText* text, float* values, int max)
+{
+	if (text == nullptr) return 0;
+	const char* p = text->begin;
+	int count{ 0 };
+	while (count < max && parse_float(p, text->end, values[count])) count++;
+	return count;
+}
+
+static bool get_float(const XmlText* text, float& value)
+{
+	return parse_floats(text, &value, 1) == 1;
+}
+
+static bool get_int(const XmlText* text, int& value)
+{
+	if (text == nullptr) return false;
+	const char* p = text->begin;
+	return parse_int(p, text->end, value);
+}
+
+static bool get_float3(const XmlText* text, ccl::float3& value)
+{
+	float f[3];
+	if (parse_floats(text, f, 3) != 3) return false;
+	value = ccl::make_float3(f[0], f[1], f[2]);
+	return true;
+}
+
+static bool get_bool(const XmlText* text, bool& value)
+{
+	if (text == nullptr) return false;
+	string s = text->str();
+	if (ccl::string_iequals(s, "true") || s == "1") value = true;
+	else if (ccl::string_iequals(s, "false") || s == "0") value = false;
+	else return false;
+	return true;
+}
+
+/* Socket and attribute names match when they are equal ignoring case, with
+ * an underscore in the attribute matching a space in the socket name.
+ */
+static bool socket_name_matches(const char* socket, const XmlText& name)
+{
+	size_t n = strlen(socket);
+	if (n != name.size()) return false;
+	for (size_t i = 0; i < n; i++) {
+		char a = (char)tolower((unsigned char)socket[i]);
+		char b = (char)tolower((unsigned char)name.begin[i]);
+		if (a == ' ') a = '_';
+		if (a != b) return false;
+	}
+	return true;
+}
+
+static string path_directory(const string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == string::npos ? string() : path.substr(0, slash + 1);
+}
+
+static string path_resolve(const string& base, const string& path)
+{
+	bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+	return absolute ? path : base + path;
+}
+
+/* Inherited settings, changed by transform, lookat and state elements for
+ * the elements they contain.
+ */
+struct XmlState {
+	ccl::Transform tfm;
+	unsigned int shader;
+	bool smooth;
+	bool is_shadowcatcher;
+	string base_path;
+};
+
+struct XmlNode {
+	unsigned int id;
+	ccl::ShaderNode* node;
+	shadernode_type type;
+};
+
+/* Shader or background element being read. */
+struct XmlGraph {
+	unsigned int shader_id;
+	CCShader* sh;
+	string name;
+	bool background;
+	/* Depth of the element, its children are one deeper. */
+	size_t depth;
+	std::unordered_map<string, XmlNode> nodes;
+};
+
+struct XmlLoader {
+	unsigned int client_id;
+	unsigned int scene_id;
+	ccl::Scene* sce;
+	/* Meshes and shaders by name, over all included files. */
+	std::unordered_map<string, unsigned int> meshes;
+	std::unordered_map<string, unsigned int> shader_ids;
+	int include_depth;
+};
+
+static const int MAX_INCLUDE_DEPTH{ 32 };
+
+static const struct {
+	const char* name;
+	shadernode_type type;
+} xml_node_types[] = {
+	{ "absorption_volume", shadernode_type::ABSORPTION_VOLUME },
+	{ "add_closure", shadernode_type::ADD_CLOSURE },
+	{ "anisotropic_bsdf", shadernode_type::ANISOTROPIC },
+	{ "background", shadernode_type::BACKGROUND },
+	{ "brick_texture", shadernode_type::BRICK_TEXTURE },
+	{ "brightness", shadernode_type::BRIGHT_CONTRAST },
+	{ "bump", shadernode_type::BUMP },
+	{ "checker_texture", shadernode_type::CHECKER_TEXTURE },
+	{ "color", shadernode_type::COLOR },
+	{ "color_ramp", shadernode_type::COLOR_RAMP },
+	{ "combine_hsv", shadernode_type::HSV_COMBINE },
+	{ "combine_rgb", shadernode_type::RGB_COMBINE },
+	{ "combine_xyz", shadernode_type::COMBINE_XYZ },
+	{ "diffuse_bsdf", shadernode_type::DIFFUSE },
+	{ "emission", shadernode_type::EMISSION },
+	{ "environment_texture", shadernode_type::ENVIRONMENT_TEXTURE },
+	{ "fresnel", shadernode_type::FRESNEL },
+	{ "gamma", shadernode_type::GAMMA },
+	{ "glass_bsdf", shadernode_type::GLASS },
+	{ "glossy_bsdf", shadernode_type::GLOSSY },
+	{ "gradient_texture", shadernode_type::GRADIENT_TEXTURE },
+	{ "holdout", shadernode_type::HOLDOUT },
+	{ "hsv", shadernode_type::HUE_SAT },
+	{ "image_texture", shadernode_type::IMAGE_TEXTURE },
+	{ "layer_weight", shadernode_type::LAYERWEIGHT },
+	{ "light_falloff", shadernode_type::LIGHTFALLOFF },
+	{ "light_path", shadernode_type::LIGHTPATH },
+	{ "magic_texture", shadernode_type::MAGIC_TEXTURE },
+	{ "mapping", shadernode_type::MAPPING },
+	{ "math", shadernode_type::MATH },
+	{ "matrix_math", shadernode_type::MATRIX_MATH },
+	{ "mix", shadernode_type::MIX },
+	{ "mix_closure", shadernode_type::MIX_CLOSURE },
+	{ "musgrave_texture", shadernode_type::MUSGRAVE_TEXTURE },
+	{ "noise_texture", shadernode_type::NOISE_TEXTURE },
+	{ "refraction_bsdf", shadernode_type::REFRACTION },
+	{ "rgb_to_bw", shadernode_type::RGBTOBW },
+	{ "rgb_to_luminance", shadernode_type::RGBTOLUMINANCE },
+	{ "scatter_volume", shadernode_type::SCATTER_VOLUME },
+	{ "separate_hsv", shadernode_type::HSV_SEPARATE },
+	{ "separate_rgb", shadernode_type::RGB_SEPARATE },
+	{ "separate_xyz", shadernode_type::SEPARATE_XYZ },
+	{ "sky_texture", shadernode_type::SKY_TEXTURE },
+	{ "texture_coordinate", shadernode_type::TEXTURE_COORDINATE },
+	{ "translucent_bsdf", shadernode_type::TRANSLUCENT },
+	{ "transparent_bsdf", shadernode_type::TRANSPARENT },
+	{ "value", shadernode_type::VALUE },
+	{ "vector_math", shadernode_type::VECT_MATH },
+	{ "velvet_bsdf", shadernode_type::VELVET },
+	{ "voronoi_texture", shadernode_type::VORONOI_TEXTURE },
+	{ "wave_texture", shadernode_type::WAVE_TEXTURE },
+};
+
+static bool find_node_type(const XmlText& name, shadernode_type& type)
+{
+	for (const auto& t : xml_node_types) {
+		if (name == t.name) {
+			type = t.type;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void set_transform_matrix(const ccl::Transform& t, float* m)
+{
+	m[0] = t.x.x; m[1] = t.x.y; m[2] = t.x.z; m[3] = t.x.w;
+	m[4] = t.y.x; m[5] = t.y.y; m[6] = t.y.z; m[7] = t.y.w;
+	m[8] = t.z.x; m[9] = t.z.y; m[10] = t.z.z; m[11] = t.z.w;
+	m[12] = t.w.x; m[13] = t.w.y; m[14] = t.w.z; m[15] = t.w.w;
+}
+
+/* transform = ((matrix * translate) * rotate) * scale, as csycles_tester does. */
+static void read_transform(const XmlPullParser& xml, ccl::Transform& tfm)
+{
+	float m[16];
+	if (parse_floats(xml.attribute("matrix"), m, 16) == 16) {
+		tfm = ccl::make_transform(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]);
+	}
+
+	ccl::float3 v;
+	if (get_float3(xml.attribute("translate"), v)) {
+		tfm = tfm * ccl::transform_translate(v);
+	}
+
+	float r[4];
+	if (parse_floats(xml.attribute("rotate"), r, 4) == 4) {
+		tfm = tfm * ccl::transform_rotate(r[0] * M_PI_F / 180.0f, ccl::make_float3(r[1], r[2], r[3]));
+	}
+
+	if (get_float3(xml.attribute("scale"), v)) {
+		tfm = tfm * ccl::transform_scale(v);
+	}
+}
+
+static bool read_lookat(const XmlLoader& ld, const XmlPullParser& xml, ccl::Transform& tfm)
+{
+	ccl::float3 pos, look, up;
+	if (!get_float3(xml.attribute("pos"), pos) || !get_float3(xml.attribute("look"), look) || !get_float3(xml.attribute("up"), up)) {
+		CCLOG_ERROR(ld.client_id, "lookat needs pos, look and up, line ", xml.line());
+		return false;
+	}
+	cycles_tfm_lookat(pos, look, up, tfm);
+	return true;
+}
+
+static unsigned int find_shader(const XmlLoader& ld, const string& name)
+{
+	auto it = ld.shader_ids.find(name);
+	if (it != ld.shader_ids.end()) return it->second;
+
+	for (size_t i = 0; i < ld.sce->shaders.size(); i++) {
+		if (name == ld.sce->shaders[i]->name.c_str()) return (unsigned int)i;
+	}
+	return UINT_MAX;
+}
+
+static void read_state(const XmlLoader& ld, const XmlPullParser& xml, XmlState& state)
+{
+	if (const XmlText* shader = xml.attribute("shader")) {
+		string name = shader->str();
+		unsigned int shader_id = find_shader(ld, name);
+		if (shader_id != UINT_MAX) state.shader = shader_id;
+		else CCLOG_WARNING(ld.client_id, "Unknown shader ", name, ", line ", xml.line());
+	}
+
+	if (const XmlText* interpolation = xml.attribute("interpolation")) {
+		state.smooth = ccl::string_iequals(interpolation->str(), "smooth");
+	}
+
+	bool b;
+	if (get_bool(xml.attribute("is_shadow_catcher"), b)) state.is_shadowcatcher = b;
+}
+
+static void read_camera(const XmlLoader& ld, const XmlPullParser& xml, const XmlState& state)
+{
+	unsigned int client_id = ld.client_id;
+	unsigned int scene_id = ld.scene_id;
+	int width, height;
+	float f;
+
+	if (get_int(xml.attribute("width"), width) && get_int(xml.attribute("height"), height)) {
+		cycles_camera_set_size(client_id, scene_id, (unsigned int)width, (unsigned int)height);
+	}
+
+	if (const XmlText* type = xml.attribute("type")) {
+		string t = type->str();
+		if (ccl::string_iequals(t, "perspective")) cycles_camera_set_type(client_id, scene_id, camera_type::PERSPECTIVE);
+		else if (ccl::string_iequals(t, "orthographic")) cycles_camera_set_type(client_id, scene_id, camera_type::ORTHOGRAPHIC);
+		else if (ccl::string_iequals(t, "panorama")) cycles_camera_set_type(client_id, scene_id, camera_type::PANORAMA);
+	}
+
+	if (const XmlText* type = xml.attribute("panorama_type")) {
+		string t = type->str();
+		if (ccl::string_iequals(t, "equirectangular")) cycles_camera_set_panorama_type(client_id, scene_id, panorama_type::EQUIRECTANGLUAR);
+		else if (ccl::string_iequals(t, "fisheyeequidistant")) cycles_camera_set_panorama_type(client_id, scene_id, panorama_type::FISHEYE_EQUIDISTANT);
+		else if (ccl::string_iequals(t, "fisheyeequisolid")) cycles_camera_set_panorama_type(client_id, scene_id, panorama_type::FISHEYE_EQUISOLID);
+	}
+
+	if (get_float(xml.attribute("fov"), f)) cycles_camera_set_fov(client_id, scene_id, f);
+	if (get_float(xml.attribute("nearclip"), f)) cycles_camera_set_nearclip(client_id, scene_id, f);
+	if (get_float(xml.attribute("farclip"), f)) cycles_camera_set_farclip(client_id, scene_id, f);
+	if (get_float(xml.attribute("aperturesize"), f)) cycles_camera_set_aperturesize(client_id, scene_id, f);
+	if (get_float(xml.attribute("focaldistance"), f)) cycles_camera_set_focaldistance(client_id, scene_id, f);
+	if (get_float(xml.attribute("shuttertime"), f)) cycles_camera_set_shuttertime(client_id, scene_id, f);
+	if (get_float(xml.attribute("fisheye_fov"), f)) cycles_camera_set_fisheye_fov(client_id, scene_id, f);
+	if (get_float(xml.attribute("fisheye_lens"), f)) cycles_camera_set_fisheye_lens(client_id, scene_id, f);
+	if (get_float(xml.attribute("sensorwidth"), f)) cycles_camera_set_sensor_width(client_id, scene_id, f);
+	if (get_float(xml.attribute("sensorheight"), f)) cycles_camera_set_sensor_height(client_id, scene_id, f);
+
+	float m[16];
+	set_transform_matrix(state.tfm, m);
+	cycles_camera_set_matrix(client_id, scene_id, m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]);
+	cycles_camera_compute_auto_viewplane(client_id, scene_id);
+	cycles_camera_update(client_id, scene_id);
+}
+
+static void read_integrator(const XmlLoader& ld, const XmlPullParser& xml)
+{
+	unsigned int client_id = ld.client_id;
+	unsigned int scene_id = ld.scene_id;
+	bool b;
+	int i;
+	float f;
+
+	b = false;
+	get_bool(xml.attribute("branched"), b);
+	cycles_integrator_set_method(client_id, scene_id, b ? 0 : 1);
+
+	if (get_bool(xml.attribute("sample_all_lights_direct"), b)) cycles_integrator_set_sample_all_lights_direct(client_id, scene_id, b);
+	if (get_bool(xml.attribute("sample_all_lights_indirect"), b)) cycles_integrator_set_sample_all_lights_indirect(client_id, scene_id, b);
+	if (get_int(xml.attribute("diffuse_samples"), i)) cycles_integrator_set_diffuse_samples(client_id, scene_id, i);
+	if (get_int(xml.attribute("glossy_samples"), i)) cycles_integrator_set_glossy_samples(client_id, scene_id, i);
+	if (get_int(xml.attribute("transmission_samples"), i)) cycles_integrator_set_transmission_samples(client_id, scene_id, i);
+	if (get_int(xml.attribute("ao_samples"), i)) cycles_integrator_set_ao_samples(client_id, scene_id, i);
+	if (get_int(xml.attribute("mesh_light_samples"), i)) cycles_integrator_set_mesh_light_samples(client_id, scene_id, i);
+	if (get_int(xml.attribute("subsurface_samples"), i)) cycles_integrator_set_subsurface_samples(client_id, scene_id, i);
+	if (get_int(xml.attribute("volume_samples"), i)) cycles_integrator_set_volume_samples(client_id, scene_id, i);
+
+	if (get_int(xml.attribute("min_bounce"), i)) cycles_integrator_set_min_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("max_bounce"), i)) cycles_integrator_set_max_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("max_diffuse_bounce"), i)) cycles_integrator_set_max_diffuse_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("max_glossy_bounce"), i)) cycles_integrator_set_max_glossy_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("max_transmission_bounce"), i)) cycles_integrator_set_max_transmission_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("max_volume_bounce"), i)) cycles_integrator_set_max_volume_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("transparent_min_bounce"), i)) cycles_integrator_set_transparent_min_bounce(client_id, scene_id, i);
+	if (get_int(xml.attribute("transparent_max_bounce"), i)) cycles_integrator_set_transparent_max_bounce(client_id, scene_id, i);
+	if (get_bool(xml.attribute("transparent_shadows"), b)) cycles_integrator_set_transparent_shadows(client_id, scene_id, b);
+
+	if (get_float(xml.attribute("volume_step_size"), f)) cycles_integrator_set_volume_step_size(client_id, scene_id, f);
+	if (get_int(xml.attribute("volume_max_steps"), i)) cycles_integrator_set_volume_max_steps(client_id, scene_id, i);
+
+	if (get_bool(xml.attribute("no_caustics"), b)) cycles_integrator_set_no_caustics(client_id, scene_id, b);
+	if (get_float(xml.attribute("filter_glossy"), f)) cycles_integrator_set_filter_glossy(client_id, scene_id, f);
+
+	if (get_int(xml.attribute("seed"), i)) cycles_integrator_set_seed(client_id, scene_id, i);
+	if (get_float(xml.attribute("sample_clamp_direct"), f)) cycles_integrator_set_sample_clamp_direct(client_id, scene_id, f);
+	if (get_float(xml.attribute("sample_clamp_indirect"), f)) cycles_integrator_set_sample_clamp_indirect(client_id, scene_id, f);
+
+	if (const XmlText* pattern = xml.attribute("sampling_pattern")) {
+		cycles_integrator_set_sampling_pattern(client_id, scene_id, *pattern == "sobol" ? sampling_pattern::SOBOL : sampling_pattern::CMJ);
+	}
+
+	cycles_integrator_tag_update(client_id, scene_id);
+}
+
+/* Walk the polygons of a mesh element: nverts holds the corner count of
+ * each polygon. f(n) gets called once per polygon and returns false to stop.
+ */
+template<typename F>
+static bool for_each_polygon(const XmlText& nverts, F f)
+{
+	const char* p = nverts.begin;
+	int n;
+	while (parse_int(p, nverts.end, n)) {
+		if (n < 3 || !f(n)) return false;
+	}
+	return skip_separators(p, nverts.end) == nverts.end;
+}
+
+static bool read_mesh(XmlLoader& ld, const XmlPullParser& xml, const XmlState& state)
+{
+	CCTRACE("xml", "mesh");
+
+	const XmlText* name = xml.attribute("name");
+	const XmlText* P = xml.attribute("P");
+	const XmlText* nverts = xml.attribute("nverts");
+	const XmlText* verts = xml.attribute("verts");
+	const XmlText* UV = xml.attribute("UV");
+	if (name == nullptr || P == nullptr || nverts == nullptr || verts == nullptr) {
+		CCLOG_ERROR(ld.client_id, "mesh needs name, P, nverts and verts, line ", xml.line());
+		return false;
+	}
+
+	size_t vcount = count_numbers(*P) / 3;
+	size_t tcount{ 0 };
+	size_t corners{ 0 };
+	if (!for_each_polygon(*nverts, [&](int n) { tcount += n - 2; corners += n; return true; })) {
+		CCLOG_ERROR(ld.client_id, "mesh ", name->str(), " has an invalid nverts, line ", xml.line());
+		return false;
+	}
+
+	/* Everything is parsed and checked before the mesh is added, so a bad
+	 * mesh leaves nothing half-built behind in the scene.
+	 */
+	vector<ccl::float3> vertices(vcount);
+	const char* p = P->begin;
+	for (size_t i = 0; i < vcount; i++) {
+		float x, y, z;
+		if (!parse_float(p, P->end, x) || !parse_float(p, P->end, y) || !parse_float(p, P->end, z)) {
+			CCLOG_ERROR(ld.client_id, "mesh ", name->str(), " has an invalid P, line ", xml.line());
+			return false;
+		}
+		vertices[i] = ccl::make_float3(x, y, z);
+	}
+
+	/* Polygons are triangulated as fans around their first corner. */
+	vector<int> triangles;
+	triangles.reserve(tcount * 3);
+	vector<int> polygon;
+	p = verts->begin;
+	bool ok = for_each_polygon(*nverts, [&](int n) {
+		polygon.resize(n);
+		for (int i = 0; i < n; i++) {
+			if (!parse_int(p, verts->end, polygon[i]) || polygon[i] < 0 || (size_t)polygon[i] >= vcount) return false;
+		}
+		for (int i = 1; i + 1 < n; i++) {
+			triangles.push_back(polygon[0]);
+			triangles.push_back(polygon[i]);
+			triangles.push_back(polygon[i + 1]);
+		}
+		return true;
+	});
+	if (!ok) {
+		CCLOG_ERROR(ld.client_id, "mesh ", name->str(), " has an invalid verts, line ", xml.line());
+		return false;
+	}
+
+	/* UVs are given per polygon corner, Cycles wants them per triangle corner. */
+	vector<ccl::float3> uvs;
+	if (UV != nullptr) {
+		uvs.reserve(tcount * 3);
+		vector<float> polygon_uv;
+		p = UV->begin;
+		ok = for_each_polygon(*nverts, [&](int n) {
+			polygon_uv.resize(n * 2);
+			for (int i = 0; i < n * 2; i++) {
+				if (!parse_float(p, UV->end, polygon_uv[i])) return false;
+			}
+			for (int i = 1; i + 1 < n; i++) {
+				uvs.push_back(ccl::make_float3(polygon_uv[0], polygon_uv[1], 0.0f));
+				uvs.push_back(ccl::make_float3(polygon_uv[i * 2], polygon_uv[i * 2 + 1], 0.0f));
+				uvs.push_back(ccl::make_float3(polygon_uv[(i + 1) * 2], polygon_uv[(i + 1) * 2 + 1], 0.0f));
+			}
+			return true;
+		});
+		if (!ok) {
+			CCLOG_ERROR(ld.client_id, "mesh ", name->str(), " has too few or invalid UV, line ", xml.line());
+			return false;
+		}
+	}
+
+	unsigned int mesh_id = cycles_scene_add_mesh(ld.client_id, ld.scene_id, state.shader);
+	if (mesh_id == UINT_MAX) return false;
+	ccl::Mesh* me = ld.sce->meshes[mesh_id];
+
+	me->verts.resize(vcount);
+	std::copy(vertices.begin(), vertices.end(), me->verts.data());
+
+	me->triangles.reserve(me->triangles.size() + tcount);
+	me->shader.reserve(me->shader.size() + tcount);
+	me->smooth.reserve(me->smooth.size() + tcount);
+	for (size_t i = 0; i < tcount; i++) {
+		me->add_triangle(triangles[i * 3], triangles[i * 3 + 1], triangles[i * 3 + 2], state.shader, state.smooth);
+	}
+
+	if (!uvs.empty()) {
+		ccl::Attribute* attr = me->attributes.add(ccl::ATTR_STD_UV, ccl::ustring("uvmap"));
+		std::copy(uvs.begin(), uvs.end(), attr->data_float3());
+	}
+
+	me->geometry_flags = ccl::Mesh::GeometryFlags::GEOMETRY_TRIANGLES;
+	ld.meshes[name->str()] = mesh_id;
+
+	CCLOG_DEBUG(ld.client_id, "Read mesh ", name->str(), " with ", vcount, " verts and ", tcount, " tris into mesh ", mesh_id);
+	return true;
+}
+
+static void read_object(const XmlLoader& ld, const XmlPullParser& xml, const XmlState& state)
+{
+	const XmlText* mesh = xml.attribute("mesh");
+	string name = mesh ? mesh->str() : string();
+	auto it = ld.meshes.find(name);
+	if (it == ld.meshes.end()) {
+		CCLOG_WARNING(ld.client_id, "Unknown mesh ", name, ", line ", xml.line());
+		return;
+	}
+
+	float m[16];
+	set_transform_matrix(state.tfm, m);
+	unsigned int object_id = cycles_scene_add_mesh_instance(ld.client_id, ld.scene_id, it->second,
+		m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]);
+	if (object_id != UINT_MAX && state.is_shadowcatcher) {
+		cycles_scene_object_set_is_shadowcatcher(ld.client_id, ld.scene_id, object_id, true);
+	}
+}
+
+static void read_light(const XmlLoader& ld, const XmlPullParser& xml, const XmlState& state)
+{
+	unsigned int client_id = ld.client_id;
+	unsigned int scene_id = ld.scene_id;
+	unsigned int light_id = cycles_create_light(client_id, scene_id, state.shader);
+	if (light_id == UINT_MAX) return;
+
+	int i;
+	float f;
+	bool b;
+	ccl::float3 v;
+
+	if (get_int(xml.attribute("type"), i)) cycles_light_set_type(client_id, scene_id, light_id, (light_type)i);
+	if (get_float(xml.attribute("spot_angle"), f)) cycles_light_set_spot_angle(client_id, scene_id, light_id, f);
+	if (get_float(xml.attribute("spot_smooth"), f)) cycles_light_set_spot_smooth(client_id, scene_id, light_id, f);
+	if (get_float(xml.attribute("sizeu"), f)) cycles_light_set_sizeu(client_id, scene_id, light_id, f);
+	if (get_float(xml.attribute("sizev"), f)) cycles_light_set_sizev(client_id, scene_id, light_id, f);
+	if (get_float3(xml.attribute("axisu"), v)) cycles_light_set_axisu(client_id, scene_id, light_id, v.x, v.y, v.z);
+	if (get_float3(xml.attribute("axisv"), v)) cycles_light_set_axisv(client_id, scene_id, light_id, v.x, v.y, v.z);
+	if (get_float(xml.attribute("size"), f)) cycles_light_set_size(client_id, scene_id, light_id, f);
+	if (get_float3(xml.attribute("dir"), v)) cycles_light_set_dir(client_id, scene_id, light_id, v.x, v.y, v.z);
+	if (get_float3(xml.attribute("P"), v)) {
+		v = ccl::transform_point(&state.tfm, v);
+		cycles_light_set_co(client_id, scene_id, light_id, v.x, v.y, v.z);
+	}
+	if (get_bool(xml.attribute("cast_shadow"), b)) cycles_light_set_cast_shadow(client_id, scene_id, light_id, b ? 1 : 0);
+	if (get_bool(xml.attribute("use_mis"), b)) cycles_light_set_use_mis(client_id, scene_id, light_id, b ? 1 : 0);
+	if (get_int(xml.attribute("samples"), i)) cycles_light_set_samples(client_id, scene_id, light_id, (unsigned int)i);
+	if (get_int(xml.attribute("max_bounces"), i)) cycles_light_set_max_bounces(client_id, scene_id, light_id, (unsigned int)i);
+
+	cycles_light_tag_update(client_id, scene_id, light_id);
+}
+
+static void begin_graph(const XmlLoader& ld, const XmlPullParser& xml, bool background, size_t depth, XmlGraph& graph)
+{
+	graph.shader_id = cycles_create_shader(ld.client_id);
+	graph.sh = shaders.find(graph.shader_id);
+	graph.background = background;
+	graph.depth = depth;
+	graph.nodes.clear();
+
+	const XmlText* name = xml.attribute("name");
+	graph.name = name ? name->str() : string();
+
+	ccl::ShaderNode* output = graph.sh->graph->output();
+	graph.nodes["output"] = XmlNode{ (unsigned int)output->id, output, shadernode_type::OUTPUT };
+}
+
+static void end_graph(XmlLoader& ld, XmlGraph& graph)
+{
+	if (!graph.name.empty()) {
+		cycles_shader_set_name(ld.client_id, graph.shader_id, graph.name.c_str());
+	}
+	unsigned int scene_shader_id = cycles_scene_add_shader(ld.client_id, ld.scene_id, graph.shader_id);
+
+	if (graph.background) {
+		cycles_scene_set_background_shader(ld.client_id, ld.scene_id, scene_shader_id);
+	}
+	else if (!graph.name.empty()) {
+		ld.shader_ids[graph.name] = scene_shader_id;
+	}
+	graph.sh = nullptr;
+}
+
+/* Drop a graph left open by an error. Its shader was never added to the
+ * scene, so emptying the graph is enough to let go of its nodes.
+ */
+static void discard_graph(XmlLoader& ld, XmlGraph& graph)
+{
+	cycles_shader_new_graph(ld.client_id, graph.shader_id);
+	graph.sh = nullptr;
+	graph.nodes.clear();
+}
+
+/* Ends the parse of a file with no graph open, whichever way it returns. */
+struct XmlGraphGuard {
+	XmlLoader& ld;
+	XmlGraph& graph;
+	~XmlGraphGuard()
+	{
+		if (graph.sh != nullptr) discard_graph(ld, graph);
+	}
+};
+
+/* Members cycles_shadernode_set_member_int knows, all others are floats. */
+static bool is_int_member(shadernode_type type, const string& name)
+{
+	switch (type) {
+		case shadernode_type::BRICK_TEXTURE:
+			return name == "offset_frequency" || name == "squash_frequency";
+		case shadernode_type::IMAGE_TEXTURE:
+		case shadernode_type::ENVIRONMENT_TEXTURE:
+			return name == "interpolation";
+		case shadernode_type::MAGIC_TEXTURE:
+			return name == "depth";
+		default:
+			return false;
+	}
+}
+
+static void set_node_attribute(const XmlLoader& ld, const XmlGraph& graph, const XmlNode& n, const XmlAttribute& a, const string& base_path)
+{
+	for (ccl::ShaderInput* inp : n.node->inputs) {
+		if (socket_name_matches(inp->name, a.name)) {
+			float f[3];
+			int count = parse_floats(&a.value, f, 3);
+			if (count >= 1) inp->value.x = f[0];
+			if (count >= 3) {
+				inp->value.y = f[1];
+				inp->value.z = f[2];
+			}
+			return;
+		}
+	}
+
+	string name = a.name.str();
+	string value = a.value.str();
+
+	if (name == "src" && (n.type == shadernode_type::IMAGE_TEXTURE || n.type == shadernode_type::ENVIRONMENT_TEXTURE)) {
+		/* Loaded by Cycles itself when the scene syncs. */
+		string filename = path_resolve(base_path, value);
+		if (n.type == shadernode_type::IMAGE_TEXTURE) static_cast<ccl::ImageTextureNode*>(n.node)->filename = filename;
+		else static_cast<ccl::EnvironmentTextureNode*>(n.node)->filename = filename;
+		return;
+	}
+
+	/* Not a socket, try the members the API knows for this node type. */
+	float f;
+	int i;
+	bool b;
+	if (get_int(&a.value, i) && is_int_member(n.type, name)) {
+		cycles_shadernode_set_member_int(ld.client_id, graph.shader_id, n.id, n.type, name.c_str(), i);
+	}
+	else if (get_float(&a.value, f)) {
+		cycles_shadernode_set_member_float(ld.client_id, graph.shader_id, n.id, n.type, name.c_str(), f);
+	}
+	else if (get_bool(&a.value, b)) {
+		cycles_shadernode_set_member_bool(ld.client_id, graph.shader_id, n.id, n.type, name.c_str(), b);
+	}
+	else {
+		cycles_shadernode_set_enum(ld.client_id, graph.shader_id, n.id, n.type, name.c_str(), value.c_str());
+	}
+}
+
+static ccl::ShaderOutput* find_output(ccl::ShaderNode* node, const XmlText& name)
+{
+	for (ccl::ShaderOutput* out : node->outputs) {
+		if (socket_name_matches(out->name, name)) return out;
+	}
+	return nullptr;
+}
+
+static ccl::ShaderInput* find_input(ccl::ShaderNode* node, const XmlText& name)
+{
+	for (ccl::ShaderInput* inp : node->inputs) {
+		if (socket_name_matches(inp->name, name)) return inp;
+	}
+	return nullptr;
+}
+
+/* Split "node socket" at the first space. */
+static bool split_socket(const XmlText* text, string& node, XmlText& socket)
+{
+	if (text == nullptr) return false;
+	const char* space = (const char*)memchr(text->begin, ' ', text->size());
+	if (space == nullptr) return false;
+	node = XmlText{ text->begin, space }.str();
+	socket = XmlText{ space + 1, text->end };
+	return !node.empty() && !socket.empty();
+}
+
+static bool read_graph_element(const XmlLoader& ld, const XmlPullParser& xml, XmlGraph& graph, const XmlState& state)
+{
+	if (xml.name == "connect") {
+		string from_node, to_node;
+		XmlText from_socket, to_socket;
+		if (!split_socket(xml.attribute("from"), from_node, from_socket) || !split_socket(xml.attribute("to"), to_node, to_socket)) {
+			CCLOG_ERROR(ld.client_id, "connect needs from and to as \"node socket\", line ", xml.line());
+			return false;
+		}
+
+		auto from = graph.nodes.find(from_node);
+		auto to = graph.nodes.find(to_node);
+		if (from == graph.nodes.end() || to == graph.nodes.end()) {
+			CCLOG_ERROR(ld.client_id, "connect uses a node not defined before it, line ", xml.line());
+			return false;
+		}
+
+		ccl::ShaderOutput* out = find_output(from->second.node, from_socket);
+		ccl::ShaderInput* inp = find_input(to->second.node, to_socket);
+		if (out == nullptr || inp == nullptr) {
+			CCLOG_ERROR(ld.client_id, "connect uses an unknown socket, line ", xml.line());
+			return false;
+		}
+
+		graph.sh->graph->connect(out, inp);
+		return true;
+	}
+
+	const XmlText* name = xml.attribute("name");
+	if (name == nullptr) return true;
+
+	shadernode_type type;
+	if (!find_node_type(xml.name, type)) {
+		CCLOG_ERROR(ld.client_id, "Unknown shader node ", xml.name.str(), ", line ", xml.line());
+		return false;
+	}
+
+	unsigned int node_id = cycles_add_shader_node(ld.client_id, graph.shader_id, type);
+	ccl::ShaderNode* node{ nullptr };
+	for (ccl::ShaderNode* sn : graph.sh->graph->nodes) {
+		if ((unsigned int)sn->id == node_id) node = sn;
+	}
+	if (node == nullptr) return false;
+
+	XmlNode n{ node_id, node, type };
+	for (const XmlAttribute& a : xml.attributes) {
+		if (a.name == "name") continue;
+		set_node_attribute(ld, graph, n, a, state.base_path);
+	}
+	graph.nodes[name->str()] = n;
+	return true;
+}
+
+static bool read_file(XmlLoader& ld, const string& path, const XmlState& parent);
+
+static bool read_include(XmlLoader& ld, const XmlPullParser& xml, const XmlState& state)
+{
+	const XmlText* src = xml.attribute("src");
+	if (src == nullptr || src->empty()) return true;
+
+	if (ld.include_depth >= MAX_INCLUDE_DEPTH) {
+		CCLOG_ERROR(ld.client_id, "Includes nested too deep, line ", xml.line());
+		return false;
+	}
+
+	ld.include_depth++;
+	bool ok = read_file(ld, path_resolve(state.base_path, src->str()), state);
+	ld.include_depth--;
+	return ok;
+}
+
+static bool read_file(XmlLoader& ld, const string& path, const XmlState& parent)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file) {
+		CCLOG_ERROR(ld.client_id, "Can't open ", path);
+		return false;
+	}
+	vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const char* begin = buffer.empty() ? nullptr : &buffer[0];
+
+	XmlPullParser xml(begin, begin + buffer.size());
+
+	vector<XmlState> states{ parent };
+	states.back().base_path = path_directory(path);
+	/* Per open element, whether it pushed a state. */
+	vector<bool> open;
+	XmlGraph graph;
+	graph.sh = nullptr;
+	XmlGraphGuard graph_guard{ ld, graph };
+
+	for (;;) {
+		xml_event e = xml.next();
+		if (e == xml_event::DONE) break;
+		if (e == xml_event::FAILED) {
+			CCLOG_ERROR(ld.client_id, "Malformed XML in ", path, ", line ", xml.line());
+			return false;
+		}
+
+		if (e == xml_event::END) {
+			if (open.empty()) {
+				CCLOG_ERROR(ld.client_id, "Unbalanced end element in ", path, ", line ", xml.line());
+				return false;
+			}
+			if (open.back()) states.pop_back();
+			open.pop_back();
+			if (graph.sh != nullptr && open.size() == graph.depth) end_graph(ld, graph);
+			continue;
+		}
+
+		const XmlState& state = states.back();
+		bool ok{ true };
+		bool push{ false };
+
+		if (graph.sh != nullptr) {
+			/* Only direct children of shader and background are nodes. */
+			if (open.size() == graph.depth + 1) ok = read_graph_element(ld, xml, graph, state);
+		}
+		else if (xml.name == "transform") {
+			states.push_back(state);
+			read_transform(xml, states.back().tfm);
+			push = true;
+		}
+		else if (xml.name == "lookat") {
+			states.push_back(state);
+			ok = read_lookat(ld, xml, states.back().tfm);
+			push = true;
+		}
+		else if (xml.name == "state") {
+			states.push_back(state);
+			read_state(ld, xml, states.back());
+			push = true;
+		}
+		else if (xml.name == "shader") {
+			begin_graph(ld, xml, false, open.size(), graph);
+		}
+		else if (xml.name == "background") {
+			begin_graph(ld, xml, true, open.size(), graph);
+		}
+		else if (xml.name == "camera") {
+			read_camera(ld, xml, state);
+		}
+		else if (xml.name == "integrator") {
+			read_integrator(ld, xml);
+		}
+		else if (xml.name == "mesh") {
+			ok = read_mesh(ld, xml, state);
+		}
+		else if (xml.name == "object") {
+			read_object(ld, xml, state);
+		}
+		else if (xml.name == "light") {
+			read_light(ld, xml, state);
+		}
+		else if (xml.name == "include") {
+			ok = read_include(ld, xml, state);
+		}
+		else if (!(xml.name == "cycles")) {
+			CCLOG_DEBUG(ld.client_id, "Skipping unknown element ", xml.name.str(), " in ", path, ", line ", xml.line());
+		}
+
+		if (!ok) return false;
+		open.push_back(push);
+	}
+
+	if (!open.empty()) {
+		CCLOG_ERROR(ld.client_id, "Unexpected end of ", path);
+		return false;
+	}
+	return true;
+}
+
+}
+
+unsigned int cycles_scene_load_xml(unsigned int client_id, unsigned int scene_id, const char* path)
+{
+	CCCAPTURE(cycles_scene_load_xml, client_id, scene_id, path);
+	SCENE_FIND(scene_id)
+		XmlLoader ld{ client_id, scene_id, sce, {}, {}, 0 };
+
+		XmlState state;
+		state.tfm = ccl::transform_identity();
+		state.shader = (unsigned int)sce->default_surface;
+		state.smooth = false;
+		state.is_shadowcatcher = false;
+
+		bool ok = read_file(ld, path, state);
+		CCLOG_DEBUG(client_id, "Loaded ", path, " into scene ", scene_id, ok ? "" : " with errors");
+		return ok ? 1 : 0;
+	SCENE_FIND_END()
+
+	return 0;
+}
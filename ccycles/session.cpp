@@ -14,46 +14,155 @@ See the License for the specific language governing permissions and
 limitations under the License.
 **/
 
+#include <algorithm>
+
 #include "internal_types.h"
 #include "util_opengl.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 extern std::vector<ccl::DeviceInfo> devices;
-extern std::vector<ccl::SessionParams> session_params;
+extern CCHandleTable<CCSessionParams> session_params;
 
-/* Hold all created sessions. */
-std::vector<CCSession*> sessions;
+extern ccl::Session* session_pool_acquire(const ccl::SessionParams& params);
+extern bool session_pool_has_room(const ccl::SessionParams& params);
+extern void session_pool_release(ccl::Session* session);
+extern void _cleanup_session_pool();
 
-/* Four vectors to hold registered callback functions.
- * For each created session a corresponding idx into these
- * vectors will exist, but in the case no callback
- * was registered the value for idx will be nullptr.
- */
-std::vector<STATUS_UPDATE_CB> status_cbs;
-std::vector<TEST_CANCEL_CB> cancel_cbs;
-std::vector<RENDER_TILE_CB> update_cbs;
-std::vector<RENDER_TILE_CB> write_cbs;
-std::vector<DISPLAY_UPDATE_CB> display_update_cbs;
+/* Hold all created sessions. */
+CCHandleTable<CCSession*> sessions;
 
 /* Wrap status update callback. */
 void CCSession::status_update(void) {
-	if (status_cbs[this->id] != nullptr) {
-		status_cbs[this->id](this->id);
+	if (time_limit > 0.0) {
+		apply_time_limit();
+	}
+	update_progress();
+	if (status_cb != nullptr && !dispatcher.post_status()) {
+		CCTRACE("callback", "status_cb");
+		status_cb(this->id);
 	}
 }
 
+void CCSession::apply_time_limit()
+{
+	/* Status updates come from all render threads, one of them doing the
+	 * math is enough.
+	 */
+	if (!budget_mutex.try_lock()) return;
+
+	/* Passes every pixel has finished, the samples per pixel of the last
+	 * complete frame.
+	 */
+	int completed = session->tile_manager.state.sample;
+	if (completed > 0 && requested_samples > 0) {
+		int tile;
+		double total_time, render_time, tile_time;
+		session->progress.get_tile(tile, total_time, render_time, tile_time);
+
+		if (render_time > 0.0) {
+			/* Time before rendering started (scene sync, kernel loading)
+			 * already ate into the budget, the rest is for samples.
+			 */
+			double per_sample = render_time / completed;
+			double render_budget = time_limit - (total_time - render_time);
+			int fit = (int)(render_budget / per_sample);
+
+			/* The pass in flight always completes, stopping halfway would
+			 * leave an unevenly sampled frame.
+			 */
+			int target = std::max(completed + 1, std::min(fit, requested_samples));
+			if (target != budget_samples) {
+				budget_samples = target;
+				session->set_samples(target);
+			}
+		}
+	}
+
+	budget_mutex.unlock();
+}
+
 /* Wrap status update callback. */
 void CCSession::test_cancel(void) {
-	if (cancel_cbs[this->id] != nullptr) {
-		cancel_cbs[this->id](this->id);
+	if (cancel_cb != nullptr) {
+		cancel_cb(this->id);
 	}
 }
 
 /* floats per pixel (rgba). */
 const int stride{ 4 };
 
-/* copy the pixel buffer from RenderTile to the final pixel buffer in CCSession. */
-void copy_pixels_to_ccsession(ccl::RenderTile &tile, unsigned int sid) {
+/* Staging buffer for get_pass_rect, one per render thread. Tiles are
+ * mostly the same size, so after the first tile on a thread no more
+ * allocations happen. Only grows, never shrinks.
+ */
+static thread_local std::vector<float> tile_pixels;
+
+/* Copy a tightly packed tile into a full image buffer one row at a time.
+ * Rows are flipped, Cycles has its origin bottom-left, the session buffers
+ * top-left.
+ */
+static void copy_tile_rows(float* dst, int dst_width, int dst_height, const float* src, int tilex, int tiley, int tile_width, int tile_height, int components)
+{
+	const size_t row_size = tile_width * components * sizeof(float);
+	for (int y = 0; y < tile_height; y++) {
+		/* from tile pixels coord. */
+		size_t tileidx = (size_t)y * tile_width * components;
+		/* to full image pixels coord. */
+		size_t fullimgidx = ((size_t)(dst_height - (tiley + y) - 1) * dst_width + tilex) * components;
+
+		memcpy(&dst[fullimgidx], &src[tileidx], row_size);
+	}
+}
+
+/* When this thread last handed over a tile. Threads render tiles back to
+ * back, so the time between two tiles is the time the second one took.
+ */
+struct TileClock {
+	const CCSession* session;
+	unsigned int generation;
+	std::chrono::steady_clock::time_point last;
+};
+static thread_local TileClock tile_clock{ nullptr, 0, {} };
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Adds the time copy_pixels_to_ccsession takes to the session stats, on
+ * any return.
+ */
+struct CopyTimer {
+	CCSessionStats& stats;
+	std::chrono::steady_clock::time_point start;
+	double lock_wait;
+
+	explicit CopyTimer(CCSessionStats& stats_)
+		: stats{ stats_ }, start{ std::chrono::steady_clock::now() }, lock_wait{ 0.0 }
+	{  }
+
+	~CopyTimer() {
+		stats.add_copy_time(seconds_since(start), lock_wait);
+	}
+};
+
+/* copy the pixel buffer from RenderTile to the final pixel buffer in CCSession,
+ * and each registered pass to its CCPass buffer. */
+void copy_pixels_to_ccsession(ccl::RenderTile &tile, CCSession* se) {
+	CCTRACE("copy", "copy_pixels");
+	CopyTimer timer(se->stats);
+
+	if (tile.resolution == 1) {
+		unsigned int generation = se->stats.generation;
+		if (tile_clock.session == se && tile_clock.generation == generation) {
+			se->stats.add_tile_time(seconds_since(tile_clock.last));
+			if (tracer.enabled()) {
+				tracer.record("tile", "render", tracer.to_us(tile_clock.last), tracer.to_us(timer.start));
+			}
+		}
+		tile_clock = TileClock{ se, generation, timer.start };
+	}
+
 
 	ccl::RenderBuffers* buffers = tile.buffers;
 	/* always do copy_from_device(). This is necessary when rendering is done
@@ -62,37 +171,118 @@ void copy_pixels_to_ccsession(ccl::RenderTile &tile, unsigned int sid) {
 	buffers->copy_from_device();
 	ccl::BufferParams& params = buffers->params;
 
-	/* have a local float buffer to copy tile buffer to. */
-	std::vector<float> pixels(params.width*params.height * stride, 0.5f);
-
-	CCSession* se = sessions[sid];
-	int scewidth = params.full_width;
-	int sceheight = params.full_height;
+	/* Low resolution preview passes don't add to the accumulation. */
+	if (tile.resolution == 1) {
+		ccl::thread_scoped_lock raw_lock(se->raw.mutex);
+		if (se->raw.enabled) {
+			se->raw.copy_tile(tile, se->session->tile_manager.params.full_x, se->session->tile_manager.params.full_y);
+		}
+	}
 
 	int tilex = params.full_x - se->session->tile_manager.params.full_x;
 	int tiley = params.full_y - se->session->tile_manager.params.full_y;
 
+	/* stride is the widest pass we copy, so big enough for all passes. */
+	size_t tile_size = (size_t)params.width * params.height * stride;
+	if (tile_pixels.size() < tile_size) {
+		tile_pixels.resize(tile_size);
+	}
+
 	/* Copy the tile buffer to pixels. */
-	if (!buffers->get_pass_rect(ccl::PassType::PASS_COMBINED, 1.0f, tile.sample, stride, &pixels[0])) {
+	if (!buffers->get_pass_rect(ccl::PassType::PASS_COMBINED, 1.0f, tile.sample, stride, &tile_pixels[0])) {
 		return;
 	}
 
-	ccl::thread_scoped_lock pixels_lock(se->pixels_mutex);
+	/* Low resolution preview passes say nothing about the noise of the final image. */
+	if (tile.resolution == 1 && se->convergence.update(&tile_pixels[0], tilex, tiley, params.width, params.height, tile.sample)) {
+		/* Every tile has converged, end the render at the current sample. */
+		se->session->set_samples(tile.sample);
+	}
+
+	{
+		auto lock_start = std::chrono::steady_clock::now();
+		ccl::thread_scoped_lock pixels_lock(se->pixels_mutex);
+		timer.lock_wait += seconds_since(lock_start);
+
+		/* Session got reset to a smaller size while this tile was rendering. */
+		if (tilex + params.width > se->width || tiley + params.height > se->height) {
+			return;
+		}
+
+		copy_tile_rows(se->pixels, se->width, se->height, &tile_pixels[0], tilex, tiley, params.width, params.height, stride);
+
+		/* Hand the updated image to readers. */
+		CCRect rect{ tilex, se->height - (tiley + params.height), params.width, params.height };
+		se->publish_rect(rect);
+	}
+
+	for (CCPass* pass : se->passes) {
+		if (!buffers->get_pass_rect(pass->type, 1.0f, tile.sample, pass->buffer_stride, &tile_pixels[0])) {
+			continue;
+		}
+
+		ccl::thread_scoped_lock pass_lock(pass->pixels_mutex);
+
+		if (tilex + params.width > pass->width || tiley + params.height > pass->height) {
+			continue;
+		}
+
+		copy_tile_rows(pass->pixels, pass->width, pass->height, &tile_pixels[0], tilex, tiley, params.width, params.height, pass->buffer_stride);
+	}
+}
+
+void CCSession::resolve_raw()
+{
+	ccl::thread_scoped_lock raw_lock(raw.mutex);
+	if (raw.data.empty()) return;
+
+	ccl::BufferParams params = session->tile_manager.params;
+	if (params.width != raw.width || params.height != raw.height || params.get_passes_size() != raw.pass_stride) return;
+
+	/* get_pass_rect normalizes by one sample count for all pixels, so scale
+	 * every pixel up to the highest count first.
+	 */
+	unsigned int max_samples = *std::max_element(raw.samples.begin(), raw.samples.end());
+	if (max_samples == 0) return;
+
+	ccl::RenderBuffers buffers(session->device);
+	buffers.reset(session->device, params);
+	float* dst = (float*)buffers.buffer.data_pointer;
+
+	const size_t pass_stride = raw.pass_stride;
+	for (int y = 0; y < raw.height; y++) {
+		for (int x = 0; x < raw.width; x++) {
+			size_t from = (size_t)y * raw.width + x;
+			/* Back to Cycles row order. */
+			size_t to = (size_t)(raw.height - y - 1) * raw.width + x;
+			unsigned int n = raw.samples[from];
+			float scale = n > 0 ? (float)max_samples / n : 0.0f;
+
+			for (size_t i = 0; i < pass_stride; i++) {
+				dst[to * pass_stride + i] = raw.data[from * pass_stride + i] * scale;
+			}
+		}
+	}
 
-	/* Copy pixels to final image buffer. */
-	bool firstpass = true;
-	for (int y = 0; y < params.height; y++) {
-		for (int x = 0; x < params.width; x++) {
-			/* from tile pixels coord. */
-			int tileidx = y * params.width * stride + x * stride;
-			/* to full image pixels coord. */
-			int fullimgidx = (sceheight - (tiley + y) - 1) * scewidth * stride + (tilex + x) * stride;
+	/* stride is the widest pass we copy, so big enough for all passes. */
+	std::vector<float> result((size_t)raw.width * raw.height * stride);
 
-			/* copy the tile pixels from pixels into session final pixel buffer. */
-			se->pixels[fullimgidx + 0] = pixels[tileidx + 0];
-			se->pixels[fullimgidx + 1] = pixels[tileidx + 1];
-			se->pixels[fullimgidx + 2] = pixels[tileidx + 2];
-			se->pixels[fullimgidx + 3] = pixels[tileidx + 3];
+	if (buffers.get_pass_rect(ccl::PassType::PASS_COMBINED, 1.0f, (int)max_samples, stride, &result[0])) {
+		ccl::thread_scoped_lock pixels_lock(pixels_mutex);
+		if (width == raw.width && height == raw.height) {
+			copy_tile_rows(pixels, width, height, &result[0], 0, 0, raw.width, raw.height, stride);
+			publish_all();
+		}
+	}
+
+	for (CCPass* pass : passes) {
+		if (!buffers.get_pass_rect(pass->type, 1.0f, (int)max_samples, pass->buffer_stride, &result[0])) {
+			continue;
+		}
+
+		ccl::thread_scoped_lock pass_lock(pass->pixels_mutex);
+		if (pass->width == raw.width && pass->height == raw.height) {
+			copy_tile_rows(pass->pixels, pass->width, pass->height, &result[0], 0, 0, raw.width, raw.height, pass->buffer_stride);
 		}
 	}
 }
@@ -100,43 +290,52 @@ void copy_pixels_to_ccsession(ccl::RenderTile &tile, unsigned int sid) {
 /* Wrapper callback for render tile update. Copies tile result into session full image buffer. */
 void CCSession::update_render_tile(ccl::RenderTile &tile)
 {
-	copy_pixels_to_ccsession(tile, this->id);
+	copy_pixels_to_ccsession(tile, this);
 
 	ccl::RenderBuffers* buffers = tile.buffers;
 	ccl::BufferParams& params = buffers->params;
 
-	CCSession* se = sessions[this->id];
+	int tilex = params.full_x - session->tile_manager.params.full_x;
+	int tiley = params.full_y - session->tile_manager.params.full_y;
 
-	int tilex = params.full_x - se->session->tile_manager.params.full_x;
-	int tiley = params.full_y - se->session->tile_manager.params.full_y;
+	push_event(session_event::TILE_UPDATE, tilex, tiley, params.width, params.height);
 
-	if (update_cbs[this->id] != nullptr) {
-		update_cbs[this->id](this->id, tilex, tiley, params.width, params.height, 4, tile.start_sample, tile.num_samples, tile.sample, tile.resolution);
+	if (update_tile_cb != nullptr) {
+		CCTileNotification notification{ false, tilex, tiley, params.width, params.height, tile.start_sample, tile.num_samples, tile.sample, tile.resolution };
+		if (!dispatcher.post_tile(notification)) {
+			CCTRACE("callback", "update_tile_cb");
+			update_tile_cb(this->id, tilex, tiley, params.width, params.height, 4, tile.start_sample, tile.num_samples, tile.sample, tile.resolution);
+		}
 	}
 }
 
 /* Wrapper callback for render tile write. Copies tile result into session full image buffer. */
 void CCSession::write_render_tile(ccl::RenderTile &tile)
 {
-	copy_pixels_to_ccsession(tile, this->id);
+	copy_pixels_to_ccsession(tile, this);
 
 	ccl::RenderBuffers* buffers = tile.buffers;
 	ccl::BufferParams& params = buffers->params;
 
-	auto se = sessions[this->id];
+	auto tilex = params.full_x - session->tile_manager.params.full_x;
+	auto tiley = params.full_y - session->tile_manager.params.full_y;
 
-	auto tilex = params.full_x - se->session->tile_manager.params.full_x;
-	auto tiley = params.full_y - se->session->tile_manager.params.full_y;
-	if (write_cbs[this->id] != nullptr) {
-		write_cbs[this->id](this->id, tilex, tiley, params.width, params.height, 4, tile.start_sample, tile.num_samples, tile.sample, tile.resolution);
+	push_event(session_event::TILE_DONE, tilex, tiley, params.width, params.height);
+	if (write_tile_cb != nullptr) {
+		CCTileNotification notification{ true, tilex, tiley, params.width, params.height, tile.start_sample, tile.num_samples, tile.sample, tile.resolution };
+		if (!dispatcher.post_tile(notification)) {
+			CCTRACE("callback", "write_tile_cb");
+			write_tile_cb(this->id, tilex, tiley, params.width, params.height, 4, tile.start_sample, tile.num_samples, tile.sample, tile.resolution);
+		}
 	}
 }
 
 /* Wrapper callback for display update stuff. When this is called one pass has been conducted. */
 void CCSession::display_update(int sample)
 {
-	if (display_update_cbs[this->id] != nullptr) {
-		display_update_cbs[this->id](this->id, sample);
+	if (display_update_cb != nullptr && !dispatcher.post_display(sample)) {
+		CCTRACE("callback", "display_update_cb");
+		display_update_cb(this->id, sample);
 	}
 }
 
@@ -145,23 +344,14 @@ void CCSession::display_update(int sample)
  */
 void _cleanup_sessions()
 {
-	for (CCSession* se : sessions) {
-		{
-			ccl::thread_scoped_lock pixels_lock(se->pixels_mutex);
-			delete[] se->pixels;
-		}
-		delete se->session;
+	sessions.for_each([](unsigned int session_id, CCSession* se) {
 		delete se;
-	}
+	});
 
 	sessions.clear();
 	session_params.clear();
 
-	status_cbs.clear();
-	cancel_cbs.clear();
-	update_cbs.clear();
-	write_cbs.clear();
-	update_cbs.clear();
+	_cleanup_session_pool();
 }
 
 CCSession* CCSession::create(int width, int height, unsigned int buffer_stride) {
@@ -171,210 +361,401 @@ CCSession* CCSession::create(int width, int height, unsigned int buffer_stride)
 	CCSession* se = new CCSession(pixels_, img_size*buffer_stride, buffer_stride);
 	se->width = width;
 	se->height = height;
+	se->display.reset(width, height, buffer_stride*buffer_format_component_size(se->format));
+	se->convergence.reset(width, height);
 
 	return se;
 }
 void CCSession::reset(int width_, int height_, unsigned int buffer_stride_) {
 	ccl::thread_scoped_lock pixels_lock(pixels_mutex);
 	int img_size = width_ * height_;
+	bool resized = width_ != width || height_ != height;
 	if (img_size*buffer_stride_ != buffer_size || buffer_stride_ != buffer_stride) {
 		delete[] pixels;
 
 		pixels = new float[img_size*buffer_stride_] {0};
-		memset(pixels, 0, sizeof(float)*img_size*buffer_stride);
+		memset(pixels, 0, sizeof(float)*img_size*buffer_stride_);
 		buffer_size = img_size*buffer_stride_;
 		buffer_stride = buffer_stride_;
-		width = width_;
-		height = height_;
+		resized = true;
+	}
+
+	/* Tiles are placed by width and height, these change with the aspect
+	 * even when the pixel count stays the same.
+	 */
+	width = width_;
+	height = height_;
+
+	if (resized) {
+		set_format(format);
 	}
+
+	for (CCPass* pass : passes) {
+		ccl::thread_scoped_lock pass_lock(pass->pixels_mutex);
+		pass->reset(width_, height_);
+	}
+
+	convergence.reset(width_, height_);
 }
 
-unsigned int cycles_session_create(unsigned int client_id, unsigned int session_params_id, unsigned int scene_id)
-{
-	ccl::SessionParams params;
-	if (session_params_id >= 0 && session_params_id < session_params.size()) {
-		params = session_params[session_params_id];
+void CCSession::publish_rect(const CCRect& rect) {
+	if (converted) {
+		for (int y = rect.y; y < rect.y + rect.height; y++) {
+			size_t idx = ((size_t)y * width + rect.x) * buffer_stride;
+			convert_pixels(format, &converted[idx*buffer_format_component_size(format)], &pixels[idx], rect.width, buffer_stride);
+		}
+	}
+	display.mark_dirty(rect);
+	display.publish(converted ? converted : (unsigned char*)pixels);
+}
+
+void CCSession::publish_all() {
+	if (converted) {
+		convert_pixels(format, converted, pixels, (size_t)width * height, buffer_stride);
 	}
+	display.mark_all_dirty();
+	display.publish(converted ? converted : (unsigned char*)pixels);
+}
 
-	CCScene& sce = scenes[scene_id];
+void CCSession::set_format(buffer_format format_) {
+	format = format_;
 
-	int csesid{ -1 };
-	int hid{ 0 };
+	delete[] converted;
+	converted = nullptr;
+	if (format != buffer_format::FLOAT) {
+		converted = new unsigned char[buffer_size*buffer_format_component_size(format)];
+	}
 
-	CCSession* session = CCSession::create(sce.scene->camera->width, sce.scene->camera->height, 4);
-	// TODO: pass ccl::Session into CCSession::create
-	session->session = new ccl::Session(params);
-	session->session->scene = sce.scene;
+	display.reset(width, height, buffer_stride*buffer_format_component_size(format));
+	publish_all();
+}
 
-	auto csessit = sessions.begin();
-	auto csessend = sessions.end();
-	while (csessit != csessend) {
-		if ((*csessit) == nullptr) {
-			csesid = hid;
-		}
-		++hid;
-		++csessit;
+CCPass* CCSession::find_pass(ccl::PassType type) {
+	for (CCPass* pass : passes) {
+		if (pass->type == type) return pass;
 	}
 
-	if (csesid == -1) {
-		sessions.push_back(session);
-		csesid = (unsigned int)(sessions.size() - 1);
-		status_cbs.push_back(nullptr);
-		cancel_cbs.push_back(nullptr);
-		update_cbs.push_back(nullptr);
-		write_cbs.push_back(nullptr);
-		display_update_cbs.push_back(nullptr);
+	return nullptr;
+}
+
+void CCPass::reset(int width_, int height_) {
+	unsigned int img_size = (unsigned int)(width_ * height_);
+	if (img_size*buffer_stride != buffer_size || pixels == nullptr) {
+		delete[] pixels;
+
+		pixels = new float[img_size*buffer_stride];
+		memset(pixels, 0, sizeof(float)*img_size*buffer_stride);
+		buffer_size = img_size*buffer_stride;
+	}
+	width = width_;
+	height = height_;
+}
+
+unsigned int cycles_session_create(unsigned int client_id, unsigned int session_params_id, unsigned int scene_id)
+{
+	CCCAPTURE(cycles_session_create, client_id, session_params_id, scene_id);
+	CCTRACE_API();
+	CCSessionParams params;
+	if (CCSessionParams* sp = session_params.get(session_params_id)) {
+		params = *sp;
 	}
-	else {
-		sessions[csesid] = session;
-		status_cbs[csesid] = nullptr;
-		update_cbs[csesid] = nullptr;
-		write_cbs[csesid] = nullptr;
-		display_update_cbs[csesid] = nullptr;
+	if (params.time_limit > 0.0) {
+		/* Only progressive refine renders all pixels pass by pass, so the
+		 * frame is complete and even whenever the budget runs out.
+		 */
+		params.progressive_refine = true;
 	}
 
+	CCScene* sce = scenes.get(scene_id);
+	if (sce == nullptr || sce->scene == nullptr) return UINT_MAX;
+
+	CCSession* session = CCSession::create(sce->scene->camera->width, sce->scene->camera->height, 4);
+	// TODO: pass ccl::Session into CCSession::create
+	session->session = session_pool_acquire(params);
+	session->session->scene = sce->scene;
+
+	unsigned int csesid = sessions.insert(session);
+	if (csesid == sessions.INVALID) {
+		session->session->scene = nullptr;
+		delete session;
+		return UINT_MAX;
+	}
 
 	session->id = csesid;
+	session->requested_samples = params.samples;
 
-	logger.logit(client_id, "Created session ", session->id, " for scene ", scene_id, " with session_params ", session_params_id);
+	session->time_limit = params.time_limit;
+
+	/* Always listen to progress, for the snapshot, events and time limit. */
+	session->session->progress.set_update_callback(function_bind<void>(&CCSession::status_update, session));
+	/* Always take tiles too, so pixels and tile events reach clients
+	 * that only poll. The client tile callbacks are called when set.
+	 */
+	session->session->update_render_tile_cb = function_bind<void>(&CCSession::update_render_tile, session, std::placeholders::_1);
+	session->session->write_render_tile_cb = function_bind<void>(&CCSession::write_render_tile, session, std::placeholders::_1);
+
+	CCLOG_DEBUG(client_id, "Created session ", session->id, " for scene ", scene_id, " with session_params ", session_params_id);
 
 	return session->id;
 }
 
 void cycles_session_destroy(unsigned int client_id, unsigned int session_id)
 {
+	CCCAPTURE(cycles_session_destroy, client_id, session_id);
 	SESSION_FIND(session_id)
 
-	CCSession* ccses = sessions[session_id];
+	/* Release the scene handle too. Don't delete the scene here, since
+	 * session deconstructor takes care of it.
+	 */
+	unsigned int scene_id{ UINT_MAX };
+	scenes.for_each([&](unsigned int id, CCScene& csc) {
+		if (csc.scene == session->scene) scene_id = id;
+	});
+	scenes.remove(scene_id);
+
+	sessions.remove(session_id);
+
+	/* Keep the ccl::Session for reuse when the pool has room. */
+	if (session_pool_has_room(session->params)) {
+		if (ccsess->running) {
+			session->progress.set_cancel("Returned to pool");
+			session->set_pause(false);
+			session->wait();
+		}
+		session_pool_release(session);
+		ccsess->session = nullptr;
+	}
 
-	for (CCScene& csc : scenes) {
-		if (csc.scene == session->scene) {
-			csc.scene = nullptr; /* don't delete here, since session deconstructor takes care of it. */
+	delete ccsess;
+
+	SESSION_FIND_END()
+}
+
+/* Reset se to render the width x height region at x, y of a full_width x
+ * full_height frame. x, y are from the top-left like the session buffer,
+ * Cycles counts full_y from the bottom.
+ */
+static void reset_session_region(CCSession* se, unsigned int full_width, unsigned int full_height, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int samples)
+{
+	ccl::Session* session = se->session;
+	/* Pixels only hold the region, tiles get copied relative to its corner. */
+	se->reset(width, height, 4);
+	ccl::BufferParams bufParams;
+	bufParams.full_x = x;
+	bufParams.full_y = full_height - (y + height);
+	bufParams.width = width;
+	bufParams.height = height;
+	bufParams.full_width = full_width;
+	bufParams.full_height = full_height;
+	if (session->scene) {
+		/* Make sure the render buffers hold all passes registered on the film. */
+		bufParams.passes = session->scene->film->passes;
+	}
+	{
+		ccl::thread_scoped_lock raw_lock(se->raw.mutex);
+		if (se->raw.enabled) {
+			se->raw.reset(width, height, bufParams.get_passes_size());
+		}
+		else {
+			se->raw.reset(0, 0, 0);
 		}
 	}
+	se->requested_samples = (int)samples;
+	se->budget_samples = 0;
+	se->last_sample = -1;
+	se->finished_sent = false;
+	se->error_sent = false;
+	se->stats.reset();
+	session->reset(bufParams, (int)samples);
+	session->set_pause(false);
+}
 
-	delete ccses;
+void cycles_session_reset(unsigned int client_id, unsigned int session_id, unsigned int width, unsigned int height, unsigned int samples)
+{
+	CCCAPTURE(cycles_session_reset, client_id, session_id, width, height, samples);
+	SESSION_FIND(session_id)
+		CCLOG_DEBUG(client_id, "Reset session ", session_id, ". width ", width, " height ", height, " samples ", samples);
+		reset_session_region(ccsess, width, height, 0, 0, width, height, samples);
+	SESSION_FIND_END()
+}
 
-	sessions[session_id] = nullptr;
+void cycles_session_reset_region(unsigned int client_id, unsigned int session_id, unsigned int full_width, unsigned int full_height, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int samples)
+{
+	CCCAPTURE(cycles_session_reset_region, client_id, session_id, full_width, full_height, x, y, width, height, samples);
+	if (width == 0 || height == 0 || x + width > full_width || y + height > full_height) {
+		CCLOG_WARNING(client_id, "Region ", x, ",", y, " ", width, "x", height, " outside of ", full_width, "x", full_height, " frame");
+		return;
+	}
 
+	SESSION_FIND(session_id)
+		CCLOG_DEBUG(client_id, "Reset session ", session_id, " to region ", x, ",", y, " ", width, "x", height, " of ", full_width, "x", full_height, " samples ", samples);
+		reset_session_region(ccsess, full_width, full_height, x, y, width, height, samples);
 	SESSION_FIND_END()
 }
 
-void cycles_session_reset(unsigned int client_id, unsigned int session_id, unsigned int width, unsigned int height, unsigned int samples)
+void cycles_session_set_keep_raw_buffer(unsigned int client_id, unsigned int session_id, unsigned int keep)
 {
+	CCCAPTURE(cycles_session_set_keep_raw_buffer, client_id, session_id, keep);
 	SESSION_FIND(session_id)
-		logger.logit(client_id, "Reset session ", session_id, ". width ", width, " height ", height, " samples ", samples);
-		CCSession* se = sessions[session_id];
-		se->reset(width, height, 4);
-		ccl::BufferParams bufParams;
-		bufParams.width = bufParams.full_width = width;
-		bufParams.height = bufParams.full_height = height;
-		session->reset(bufParams, (int)samples);
-		session->set_pause(false);
+		ccl::thread_scoped_lock raw_lock(ccsess->raw.mutex);
+		ccsess->raw.enabled = keep == 1;
+		CCLOG_DEBUG(client_id, "Set keep raw buffer for session ", session_id, " to ", keep);
 	SESSION_FIND_END()
 }
 
-void cycles_session_set_update_callback(unsigned int client_id, unsigned int session_id, void(*update)(unsigned int sid))
+void cycles_session_get_raw_buffer_info(unsigned int client_id, unsigned int session_id, unsigned int* width, unsigned int* height, unsigned int* pass_stride)
+{
+	*width = *height = *pass_stride = 0;
+	SESSION_FIND(session_id)
+		ccl::thread_scoped_lock raw_lock(ccsess->raw.mutex);
+		*width = ccsess->raw.width;
+		*height = ccsess->raw.height;
+		*pass_stride = ccsess->raw.pass_stride;
+	SESSION_FIND_END()
+}
+
+void cycles_session_copy_raw_buffer(unsigned int client_id, unsigned int session_id, float* buffer, unsigned int* samples)
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
-		status_cbs[session_id] = update;
-		if (update != nullptr) {
-			session->progress.set_update_callback(function_bind<void>(&CCSession::status_update, se));
+		ccl::thread_scoped_lock raw_lock(ccsess->raw.mutex);
+		if (!ccsess->raw.data.empty()) {
+			memcpy(buffer, &ccsess->raw.data[0], ccsess->raw.data.size() * sizeof(float));
+			memcpy(samples, &ccsess->raw.samples[0], ccsess->raw.samples.size() * sizeof(unsigned int));
 		}
-		else {
-			session->progress.set_update_callback(nullptr);
+	SESSION_FIND_END()
+}
+
+void cycles_session_import_raw_buffer(unsigned int client_id, unsigned int session_id, const float* buffer, const unsigned int* samples)
+{
+	SESSION_FIND(session_id)
+		{
+			ccl::thread_scoped_lock raw_lock(ccsess->raw.mutex);
+			if (ccsess->raw.data.empty()) return;
+			/* Buffer sizes are only known here. */
+			CCCAPTURE(cycles_session_import_raw_buffer, client_id, session_id, capture_array(buffer, ccsess->raw.data.size()), capture_array(samples, ccsess->raw.samples.size()));
+			memcpy(&ccsess->raw.data[0], buffer, ccsess->raw.data.size() * sizeof(float));
+			memcpy(&ccsess->raw.samples[0], samples, ccsess->raw.samples.size() * sizeof(unsigned int));
 		}
-		logger.logit(client_id, "Set status update callback for session ", session_id);
+		ccsess->resolve_raw();
+		CCLOG_DEBUG(client_id, "Imported raw buffer into session ", session_id);
+	SESSION_FIND_END()
+}
+
+void cycles_merge_raw_buffers(float* dst, unsigned int* dst_samples, const float* src, const unsigned int* src_samples, unsigned int pixel_count, unsigned int pass_stride)
+{
+	CCTRACE_API();
+	if (dst == nullptr || dst_samples == nullptr || src == nullptr || src_samples == nullptr) return;
+	merge_raw_buffers(dst, dst_samples, src, src_samples, pixel_count, pass_stride);
+}
+
+void cycles_merge_region(float* full_buffer, unsigned int full_width, unsigned int full_height, const float* region_buffer, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int stride)
+{
+	CCTRACE_API();
+	if (full_buffer == nullptr || region_buffer == nullptr) return;
+	/* Written so a huge x or y can't wrap around. */
+	if (x > full_width || width > full_width - x || y > full_height || height > full_height - y) return;
+
+	const size_t row_size = (size_t)width * stride * sizeof(float);
+	for (unsigned int row = 0; row < height; row++) {
+		size_t src = (size_t)row * width * stride;
+		size_t dst = ((size_t)(y + row) * full_width + x) * stride;
+		memcpy(&full_buffer[dst], &region_buffer[src], row_size);
+	}
+}
+
+void cycles_session_set_update_callback(unsigned int client_id, unsigned int session_id, void(*update)(unsigned int sid))
+{
+	SESSION_FIND(session_id)
+		/* The progress update callback stays installed, status_update
+		 * only calls update when set.
+		 */
+		ccsess->status_cb = update;
+		CCLOG_DEBUG(client_id, "Set status update callback for session ", session_id);
 	SESSION_FIND_END()
 }
 
 void cycles_session_set_cancel_callback(unsigned int client_id, unsigned int session_id, void(*cancel)(unsigned int sid))
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
-		cancel_cbs[session_id] = cancel;
+		CCSession* se = ccsess;
+		ccsess->cancel_cb = cancel;
 		if (cancel != nullptr) {
 			session->progress.set_cancel_callback(function_bind<void>(&CCSession::test_cancel, se));
 		}
 		else {
 			session->progress.set_cancel_callback(nullptr);
 		}
-		logger.logit(client_id, "Set status cancel callback for session ", session_id);
+		CCLOG_DEBUG(client_id, "Set status cancel callback for session ", session_id);
 	SESSION_FIND_END()
 }
 
 void cycles_session_set_update_tile_callback(unsigned int client_id, unsigned int session_id, RENDER_TILE_CB update_tile_cb)
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
-		update_cbs[session_id] = update_tile_cb;
-		if (update_tile_cb != nullptr) {
-			session->update_render_tile_cb = function_bind<void>(&CCSession::update_render_tile, ccsess, std::placeholders::_1);
-		}
-		else {
-			session->update_render_tile_cb = nullptr;
-		}
-		logger.logit(client_id, "Set render tile update callback for session ", session_id);
+		ccsess->update_tile_cb = update_tile_cb;
+		CCLOG_DEBUG(client_id, "Set render tile update callback for session ", session_id);
 	SESSION_FIND_END()
 }
 
 void cycles_session_set_write_tile_callback(unsigned int client_id, unsigned int session_id, RENDER_TILE_CB write_tile_cb)
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
-		write_cbs[session_id] = write_tile_cb;
-		if (write_tile_cb != nullptr) {
-			session->write_render_tile_cb = function_bind<void>(&CCSession::write_render_tile, ccsess, std::placeholders::_1);
-		}
-		else {
-			session->write_render_tile_cb = nullptr;
-		}
-		logger.logit(client_id, "Set render tile write callback for session ", session_id);
+		ccsess->write_tile_cb = write_tile_cb;
+		CCLOG_DEBUG(client_id, "Set render tile write callback for session ", session_id);
 	SESSION_FIND_END()
 }
 
 void cycles_session_set_display_update_callback(unsigned int client_id, unsigned int session_id, DISPLAY_UPDATE_CB display_update_cb)
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
-		display_update_cbs[session_id] = display_update_cb;
+		CCSession* se = ccsess;
+		ccsess->display_update_cb = display_update_cb;
 		if (display_update_cb != nullptr) {
 			session->display_update_cb = function_bind<void>(&CCSession::display_update, ccsess, std::placeholders::_1);
 		}
 		else {
 			session->display_update_cb = nullptr;
 		}
-		logger.logit(client_id, "Set display update callback for session ", session_id);
+		CCLOG_DEBUG(client_id, "Set display update callback for session ", session_id);
 	SESSION_FIND_END()
 }
 
 void cycles_session_cancel(unsigned int client_id, unsigned int session_id, const char *cancel_message)
 {
+	CCCAPTURE(cycles_session_cancel, client_id, session_id, cancel_message);
 	SESSION_FIND(session_id)
-		logger.logit(client_id, "Cancel session ", session_id, " with message ", cancel_message);
+		CCLOG_DEBUG(client_id, "Cancel session ", session_id, " with message ", cancel_message);
 		session->progress.set_cancel(std::string(cancel_message));
 	SESSION_FIND_END()
 }
 
 void cycles_session_start(unsigned int client_id, unsigned int session_id)
 {
+	CCCAPTURE(cycles_session_start, client_id, session_id);
 	SESSION_FIND(session_id)
-		logger.logit(client_id, "Starting session ", session_id);
+		CCLOG_DEBUG(client_id, "Starting session ", session_id);
 		session->start();
+		ccsess->running = true;
 	SESSION_FIND_END()
 }
 
 void cycles_session_wait(unsigned int client_id, unsigned int session_id)
 {
+	CCCAPTURE(cycles_session_wait, client_id, session_id);
 	SESSION_FIND(session_id)
-		logger.logit(client_id, "Waiting for session ", session_id);
+		CCLOG_DEBUG(client_id, "Waiting for session ", session_id);
 		session->wait();
+		ccsess->running = false;
+		/* The render thread is gone, catch the final state. */
+		ccsess->update_progress();
+		/* Hand the client everything before returning. */
+		ccsess->dispatcher.flush();
 	SESSION_FIND_END()
 }
 
 void cycles_session_set_pause(unsigned int client_id, unsigned int session_id, bool pause)
 {
+	CCCAPTURE(cycles_session_set_pause, client_id, session_id, pause);
 	SESSION_FIND(session_id)
 		session->set_pause(pause);
 	SESSION_FIND_END()
@@ -382,7 +763,10 @@ void cycles_session_set_pause(unsigned int client_id, unsigned int session_id, b
 
 void cycles_session_set_samples(unsigned int client_id, unsigned int session_id, int samples)
 {
+	CCCAPTURE(cycles_session_set_samples, client_id, session_id, samples);
 	SESSION_FIND(session_id)
+		ccsess->requested_samples = samples;
+		ccsess->budget_samples = 0;
 		session->set_samples(samples);
 	SESSION_FIND_END()
 }
@@ -390,30 +774,194 @@ void cycles_session_set_samples(unsigned int client_id, unsigned int session_id,
 void cycles_session_get_buffer_info(unsigned int client_id, unsigned int session_id, unsigned int* buffer_size, unsigned int* buffer_stride)
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
+		CCSession* se = ccsess;
 		*buffer_size = se->buffer_size;
 		*buffer_stride = se->buffer_stride;
-		logger.logit(client_id, "Session ", session_id, " get_buffer_info. size ", *buffer_size, " stride ", *buffer_stride);
+		CCLOG_TRACE(client_id, "Session ", session_id, " get_buffer_info. size ", *buffer_size, " stride ", *buffer_stride);
 	SESSION_FIND_END()
 }
 
 float* cycles_session_get_buffer(unsigned int client_id, unsigned int session_id)
 {
 	SESSION_FIND(session_id);
-		CCSession* se = sessions[session_id];
+		CCSession* se = ccsess;
 		return se->pixels;
 	SESSION_FIND_END();
 
 	return nullptr;
 }
 
-void cycles_session_copy_buffer(unsigned int client_id, unsigned int session_id, float* pixel_buffer)
+void cycles_session_copy_buffer(unsigned int client_id, unsigned int session_id, void* pixel_buffer)
 {
 	SESSION_FIND(session_id)
-		CCSession* se = sessions[session_id];
-		ccl::thread_scoped_lock pixels_lock(se->pixels_mutex);
-		memcpy(pixel_buffer, se->pixels, se->buffer_size*sizeof(float));
-		logger.logit(client_id, "Session ", session_id, " copy complete pixel buffer");
+		CCSession* se = ccsess;
+		/* Read the latest published frame, this never waits for render threads. */
+		ccl::thread_scoped_lock reader_lock(se->display.reader_mutex);
+		unsigned long long generation{ 0 };
+		se->display.copy_all(pixel_buffer, generation);
+		CCLOG_TRACE(client_id, "Session ", session_id, " copy complete pixel buffer, generation ", generation);
+	SESSION_FIND_END()
+}
+
+unsigned int cycles_session_copy_buffer_sized(unsigned int client_id, unsigned int session_id, void* pixel_buffer, unsigned long long buffer_bytes)
+{
+	SESSION_FIND(session_id)
+		CCSession* se = ccsess;
+		/* Format changes reset the display buffer under reader_mutex, so
+		 * the size can't change between the check and the copy.
+		 */
+		ccl::thread_scoped_lock reader_lock(se->display.reader_mutex);
+		if (buffer_bytes != se->display.buffer_bytes) {
+			CCLOG_ERROR(client_id, "Session ", session_id, " buffer is ", se->display.buffer_bytes, " bytes in its current format, got ", buffer_bytes);
+			return 0;
+		}
+		unsigned long long generation{ 0 };
+		se->display.copy_all(pixel_buffer, generation);
+		CCLOG_TRACE(client_id, "Session ", session_id, " copy complete pixel buffer, generation ", generation);
+		return 1;
+	SESSION_FIND_END()
+
+	return 0;
+}
+
+int cycles_session_copy_dirty_regions(unsigned int client_id, unsigned int session_id, void* pixel_buffer, cycles_rect* rects, int max_rects)
+{
+	SESSION_FIND(session_id)
+		CCSession* se = ccsess;
+		if (rects == nullptr || max_rects < 1) return 0;
+
+		std::vector<CCRect> dirty(max_rects);
+
+		ccl::thread_scoped_lock reader_lock(se->display.reader_mutex);
+		unsigned long long generation{ 0 };
+		int count = se->display.copy_dirty(pixel_buffer, &dirty[0], max_rects, generation);
+
+		for (int i = 0; i < count; i++) {
+			rects[i].x = dirty[i].x;
+			rects[i].y = dirty[i].y;
+			rects[i].width = dirty[i].width;
+			rects[i].height = dirty[i].height;
+		}
+
+		CCLOG_TRACE(client_id, "Session ", session_id, " copy ", count, " dirty regions, generation ", generation);
+		return count;
+	SESSION_FIND_END()
+
+	return 0;
+}
+
+void cycles_session_set_buffer_format(unsigned int client_id, unsigned int session_id, buffer_format format)
+{
+	CCCAPTURE(cycles_session_set_buffer_format, client_id, session_id, format);
+	SESSION_FIND(session_id)
+		ccl::thread_scoped_lock pixels_lock(ccsess->pixels_mutex);
+		if (ccsess->format == format) return;
+		ccsess->set_format(format);
+		CCLOG_DEBUG(client_id, "Session ", session_id, " set buffer format ", (unsigned int)format);
+	SESSION_FIND_END()
+}
+
+unsigned long long cycles_session_get_buffer_generation(unsigned int client_id, unsigned int session_id)
+{
+	SESSION_FIND(session_id)
+		return ccsess->display.latest_generation();
+	SESSION_FIND_END()
+
+	return 0;
+}
+
+void cycles_session_add_pass(unsigned int client_id, unsigned int session_id, unsigned int pass_type)
+{
+	CCCAPTURE(cycles_session_add_pass, client_id, session_id, pass_type);
+	SESSION_FIND(session_id)
+		ccl::PassType type = (ccl::PassType)pass_type;
+		ccl::Scene* sce = session->scene;
+
+		/* combined is always there, in CCSession::pixels. */
+		if (type == ccl::PassType::PASS_COMBINED || ccsess->find_pass(type) != nullptr || sce == nullptr) return;
+
+		unsigned int components{ 0 };
+		{
+			ccl::thread_scoped_lock scene_lock(sce->mutex);
+
+			vector<ccl::Pass> passes = sce->film->passes;
+			ccl::Pass::add(type, passes);
+			sce->film->tag_passes_update(sce, passes);
+			sce->film->tag_update(sce);
+
+			for (ccl::Pass& pass : passes) {
+				if (pass.type == type) components = (unsigned int)pass.components;
+			}
+		}
+
+		if (components == 0) {
+			CCLOG_WARNING(client_id, "Session ", session_id, " can't add unknown pass ", pass_type);
+			return;
+		}
+
+		CCPass* ccpass = new CCPass(type, components);
+		{
+			ccl::thread_scoped_lock pixels_lock(ccsess->pixels_mutex);
+			ccpass->reset(ccsess->width, ccsess->height);
+			ccsess->passes.push_back(ccpass);
+		}
+
+		CCLOG_DEBUG(client_id, "Session ", session_id, " added pass ", pass_type, " with stride ", components);
+	SESSION_FIND_END()
+}
+
+void cycles_session_get_pass_buffer_info(unsigned int client_id, unsigned int session_id, unsigned int pass_type, unsigned int* buffer_size, unsigned int* buffer_stride)
+{
+	*buffer_size = 0;
+	*buffer_stride = 0;
+
+	SESSION_FIND(session_id)
+		if ((ccl::PassType)pass_type == ccl::PassType::PASS_COMBINED) {
+			cycles_session_get_buffer_info(client_id, session_id, buffer_size, buffer_stride);
+			return;
+		}
+		CCPass* pass = ccsess->find_pass((ccl::PassType)pass_type);
+		if (pass) {
+			ccl::thread_scoped_lock pass_lock(pass->pixels_mutex);
+			*buffer_size = pass->buffer_size;
+			*buffer_stride = pass->buffer_stride;
+		}
+	SESSION_FIND_END()
+}
+
+float* cycles_session_get_pass_buffer(unsigned int client_id, unsigned int session_id, unsigned int pass_type)
+{
+	SESSION_FIND(session_id)
+		if ((ccl::PassType)pass_type == ccl::PassType::PASS_COMBINED) {
+			return ccsess->pixels;
+		}
+		CCPass* pass = ccsess->find_pass((ccl::PassType)pass_type);
+		if (pass) return pass->pixels;
+	SESSION_FIND_END()
+
+	return nullptr;
+}
+
+void cycles_session_copy_pass_buffer(unsigned int client_id, unsigned int session_id, unsigned int pass_type, float* pixel_buffer)
+{
+	SESSION_FIND(session_id)
+		if ((ccl::PassType)pass_type == ccl::PassType::PASS_COMBINED) {
+			if (ccsess->format == buffer_format::FLOAT) {
+				cycles_session_copy_buffer(client_id, session_id, pixel_buffer);
+			}
+			else {
+				/* Pass buffers are always float, take them from the working buffer. */
+				ccl::thread_scoped_lock pixels_lock(ccsess->pixels_mutex);
+				memcpy(pixel_buffer, ccsess->pixels, ccsess->buffer_size*sizeof(float));
+			}
+			return;
+		}
+		CCPass* pass = ccsess->find_pass((ccl::PassType)pass_type);
+		if (pass) {
+			ccl::thread_scoped_lock pass_lock(pass->pixels_mutex);
+			memcpy(pixel_buffer, pass->pixels, pass->buffer_size*sizeof(float));
+			CCLOG_TRACE(client_id, "Session ", session_id, " copy pass ", pass_type, " buffer");
+		}
 	SESSION_FIND_END()
 }
 
@@ -507,12 +1055,14 @@ void cycles_session_draw_nogl(unsigned int client_id, unsigned int session_id, i
 		if (isgpu)
 			session->draw(session_buf_params, draw_params);
 		session->display->get_pixels(session->device, ccsess->pixels);
+		ccsess->publish_all();
 	SESSION_FIND_END()
 
 }
 
 void cycles_progress_reset(unsigned int client_id, unsigned int session_id)
 {
+	CCCAPTURE(cycles_progress_reset, client_id, session_id);
 	SESSION_FIND(session_id)
 		session->progress.reset();
 	SESSION_FIND_END()
@@ -543,6 +1093,24 @@ void cycles_tilemanager_get_sample_info(unsigned int client_id, unsigned int ses
 	SESSION_FIND_END()
 }
 
+unsigned int cycles_tilemanager_get_tile_sample_info(unsigned int client_id, unsigned int session_id, cycles_tile_info* tiles, unsigned int max_tiles)
+{
+	SESSION_FIND(session_id)
+		return ccsess->convergence.get_tiles(tiles, max_tiles);
+	SESSION_FIND_END()
+
+	return 0;
+}
+
+void cycles_session_set_adaptive_sampling(unsigned int client_id, unsigned int session_id, float threshold, unsigned int min_samples)
+{
+	CCCAPTURE(cycles_session_set_adaptive_sampling, client_id, session_id, threshold, min_samples);
+	SESSION_FIND(session_id)
+		CCLOG_DEBUG(client_id, "Session ", session_id, " adaptive sampling threshold ", threshold, " min samples ", min_samples);
+		ccsess->convergence.set_params(threshold, (int)min_samples);
+	SESSION_FIND_END()
+}
+
 /* Get cycles render progress. Note that progress will be clamped to 1.0f. */
 void cycles_progress_get_progress(unsigned int client_id, unsigned int session_id, float* progress, double* total_time, double* render_time, double* tile_time)
 {
@@ -568,10 +1136,62 @@ void cycles_progress_get_progress(unsigned int client_id, unsigned int session_i
 	SESSION_FIND_END()
 }
 
+void cycles_session_set_callback_rate(unsigned int client_id, unsigned int session_id, float rate)
+{
+	SESSION_FIND(session_id)
+		ccsess->dispatcher.set_rate(rate);
+		CCLOG_DEBUG(client_id, "Set callback rate for session ", session_id, " to ", rate);
+	SESSION_FIND_END()
+}
+
+void cycles_session_get_stats(unsigned int client_id, unsigned int session_id, cycles_session_stats* stats)
+{
+	*stats = cycles_session_stats{};
+	SESSION_FIND(session_id)
+		ccsess->stats.get(stats);
+
+		int tile;
+		double total_time, render_time, tile_time;
+		session->progress.get_tile(tile, total_time, render_time, tile_time);
+		stats->render_time = render_time;
+		stats->sync_time = render_time > 0.0 ? total_time - render_time : total_time;
+
+		/* Progress counts one sample per tile, scale to pixels. */
+		int num_tiles = session->tile_manager.state.num_tiles;
+		if (num_tiles > 0) {
+			double pixels = (double)session->tile_manager.params.width * session->tile_manager.params.height;
+			stats->pixel_samples = (unsigned long long)((double)session->progress.get_sample() / num_tiles * pixels);
+		}
+		stats->samples_per_second = render_time > 0.0 ? stats->pixel_samples / render_time : 0.0;
+
+		stats->mem_used = session->stats.mem_used;
+		stats->mem_peak = session->stats.mem_peak;
+	SESSION_FIND_END()
+}
+
+unsigned int cycles_session_poll_events(unsigned int client_id, unsigned int session_id, cycles_session_event* events, unsigned int max_events)
+{
+	SESSION_FIND(session_id)
+		return ccsess->events.pop(events, max_events);
+	SESSION_FIND_END()
+
+	return 0;
+}
+
+void cycles_session_get_progress_snapshot(unsigned int client_id, unsigned int session_id, cycles_progress_snapshot* snapshot)
+{
+	*snapshot = cycles_progress_snapshot{};
+	SESSION_FIND(session_id)
+		ccsess->snapshot.read(*snapshot);
+	SESSION_FIND_END()
+}
+
 const char* cycles_progress_get_status(unsigned int client_id, unsigned int session_id)
 {
-	/* static here, since otherwise string goes out of scope on return. */
-	static string status;
+	/* static here, since otherwise string goes out of scope on return.
+	 * Per thread, so concurrent callers don't overwrite each other's result.
+	 */
+	static thread_local string status;
 	status = "";
 	SESSION_FIND(session_id)
 		string substatus{ "" };
@@ -584,8 +1204,10 @@ const char* cycles_progress_get_status(unsigned int client_id, unsigned int sess
 
 const char* cycles_progress_get_substatus(unsigned int client_id, unsigned int session_id)
 {
-	/* static here, since otherwise string goes out of scope on return. */
-	static string substatus;
+	/* static here, since otherwise string goes out of scope on return.
+	 * Per thread, so concurrent callers don't overwrite each other's result.
+	 */
+	static thread_local string substatus;
 	substatus = "";
 	SESSION_FIND(session_id)
 		string status{ "" };
@@ -0,0 +1,196 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+#include <cstring>
+
+#include "internal_types.h"
+
+CCEventQueue::CCEventQueue()
+	: queue{ new Entry[QUEUE_SIZE] }
+{
+	for (size_t i = 0; i < QUEUE_SIZE; i++) {
+		queue[i].seq.store(i, std::memory_order_relaxed);
+	}
+}
+
+CCEventQueue::~CCEventQueue()
+{
+	delete[] queue;
+}
+
+void CCEventQueue::push(const cycles_session_event& event)
+{
+	Entry* entry;
+	size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+	for (;;) {
+		entry = &queue[pos & QUEUE_MASK];
+		size_t seq = entry->seq.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		}
+		else if (diff < 0) {
+			/* Full, nobody is polling. */
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else {
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	entry->event = event;
+	entry->seq.store(pos + 1, std::memory_order_release);
+}
+
+unsigned int CCEventQueue::pop(cycles_session_event* events, unsigned int max_events)
+{
+	ccl::thread_scoped_lock lock(pop_mutex);
+
+	unsigned int count{ 0 };
+	while (count < max_events) {
+		Entry* entry = &queue[dequeue_pos & QUEUE_MASK];
+		size_t seq = entry->seq.load(std::memory_order_acquire);
+		/* Not written yet. */
+		if ((intptr_t)seq - (intptr_t)(dequeue_pos + 1) < 0) break;
+
+		events[count++] = entry->event;
+		entry->seq.store(dequeue_pos + QUEUE_SIZE, std::memory_order_release);
+		dequeue_pos++;
+	}
+
+	return count;
+}
+
+void CCProgressSnapshot::write(const cycles_progress_snapshot& snapshot)
+{
+	ccl::thread_scoped_lock lock(write_mutex);
+
+	unsigned long long generation = data.generation + 1;
+	unsigned int s = seq.load(std::memory_order_relaxed);
+
+	/* Odd while writing. */
+	seq.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	data = snapshot;
+	data.generation = generation;
+	seq.store(s + 2, std::memory_order_release);
+}
+
+void CCProgressSnapshot::read(cycles_progress_snapshot& snapshot) const
+{
+	for (;;) {
+		unsigned int before = seq.load(std::memory_order_acquire);
+		if (before & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		snapshot = data;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seq.load(std::memory_order_relaxed) == before) return;
+	}
+}
+
+static void copy_text(char* dst, size_t size, const string& text)
+{
+	size_t length = std::min(text.size(), size - 1);
+	memcpy(dst, text.c_str(), length);
+	dst[length] = '\0';
+}
+
+void CCSession::push_event(session_event type, int x, int y, int width, int height)
+{
+	int tile;
+	double total_time, render_time, tile_time;
+	session->progress.get_tile(tile, total_time, render_time, tile_time);
+
+	cycles_session_event event;
+	event.type = (unsigned int)type;
+	event.x = x;
+	event.y = y;
+	event.width = width;
+	event.height = height;
+	event.sample = session->tile_manager.state.sample;
+	event.time = total_time;
+
+	events.push(event);
+}
+
+void CCSession::update_progress()
+{
+	cycles_progress_snapshot snap{};
+
+	int tile;
+	session->progress.get_tile(tile, snap.total_time, snap.render_time, snap.tile_time);
+	snap.tiles_done = tile;
+	snap.total_tiles = session->tile_manager.state.num_tiles;
+	snap.sample = session->tile_manager.state.sample;
+	snap.total_samples = session->tile_manager.num_samples;
+
+	/* Same as cycles_progress_get_progress. */
+	int pixel_samples = session->progress.get_sample();
+	if (snap.total_samples > 0 && snap.total_tiles > 0) {
+		snap.progress = std::min(1.0f, (float)pixel_samples / (float)(snap.total_tiles * snap.total_samples));
+	}
+
+	string status, substatus;
+	session->progress.get_status(status, substatus);
+
+	string error = session->device ? session->device->error_message() : "";
+	snap.error = error.empty() ? 0 : 1;
+	snap.cancelled = session->progress.get_cancel() ? 1 : 0;
+	snap.finished = session->tile_manager.done() && !snap.cancelled ? 1 : 0;
+	snap.events_dropped = events.dropped.load(std::memory_order_relaxed);
+
+	copy_text(snap.status, sizeof(snap.status), snap.error ? error : status);
+	copy_text(snap.substatus, sizeof(snap.substatus), substatus);
+
+	snapshot.write(snap);
+
+	if (status != last_status || substatus != last_substatus) {
+		/* Scene device_update and the render report their phases through
+		 * the status, so a trace gets one span per status.
+		 */
+		if (tracer.enabled()) {
+			long long now = tracer.now_us();
+			if (status_trace_start >= 0 && status_trace_start <= now) {
+				tracer.record("status", "phase", status_trace_start, now, last_status + " " + last_substatus);
+			}
+			status_trace_start = now;
+		}
+		else {
+			status_trace_start = -1;
+		}
+		last_status = status;
+		last_substatus = substatus;
+		stats.status_changed(status + " " + substatus, snap.total_time);
+		push_event(session_event::STATUS_CHANGED, 0, 0, 0, 0);
+	}
+	if (snap.sample > last_sample) {
+		last_sample = snap.sample;
+		push_event(session_event::SAMPLE_DONE, 0, 0, 0, 0);
+	}
+	if (snap.finished && !finished_sent) {
+		finished_sent = true;
+		push_event(session_event::FINISHED, 0, 0, 0, 0);
+	}
+	if (snap.error && !error_sent) {
+		error_sent = true;
+		push_event(session_event::DEVICE_ERROR, 0, 0, 0, 0);
+	}
+}
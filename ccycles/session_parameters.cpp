@@ -19,7 +19,7 @@ limitations under the License.
 extern std::vector<ccl::DeviceInfo> devices;
 
 /* Hold all created session parameters. */
-std::vector<ccl::SessionParams> session_params;
+CCHandleTable<CCSessionParams> session_params;
 
 #define SESSION_PARAM_BOOL(session_params_id, varname) \
 	PARAM_BOOL(session_params, session_params_id, varname)
@@ -32,97 +32,125 @@ std::vector<ccl::SessionParams> session_params;
 
 unsigned int cycles_session_params_create(unsigned int client_id, unsigned int device_id)
 {
-	ccl::SessionParams params;
+	CCCAPTURE(cycles_session_params_create, client_id, device_id);
+	CCTRACE_API();
+	CCSessionParams params;
 
 	params.device = devices[device_id];
-	session_params.push_back(params);
-	logger.logit(client_id, "Created session parameters for device ", device_id);
+	unsigned int session_params_id = session_params.insert(params);
+	CCLOG_DEBUG(client_id, "Created session parameters ", session_params_id, " for device ", device_id);
 
-	return (unsigned int)(session_params.size() - 1);
+	return session_params_id;
 }
 
 void cycles_session_params_set_device(unsigned int client_id, unsigned int session_params_id, unsigned int device)
 {
-	if (0 <= session_params_id && session_params_id < session_params.size()) {
-		session_params[session_params_id].device = devices[device];
+	CCCAPTURE(cycles_session_params_set_device, client_id, session_params_id, device);
+	CCTRACE_API();
+	if (CCSessionParams* params = session_params.get(session_params_id)) {
+		params->device = devices[device];
 	}
 }
 
 void cycles_session_params_set_background(unsigned int client_id, unsigned int session_params_id, unsigned int background)
 {
+	CCCAPTURE(cycles_session_params_set_background, client_id, session_params_id, background);
 	SESSION_PARAM_BOOL(session_params_id, background)
 }
 
 void cycles_session_params_set_progressive_refine(unsigned int client_id, unsigned int session_params_id, unsigned int progressive_refine)
 {
+	CCCAPTURE(cycles_session_params_set_progressive_refine, client_id, session_params_id, progressive_refine);
 	SESSION_PARAM_BOOL(session_params_id, progressive_refine)
 }
 void cycles_session_params_set_output_path(unsigned int client_id, unsigned int session_params_id, const char *output_path)
 {
-	if (0 <= session_params_id && session_params_id < session_params.size()) {
-		session_params[session_params_id].output_path = std::string(output_path);
-		logger.logit(client_id, "Set output_path to: ", session_params[session_params_id].output_path);
+	CCCAPTURE(cycles_session_params_set_output_path, client_id, session_params_id, output_path);
+	CCTRACE_API();
+	if (CCSessionParams* params = session_params.get(session_params_id)) {
+		params->output_path = std::string(output_path);
+		CCLOG_TRACE(client_id, "Set output_path to: ", params->output_path);
 	}
 }
 
 void cycles_session_params_set_progressive(unsigned int client_id, unsigned int session_params_id, unsigned int progressive)
 {
+	CCCAPTURE(cycles_session_params_set_progressive, client_id, session_params_id, progressive);
 	SESSION_PARAM_BOOL(session_params_id, progressive)
 }
 
 void cycles_session_params_set_experimental(unsigned int client_id, unsigned int session_params_id, unsigned int experimental)
 {
+	CCCAPTURE(cycles_session_params_set_experimental, client_id, session_params_id, experimental);
 	SESSION_PARAM_BOOL(session_params_id, experimental)
 }
 
 void cycles_session_params_set_samples(unsigned int client_id, unsigned int session_params_id, int samples)
 {
+	CCCAPTURE(cycles_session_params_set_samples, client_id, session_params_id, samples);
 	SESSION_PARAM(session_params_id, samples);
 }
 
 void cycles_session_params_set_tile_size(unsigned int client_id, unsigned int session_params_id, unsigned int x, unsigned int y)
 {
-	if (0 <= session_params_id && session_params_id < session_params.size()) {
-		session_params[session_params_id].tile_size = ccl::make_int2(x, y);
+	CCCAPTURE(cycles_session_params_set_tile_size, client_id, session_params_id, x, y);
+	CCTRACE_API();
+	if (CCSessionParams* params = session_params.get(session_params_id)) {
+		params->tile_size = ccl::make_int2(x, y);
 	}
 }
 
 void cycles_session_params_set_tile_order(unsigned int client_id, unsigned int session_params_id, unsigned int tile_order)
 {
+	CCCAPTURE(cycles_session_params_set_tile_order, client_id, session_params_id, tile_order);
 	SESSION_PARAM_CAST(session_params_id, ccl::TileOrder, tile_order);
 }
 
 void cycles_session_params_set_start_resolution(unsigned int client_id, unsigned int session_params_id, int start_resolution)
 {
+	CCCAPTURE(cycles_session_params_set_start_resolution, client_id, session_params_id, start_resolution);
 	SESSION_PARAM(session_params_id, start_resolution);
 }
 
 void cycles_session_params_set_threads(unsigned int client_id, unsigned int session_params_id, unsigned int threads)
 {
+	CCCAPTURE(cycles_session_params_set_threads, client_id, session_params_id, threads);
 	SESSION_PARAM(session_params_id, threads);
 }
 void cycles_session_params_set_display_buffer_linear(unsigned int client_id, unsigned int session_params_id, unsigned int display_buffer_linear)
 {
+	CCCAPTURE(cycles_session_params_set_display_buffer_linear, client_id, session_params_id, display_buffer_linear);
 	SESSION_PARAM_BOOL(session_params_id, display_buffer_linear)
 }
 void cycles_session_params_set_skip_linear_to_srgb_conversion(unsigned int client_id, unsigned int session_params_id, unsigned int skip_linear_to_srgb_conversion)
 {
+	CCCAPTURE(cycles_session_params_set_skip_linear_to_srgb_conversion, client_id, session_params_id, skip_linear_to_srgb_conversion);
 	SESSION_PARAM_BOOL(session_params_id, skip_linear_to_srgb_conversion)
 }
 void cycles_session_params_set_cancel_timeout(unsigned int client_id, unsigned int session_params_id, double cancel_timeout)
 {
+	CCCAPTURE(cycles_session_params_set_cancel_timeout, client_id, session_params_id, cancel_timeout);
 	SESSION_PARAM(session_params_id, cancel_timeout);
 }
 void cycles_session_params_set_reset_timeout(unsigned int client_id, unsigned int session_params_id, double reset_timeout)
 {
+	CCCAPTURE(cycles_session_params_set_reset_timeout, client_id, session_params_id, reset_timeout);
 	SESSION_PARAM(session_params_id, reset_timeout);
 }
 void cycles_session_params_set_text_timeout(unsigned int client_id, unsigned int session_params_id, double text_timeout)
 {
+	CCCAPTURE(cycles_session_params_set_text_timeout, client_id, session_params_id, text_timeout);
 	SESSION_PARAM(session_params_id, text_timeout);
 }
 
 void cycles_session_params_set_shadingsystem(unsigned int client_id, unsigned int session_params_id, unsigned int shadingsystem)
 {
+	CCCAPTURE(cycles_session_params_set_shadingsystem, client_id, session_params_id, shadingsystem);
 	SESSION_PARAM_CAST(session_params_id, ccl::ShadingSystem, shadingsystem);
+}
+
+void cycles_session_params_set_time_limit(unsigned int client_id, unsigned int session_params_id, double time_limit)
+{
+	CCCAPTURE(cycles_session_params_set_time_limit, client_id, session_params_id, time_limit);
+	SESSION_PARAM(session_params_id, time_limit);
 }
\ No newline at end of file
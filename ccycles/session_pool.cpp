@@ -0,0 +1,177 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+
+#include "internal_types.h"
+
+extern CCHandleTable<CCSessionParams> session_params;
+
+/* Idle ccl::Sessions kept around for reuse, with their device and thread
+ * pool still up. Sessions in the pool have no scene.
+ */
+static std::vector<ccl::Session*> pool;
+static ccl::thread_mutex pool_mutex;
+
+/* Maximum idle sessions per device, 0 keeps destroyed sessions out of the pool. */
+static unsigned int pool_capacity{ 0 };
+
+static cycles_session_pool_stats pool_stats;
+/* Total time spent in ccl::Session construction, and how many. */
+static double startup_seconds{ 0.0 };
+static unsigned int startup_count{ 0 };
+
+static ccl::Session* create_timed(const ccl::SessionParams& params)
+{
+	auto start = std::chrono::steady_clock::now();
+	ccl::Session* session = new ccl::Session(params);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	ccl::thread_scoped_lock lock(pool_mutex);
+	startup_seconds += elapsed.count();
+	startup_count++;
+
+	return session;
+}
+
+ccl::Session* session_pool_acquire(const ccl::SessionParams& params)
+{
+	{
+		ccl::thread_scoped_lock lock(pool_mutex);
+		for (auto it = pool.begin(); it != pool.end(); ++it) {
+			ccl::Session* session = *it;
+			/* Anything that changes how the session was set up rules it out. */
+			if (!session->params.modified(params)) {
+				pool.erase(it);
+				pool_stats.hits++;
+				/* modified() leaves out samples, and set_samples does nothing
+				 * when the value doesn't change, so don't keep the last job's.
+				 */
+				session->params = params;
+				return session;
+			}
+		}
+		pool_stats.misses++;
+	}
+
+	return create_timed(params);
+}
+
+/* Room left for sessions on the device of params, pool_mutex must be held. */
+static unsigned int pool_room(const ccl::SessionParams& params)
+{
+	unsigned int same_device{ 0 };
+	for (ccl::Session* idle : pool) {
+		if (idle->params.device.id == params.device.id) same_device++;
+	}
+	return same_device < pool_capacity ? pool_capacity - same_device : 0;
+}
+
+bool session_pool_has_room(const ccl::SessionParams& params)
+{
+	ccl::thread_scoped_lock lock(pool_mutex);
+	return pool_room(params) > 0;
+}
+
+void session_pool_release(ccl::Session* session)
+{
+	/* The scene goes, its device memory with it. */
+	delete session->scene;
+	session->scene = nullptr;
+
+	session->progress.set_update_callback(nullptr);
+	session->progress.set_cancel_callback(nullptr);
+	session->update_render_tile_cb = nullptr;
+	session->write_render_tile_cb = nullptr;
+	session->display_update_cb = nullptr;
+	session->progress.reset();
+
+	ccl::thread_scoped_lock lock(pool_mutex);
+	pool.push_back(session);
+}
+
+void _cleanup_session_pool()
+{
+	ccl::thread_scoped_lock lock(pool_mutex);
+	for (ccl::Session* session : pool) {
+		delete session;
+	}
+	pool.clear();
+}
+
+void cycles_session_pool_set_capacity(unsigned int client_id, unsigned int capacity)
+{
+	CCCAPTURE(cycles_session_pool_set_capacity, client_id, capacity);
+	CCTRACE_API();
+	ccl::thread_scoped_lock lock(pool_mutex);
+	pool_capacity = capacity;
+	CCLOG_DEBUG(client_id, "Set session pool capacity to ", capacity);
+}
+
+unsigned int cycles_session_pool_prewarm(unsigned int client_id, unsigned int session_params_id, unsigned int count)
+{
+	CCCAPTURE(cycles_session_pool_prewarm, client_id, session_params_id, count);
+	CCTRACE_API();
+	CCSessionParams* sp = session_params.get(session_params_id);
+	if (sp == nullptr) return 0;
+
+	CCSessionParams params = *sp;
+	if (params.time_limit > 0.0) {
+		/* Same as cycles_session_create, or the sessions would never match. */
+		params.progressive_refine = true;
+	}
+
+	{
+		ccl::thread_scoped_lock lock(pool_mutex);
+		count = std::min(count, pool_room(params));
+	}
+
+	unsigned int created{ 0 };
+	for (; created < count; created++) {
+		ccl::Session* session = create_timed(params);
+
+		/* Sessions destroyed meanwhile may have filled the pool. */
+		ccl::thread_scoped_lock lock(pool_mutex);
+		if (pool_room(params) == 0) {
+			lock.unlock();
+			delete session;
+			break;
+		}
+		pool.push_back(session);
+	}
+
+	CCLOG_DEBUG(client_id, "Prewarmed ", created, " sessions with session_params ", session_params_id);
+	return created;
+}
+
+void cycles_session_pool_clear(unsigned int client_id)
+{
+	CCCAPTURE(cycles_session_pool_clear, client_id);
+	CCTRACE_API();
+	_cleanup_session_pool();
+	CCLOG_DEBUG(client_id, "Cleared session pool");
+}
+
+void cycles_session_pool_get_stats(unsigned int client_id, cycles_session_pool_stats* stats)
+{
+	CCTRACE_API();
+	ccl::thread_scoped_lock lock(pool_mutex);
+	*stats = pool_stats;
+	stats->idle = (unsigned int)pool.size();
+	stats->startup_seconds = startup_count > 0 ? startup_seconds / startup_count : 0.0;
+	/* Every hit skipped one average startup. */
+	stats->seconds_saved = stats->startup_seconds * pool_stats.hits;
+}
@@ -0,0 +1,107 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <algorithm>
+#include <cmath>
+
+#include "internal_types.h"
+
+static unsigned long long to_us(double seconds)
+{
+	return (unsigned long long)(seconds * 1e6 + 0.5);
+}
+
+void CCSessionStats::reset()
+{
+	tiles = 0;
+	tile_time_us = 0;
+	tile_time_max_us = 0;
+	for (auto& bucket : histogram) {
+		bucket = 0;
+	}
+	copy_time_us = 0;
+	lock_wait_us = 0;
+
+	{
+		ccl::thread_scoped_lock lock(sync_mutex);
+		current_status.clear();
+		status_start = 0.0;
+		image_time = shader_time = mesh_time = 0.0;
+	}
+
+	generation++;
+}
+
+void CCSessionStats::add_tile_time(double seconds)
+{
+	unsigned long long us = to_us(seconds);
+	tiles++;
+	tile_time_us += us;
+
+	unsigned long long max = tile_time_max_us.load(std::memory_order_relaxed);
+	while (us > max && !tile_time_max_us.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+
+	/* Bucket i holds [2^(i-1), 2^i) milliseconds. */
+	int bucket{ 0 };
+	double ms = seconds * 1000.0;
+	while (bucket < CCYCLES_TILE_HISTOGRAM_SIZE - 1 && ms >= (double)(1u << bucket)) {
+		bucket++;
+	}
+	histogram[bucket]++;
+}
+
+void CCSessionStats::add_copy_time(double seconds, double lock_wait)
+{
+	copy_time_us += to_us(seconds);
+	lock_wait_us += to_us(lock_wait);
+}
+
+void CCSessionStats::status_changed(const string& status, double total_time)
+{
+	ccl::thread_scoped_lock lock(sync_mutex);
+
+	/* Status texts as Scene::device_update sets them. */
+	double elapsed = total_time - status_start;
+	if (current_status.find("Images") != string::npos) {
+		image_time += elapsed;
+	}
+	else if (current_status.find("Shaders") != string::npos) {
+		shader_time += elapsed;
+	}
+	else if (current_status.find("Meshes") != string::npos || current_status.find("BVH") != string::npos) {
+		mesh_time += elapsed;
+	}
+
+	current_status = status;
+	status_start = total_time;
+}
+
+void CCSessionStats::get(cycles_session_stats* stats)
+{
+	stats->tiles = tiles;
+	stats->tile_time_mean = stats->tiles > 0 ? tile_time_us / 1e6 / stats->tiles : 0.0;
+	stats->tile_time_max = tile_time_max_us / 1e6;
+	for (int i = 0; i < CCYCLES_TILE_HISTOGRAM_SIZE; i++) {
+		stats->tile_time_histogram[i] = histogram[i];
+	}
+	stats->copy_time = copy_time_us / 1e6;
+	stats->pixels_lock_wait = lock_wait_us / 1e6;
+
+	ccl::thread_scoped_lock lock(sync_mutex);
+	stats->image_time = image_time;
+	stats->shader_time = shader_time;
+	stats->mesh_time = mesh_time;
+}
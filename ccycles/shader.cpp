@@ -16,11 +16,12 @@ limitations under the License.
 
 #include "internal_types.h"
 
-extern std::vector<CCScene> scenes;
+extern CCHandleTable<CCScene> scenes;
 
-std::vector<CCShader*> shaders;
+CCHandleTable<CCShader*> shaders;
 
-std::vector<CCImage*> images;
+extern CCImage* image_cache_acquire(const string& name, const void* pixels, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels, bool is_float);
+extern void image_cache_release(CCImage* img);
 
 void _init_shaders()
 {
@@ -30,53 +31,54 @@ void _init_shaders()
 	cycles_create_shader(0); // default empty
 }
 
+/* Drop the image references of the texture nodes in sh. Only call once
+ * the graph holding the nodes is gone.
+ */
+static void release_images(CCShader* sh)
+{
+	for (CCImage* img : sh->images) {
+		image_cache_release(img);
+	}
+	sh->images.clear();
+}
+
 void _cleanup_shaders()
 {
-	for (CCShader* sh : shaders) {
+	shaders.for_each([](unsigned int shader_id, CCShader* sh) {
 		// just setting to nullptr, as scene disposal frees this memory.
 		sh->graph = nullptr;
 		sh->shader = nullptr;
 		sh->scene_mapping.clear();
+		release_images(sh);
 		delete sh;
-	}
+	});
 	shaders.clear();
 }
 
-void _cleanup_images()
-{
-	for (CCImage* img : images) {
-		if (img == nullptr) continue;
-
-		delete [] img->builtin_data;
-		img->builtin_data = nullptr;
-
-		delete img;
-	}
-	images.clear();
-}
-
 /* Create a new shader.
  TODO: name for shader
 */
 unsigned int cycles_create_shader(unsigned int client_id)
 {
+	CCCAPTURE(cycles_create_shader, client_id);
+	CCTRACE_API();
 	CCShader* sh = new CCShader();
 	sh->shader->graph = sh->graph;
-	shaders.push_back(sh);
-
-	return (unsigned int)(shaders.size() - 1);
+	return shaders.insert(sh);
 }
 
 /* Add shader to specified scene. */
 unsigned int cycles_scene_add_shader(unsigned int client_id, unsigned int scene_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_scene_add_shader, client_id, scene_id, shader_id);
 	SCENE_FIND(scene_id)
-		CCShader* sh = shaders[shader_id];
-		sce->shaders.push_back(sh->shader);
-		sh->shader->tag_update(sce);
-		unsigned int shid = (unsigned int)(sce->shaders.size() - 1);
-		sh->scene_mapping.insert({ scene_id, shid });
-		return shid;
+		SHADER_FIND(shader_id)
+			sce->shaders.push_back(sh->shader);
+			sh->shader->tag_update(sce);
+			unsigned int shid = (unsigned int)(sce->shaders.size() - 1);
+			sh->scene_mapping.insert({ scene_id, shid });
+			return shid;
+		SHADER_FIND_END()
 	SCENE_FIND_END()
 
 	return (unsigned int)(-1);
@@ -84,53 +86,67 @@ unsigned int cycles_scene_add_shader(unsigned int client_id, unsigned int scene_
 
 void cycles_scene_tag_shader(unsigned int client_id, unsigned int scene_id, unsigned int shader_id)
 {
+	CCCAPTURE(cycles_scene_tag_shader, client_id, scene_id, shader_id);
 	SCENE_FIND(scene_id)
-		CCShader* sh = shaders[shader_id];
-		sh->shader->tag_update(sce);
+		SHADER_FIND(shader_id)
+			sh->shader->tag_update(sce);
+		SHADER_FIND_END()
 	SCENE_FIND_END()
 }
 
 /* Get Cycles shader ID in specific scene. */
 unsigned int cycles_scene_shader_id(unsigned int client_id, unsigned int scene_id, unsigned int shader_id)
 {
-	CCShader* sh = shaders[shader_id];
-	if (sh->scene_mapping.find(scene_id) != sh->scene_mapping.end()) {
-		return sh->scene_mapping[scene_id];
-	}
+	SHADER_FIND(shader_id)
+		if (sh->scene_mapping.find(scene_id) != sh->scene_mapping.end()) {
+			return sh->scene_mapping[scene_id];
+		}
+	SHADER_FIND_END()
 
 	return (unsigned int)(-1);
 }
 
 void cycles_shader_new_graph(unsigned int client_id, unsigned int shader_id)
 {
-		CCShader* sh = shaders[shader_id];
+	CCCAPTURE(cycles_shader_new_graph, client_id, shader_id);
+	SHADER_FIND(shader_id)
 		sh->graph = new ccl::ShaderGraph();
 		sh->shader->set_graph(sh->graph);
+		/* The texture nodes went with the old graph, and with them their
+		 * image slots in Cycles.
+		 */
+		release_images(sh);
+	SHADER_FIND_END()
 }
 
 
 void cycles_shader_set_name(unsigned int client_id, unsigned int shader_id, const char* name)
 {
+	CCCAPTURE(cycles_shader_set_name, client_id, shader_id, name);
 	SHADER_SET(shader_id, string, name, name);
 }
 
 void cycles_shader_set_use_mis(unsigned int client_id, unsigned int shader_id, unsigned int use_mis)
 {
+	CCCAPTURE(cycles_shader_set_use_mis, client_id, shader_id, use_mis);
 	SHADER_SET(shader_id, bool, use_mis, use_mis == 1)
 }
 
 void cycles_shader_set_use_transparent_shadow(unsigned int client_id, unsigned int shader_id, unsigned int use_transparent_shadow)
 {
+	CCCAPTURE(cycles_shader_set_use_transparent_shadow, client_id, shader_id, use_transparent_shadow);
 	SHADER_SET(shader_id, bool, use_transparent_shadow, use_transparent_shadow == 1)
 }
 
 void cycles_shader_set_heterogeneous_volume(unsigned int client_id, unsigned int shader_id, unsigned int heterogeneous_volume)
 {
+	CCCAPTURE(cycles_shader_set_heterogeneous_volume, client_id, shader_id, heterogeneous_volume);
 	SHADER_SET(shader_id, bool, heterogeneous_volume, heterogeneous_volume == 1)
 }
 
 unsigned int cycles_add_shader_node(unsigned int client_id, unsigned int shader_id, shadernode_type shn_type)
 {
+	CCCAPTURE(cycles_add_shader_node, client_id, shader_id, shn_type);
 	ccl::ShaderNode* node = nullptr;
 	switch (shn_type) {
 		case shadernode_type::BACKGROUND:
@@ -314,12 +330,14 @@ unsigned int cycles_add_shader_node(unsigned int client_id, unsigned int shader_
 	}
 
 	if (node) {
-		shaders[shader_id]->graph->add(node);
-		return (unsigned int)(node->id);
-	}
-	else {
-		return (unsigned int)-1;
+		SHADER_FIND(shader_id)
+			sh->graph->add(node);
+			return (unsigned int)(node->id);
+		SHADER_FIND_END()
+		delete node;
 	}
+
+	return (unsigned int)-1;
 }
 
 enum class attr_type {
@@ -349,21 +367,21 @@ void shadernode_set_attribute(unsigned int client_id, unsigned int shader_id, un
 					switch (v.type) {
 					case attr_type::INT:
 						inp->value.x = (float)v.i;
-						logger.logit(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.i);
+						CCLOG_TRACE(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.i);
 						break;
 					case attr_type::FLOAT:
 						inp->value.x = v.f;
-						logger.logit(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.f);
+						CCLOG_TRACE(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.f);
 						break;
 					case attr_type::FLOAT4:
 						inp->value.x = v.f4.x;
 						inp->value.y = v.f4.y;
 						inp->value.z = v.f4.z;
-						logger.logit(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.f4.x, ",", v.f4.y, ",", v.f4.z);
+						CCLOG_TRACE(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.f4.x, ",", v.f4.y, ",", v.f4.z);
 						break;
 					case attr_type::CHARP:
 						inp->value_string = string(v.cp);
-						logger.logit(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.cp);
+						CCLOG_TRACE(client_id, "shader_id: ", shader_id, " -> shnode_id: ", shnode_id, " |> setting attribute: ", attribute_name, " to: ", v.cp);
 						break;
 					}
 					return;
@@ -379,7 +397,7 @@ void _set_enum_val(unsigned int client_id, OpenImageIO::v1_3::ustring* str, ccl:
 		*str = val;
 	}
 	else {
-		logger.logit(client_id, "Unknown value ", val);
+		CCLOG_WARNING(client_id, "Unknown value ", val);
 	}
 }
 
@@ -406,6 +424,7 @@ void _set_texture_mapping_transformation(ccl::TextureMapping& mapping, int trans
 
 void cycles_shadernode_texmapping_set_transformation(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, int transform_type, float x, float y, float z)
 {
+	CCCAPTURE(cycles_shadernode_texmapping_set_transformation, client_id, shader_id, shnode_id, shn_type, transform_type, x, y, z);
 	SHADERNODE_FIND(shader_id, shnode_id)
 		string tp{ "UNKNOWN" };
 		switch (transform_type) {
@@ -419,7 +438,7 @@ void cycles_shadernode_texmapping_set_transformation(unsigned int client_id, uns
 				tp = "SCALE";
 				break;
 		}
-		logger.logit(client_id, "Setting texture map transformation (", tp, ") to ", x, ",", y, ",", z, " for shadernode type ", shn_type);
+		CCLOG_TRACE(client_id, "Setting texture map transformation (", tp, ") to ", x, ",", y, ",", z, " for shadernode type ", shn_type);
 			switch (shn_type) {
 				case shadernode_type::MAPPING:
 					ccl::MappingNode* node = dynamic_cast<ccl::MappingNode*>(*psh);
@@ -431,8 +450,9 @@ void cycles_shadernode_texmapping_set_transformation(unsigned int client_id, uns
 
 void cycles_shadernode_texmapping_set_mapping(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, ccl::TextureMapping::Mapping x, ccl::TextureMapping::Mapping y, ccl::TextureMapping::Mapping z)
 {
+	CCCAPTURE(cycles_shadernode_texmapping_set_mapping, client_id, shader_id, shnode_id, shn_type, x, y, z);
 	SHADERNODE_FIND(shader_id, shnode_id)
-		logger.logit(client_id, "Setting texture map mapping to ", x, ",", y, ",", z, " for shadernode type ", shn_type);
+		CCLOG_TRACE(client_id, "Setting texture map mapping to ", x, ",", y, ",", z, " for shadernode type ", shn_type);
 			switch (shn_type) {
 				case shadernode_type::MAPPING:
 					ccl::MappingNode* node = dynamic_cast<ccl::MappingNode*>(*psh);
@@ -446,8 +466,9 @@ void cycles_shadernode_texmapping_set_mapping(unsigned int client_id, unsigned i
 
 void cycles_shadernode_texmapping_set_projection(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, ccl::TextureMapping::Projection tm_projection)
 {
+	CCCAPTURE(cycles_shadernode_texmapping_set_projection, client_id, shader_id, shnode_id, shn_type, tm_projection);
 	SHADERNODE_FIND(shader_id, shnode_id)
-		logger.logit(client_id, "Setting texture map projection type to ", tm_projection, " for shadernode type ", shn_type);
+		CCLOG_TRACE(client_id, "Setting texture map projection type to ", tm_projection, " for shadernode type ", shn_type);
 			switch (shn_type) {
 				case shadernode_type::MAPPING:
 					ccl::MappingNode* node = dynamic_cast<ccl::MappingNode*>(*psh);
@@ -459,8 +480,9 @@ void cycles_shadernode_texmapping_set_projection(unsigned int client_id, unsigne
 
 void cycles_shadernode_texmapping_set_type(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, ccl::TextureMapping::Type tm_type)
 {
+	CCCAPTURE(cycles_shadernode_texmapping_set_type, client_id, shader_id, shnode_id, shn_type, tm_type);
 	SHADERNODE_FIND(shader_id, shnode_id)
-		logger.logit(client_id, "Setting texture map type to ", tm_type, " for shadernode type ", shn_type);
+		CCLOG_TRACE(client_id, "Setting texture map type to ", tm_type, " for shadernode type ", shn_type);
 			switch (shn_type) {
 				case shadernode_type::MAPPING:
 					ccl::MappingNode* node = dynamic_cast<ccl::MappingNode*>(*psh);
@@ -474,6 +496,7 @@ void cycles_shadernode_texmapping_set_type(unsigned int client_id, unsigned int
  */
 void cycles_shadernode_set_enum(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* enum_name, const char* value)
 {
+	CCCAPTURE(cycles_shadernode_set_enum, client_id, shader_id, shnode_id, shn_type, enum_name, value);
 	auto val = OpenImageIO::v1_3::ustring(value);
 	auto ename = string{enum_name};
 
@@ -578,51 +601,18 @@ void cycles_shadernode_set_enum(unsigned int client_id, unsigned int shader_id,
 	SHADERNODE_FIND_END()
 }
 
-CCImage* find_existing_ccimage(string imgname, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels, bool is_float)
-{
-	CCImage* existing_image = nullptr;
-	for (CCImage* im : images) {
-		if (im->filename == imgname
-			&& im->width == (int)width
-			&& im->height== (int)height
-			&& im->depth == (int)depth
-			&& im->channels == (int)channels
-			&& im->is_float == is_float
-			) {
-			existing_image = im;
-			break;
-		}
-	}
-	return existing_image;
-}
-
-template <class T>
-CCImage* get_ccimage(string imgname, T* img, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels, bool is_float)
+/* Keep the reference the caller acquired for img until the graph of sh
+ * goes. An image the node had before may still be in a Cycles image slot,
+ * so it stays too.
+ */
+static void keep_node_image(CCShader* sh, CCImage* img)
 {
-	CCImage* existing_image = find_existing_ccimage(imgname, width, height, depth, channels, is_float);
-	CCImage* nimg = existing_image ? existing_image : new CCImage();
-	if (!existing_image) {
-		T* imgdata = new T[width*height*channels*depth];
-		memcpy(imgdata, img, sizeof(T)*width*height*channels*depth);
-		nimg->builtin_data = imgdata;
-		nimg->filename = imgname;
-		nimg->width = (int)width;
-		nimg->height = (int)height;
-		nimg->depth = (int)depth;
-		nimg->channels = (int)channels;
-		nimg->is_float = is_float;
-		images.push_back(nimg);
-	}
-	else {
-		memcpy(existing_image->builtin_data, img, sizeof(T)*width*height*channels*depth);
-	}
-
-
-	return nimg;
+	sh->images.push_back(img);
 }
 
 void cycles_shadernode_set_member_float_img(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, const char* img_name, float* img, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels)
 {
+	CCCAPTURE(cycles_shadernode_set_member_float_img, client_id, shader_id, shnode_id, shn_type, member_name, img_name, capture_array(img, (size_t)width * height * depth * channels), width, height, depth, channels);
 	auto mname = string{ member_name };
 	auto imname = string{ img_name };
 
@@ -630,7 +620,8 @@ void cycles_shadernode_set_member_float_img(unsigned int client_id, unsigned int
 			switch (shn_type) {
 				case shadernode_type::IMAGE_TEXTURE:
 					{
-						CCImage* nimg = get_ccimage<float>(imname, img, width, height, depth, channels, true);
+						CCImage* nimg = image_cache_acquire(imname, img, width, height, depth, channels, true);
+						keep_node_image(sh, nimg);
 						ccl::ImageTextureNode* imtex = dynamic_cast<ccl::ImageTextureNode*>(*psh);
 						imtex->builtin_data = nimg;
 						imtex->interpolation = ccl::InterpolationType::INTERPOLATION_LINEAR;
@@ -639,7 +630,8 @@ void cycles_shadernode_set_member_float_img(unsigned int client_id, unsigned int
 					break;
 				case shadernode_type::ENVIRONMENT_TEXTURE:
 					{
-						CCImage* nimg = get_ccimage<float>(imname, img, width, height, depth, channels, true);
+						CCImage* nimg = image_cache_acquire(imname, img, width, height, depth, channels, true);
+						keep_node_image(sh, nimg);
 						ccl::EnvironmentTextureNode* envtex = dynamic_cast<ccl::EnvironmentTextureNode*>(*psh);
 						envtex->builtin_data = nimg;
 						envtex->filename = nimg->filename;
@@ -651,13 +643,15 @@ void cycles_shadernode_set_member_float_img(unsigned int client_id, unsigned int
 
 void cycles_shadernode_set_member_byte_img(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, const char* img_name, unsigned char* img, unsigned int width, unsigned int height, unsigned int depth, unsigned int channels)
 {
+	CCCAPTURE(cycles_shadernode_set_member_byte_img, client_id, shader_id, shnode_id, shn_type, member_name, img_name, capture_array(img, (size_t)width * height * depth * channels), width, height, depth, channels);
 	auto mname = string{ member_name };
 	auto imname = string{ img_name };
 	SHADERNODE_FIND(shader_id, shnode_id)
 			switch (shn_type) {
 				case shadernode_type::IMAGE_TEXTURE:
 					{
-						CCImage* nimg = get_ccimage<unsigned char>(imname, img, width, height, depth, channels, false);
+						CCImage* nimg = image_cache_acquire(imname, img, width, height, depth, channels, false);
+						keep_node_image(sh, nimg);
 						ccl::ImageTextureNode* imtex = dynamic_cast<ccl::ImageTextureNode*>(*psh);
 						imtex->builtin_data = nimg;
 						imtex->filename = nimg->filename;
@@ -665,7 +659,8 @@ void cycles_shadernode_set_member_byte_img(unsigned int client_id, unsigned int
 					break;
 				case shadernode_type::ENVIRONMENT_TEXTURE:
 					{
-						CCImage* nimg = get_ccimage<unsigned char>(imname, img, width, height, depth, channels, false);
+						CCImage* nimg = image_cache_acquire(imname, img, width, height, depth, channels, false);
+						keep_node_image(sh, nimg);
 						ccl::EnvironmentTextureNode* envtex = dynamic_cast<ccl::EnvironmentTextureNode*>(*psh);
 						envtex->builtin_data = nimg;
 						envtex->filename = nimg->filename;
@@ -677,6 +672,7 @@ void cycles_shadernode_set_member_byte_img(unsigned int client_id, unsigned int
 
 void cycles_shadernode_set_member_bool(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, bool value)
 {
+	CCCAPTURE(cycles_shadernode_set_member_bool, client_id, shader_id, shnode_id, shn_type, member_name, value);
 	auto mname = string{ member_name };
 
 	SHADERNODE_FIND(shader_id, shnode_id)
@@ -751,8 +747,12 @@ void cycles_shadernode_set_member_bool(unsigned int client_id, unsigned int shad
 	SHADERNODE_FIND_END()
 }
 
+/* The scene XML reader picks this over the float setter by is_int_member,
+ * keep the names there in step with these.
+ */
 void cycles_shadernode_set_member_int(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, int value)
 {
+	CCCAPTURE(cycles_shadernode_set_member_int, client_id, shader_id, shnode_id, shn_type, member_name, value);
 	auto mname = string{ member_name };
 	SHADERNODE_FIND(shader_id, shnode_id)
 			switch (shn_type) {
@@ -796,6 +796,7 @@ void cycles_shadernode_set_member_int(unsigned int client_id, unsigned int shade
 
 void cycles_shadernode_set_member_float(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, float value)
 {
+	CCCAPTURE(cycles_shadernode_set_member_float, client_id, shader_id, shnode_id, shn_type, member_name, value);
 	auto mname = string{ member_name };
 
 	SHADERNODE_FIND(shader_id, shnode_id)
@@ -838,6 +839,7 @@ void cycles_shadernode_set_member_float(unsigned int client_id, unsigned int sha
 
 void cycles_shadernode_set_member_vec4_at_index(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, float x, float y, float z, float w, int index)
 {
+	CCCAPTURE(cycles_shadernode_set_member_vec4_at_index, client_id, shader_id, shnode_id, shn_type, member_name, x, y, z, w, index);
 	auto mname = string{ member_name };
 
 	SHADERNODE_FIND(shader_id, shnode_id)
@@ -915,6 +917,7 @@ void cycles_shadernode_set_member_vec4_at_index(unsigned int client_id, unsigned
 
 void cycles_shadernode_set_member_vec(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, shadernode_type shn_type, const char* member_name, float x, float y, float z)
 {
+	CCCAPTURE(cycles_shadernode_set_member_vec, client_id, shader_id, shnode_id, shn_type, member_name, x, y, z);
 	auto mname = string{ member_name };
 
 	SHADERNODE_FIND(shader_id, shnode_id)
@@ -959,6 +962,8 @@ Set an integer attribute with given name to value. shader_id is the global shade
 */
 void cycles_shadernode_set_attribute_int(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, const char* attribute_name, int value)
 {
+	CCCAPTURE(cycles_shadernode_set_attribute_int, client_id, shader_id, shnode_id, attribute_name, value);
+	CCTRACE_API();
 	attrunion v{ attr_type::INT };
 	v.i = value;
 	shadernode_set_attribute(client_id, shader_id, shnode_id, attribute_name, v);
@@ -969,6 +974,8 @@ Set a float attribute with given name to value. shader_id is the global shader I
 */
 void cycles_shadernode_set_attribute_float(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, const char* attribute_name, float value)
 {
+	CCCAPTURE(cycles_shadernode_set_attribute_float, client_id, shader_id, shnode_id, attribute_name, value);
+	CCTRACE_API();
 	attrunion v{ attr_type::FLOAT };
 	v.f = value;
 	shadernode_set_attribute(client_id, shader_id, shnode_id, attribute_name, v);
@@ -979,6 +986,8 @@ Set a vector of floats attribute with given name to x, y and z. shader_id is the
 */
 void cycles_shadernode_set_attribute_vec(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, const char* attribute_name, float x, float y, float z)
 {
+	CCCAPTURE(cycles_shadernode_set_attribute_vec, client_id, shader_id, shnode_id, attribute_name, x, y, z);
+	CCTRACE_API();
 	attrunion v{ attr_type::FLOAT4 };
 	v.f4.x = x;
 	v.f4.y = y;
@@ -991,6 +1000,8 @@ Set a string attribute with given name to value. shader_id is the global shader
 */
 void cycles_shadernode_set_attribute_string(unsigned int client_id, unsigned int shader_id, unsigned int shnode_id, const char* attribute_name, const char* value)
 {
+	CCCAPTURE(cycles_shadernode_set_attribute_string, client_id, shader_id, shnode_id, attribute_name, value);
+	CCTRACE_API();
 	attrunion v;
 	v.type = attr_type::CHARP;
 	v.cp = value;
@@ -999,31 +1010,33 @@ void cycles_shadernode_set_attribute_string(unsigned int client_id, unsigned int
 
 void cycles_shader_connect_nodes(unsigned int client_id, unsigned int shader_id, unsigned int from_id, const char* from, unsigned int to_id, const char* to)
 {
-	CCShader* sh = shaders[shader_id];
-	auto shfrom = sh->graph->nodes.begin();
-	auto shfrom_end = sh->graph->nodes.end();
-	auto shto = sh->graph->nodes.begin();
-	auto shto_end = sh->graph->nodes.end();
-
-	while (shfrom != shfrom_end) {
-		if ((*shfrom)->id == from_id) {
-			break;
+	CCCAPTURE(cycles_shader_connect_nodes, client_id, shader_id, from_id, from, to_id, to);
+	SHADER_FIND(shader_id)
+		auto shfrom = sh->graph->nodes.begin();
+		auto shfrom_end = sh->graph->nodes.end();
+		auto shto = sh->graph->nodes.begin();
+		auto shto_end = sh->graph->nodes.end();
+
+		while (shfrom != shfrom_end) {
+			if ((*shfrom)->id == from_id) {
+				break;
+			}
+			++shfrom;
 		}
-		++shfrom;
-	}
 
-	while (shto != shto_end) {
-		if ((*shto)->id == to_id) {
-			break;
+		while (shto != shto_end) {
+			if ((*shto)->id == to_id) {
+				break;
+			}
+			++shto;
 		}
-		++shto;
-	}
 
-	if (shfrom == shfrom_end || shto == shto_end) {
-		return; // TODO: figure out what to do on errors like this
-	}
-	logger.logit(client_id, "Shader ", shader_id, " :: ", from_id, ":", from, " -> ", to_id, ":", to);
+		if (shfrom == shfrom_end || shto == shto_end) {
+			return; // TODO: figure out what to do on errors like this
+		}
+		CCLOG_TRACE(client_id, "Shader ", shader_id, " :: ", from_id, ":", from, " -> ", to_id, ":", to);
 
-	sh->graph->connect((*shfrom)->output(from), (*shto)->input(to));
+		sh->graph->connect((*shfrom)->output(from), (*shto)->input(to));
+	SHADER_FIND_END()
 }
 
@@ -0,0 +1,134 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+#include <fstream>
+
+#include "internal_types.h"
+
+CCTracer tracer;
+
+long long CCTracer::now_us() const
+{
+	return to_us(std::chrono::steady_clock::now());
+}
+
+long long CCTracer::to_us(std::chrono::steady_clock::time_point t) const
+{
+	std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::duration(epoch.load(std::memory_order_relaxed)) };
+	return std::chrono::duration_cast<std::chrono::microseconds>(t - start).count();
+}
+
+CCTracer::ThreadBuffer& CCTracer::local_buffer()
+{
+	/* Shared with buffers, so spans survive the thread. */
+	static thread_local std::shared_ptr<ThreadBuffer> local;
+	if (!local) {
+		local = std::make_shared<ThreadBuffer>();
+
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+		local->tid = (unsigned int)buffers.size() + 1;
+		buffers.push_back(local);
+	}
+	return *local;
+}
+
+void CCTracer::record(const char* name, const char* category, long long start_us, long long end_us, const string& detail)
+{
+	ThreadBuffer& buffer = local_buffer();
+
+	/* Only contended while stop collects the spans. */
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.spans.push_back(Span{ name, category, start_us, end_us - start_us, detail });
+}
+
+void CCTracer::start()
+{
+	{
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+		for (auto& buffer : buffers) {
+			std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+			buffer->spans.clear();
+		}
+	}
+
+	epoch.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+	on.store(true, std::memory_order_release);
+}
+
+static void write_json_string(std::ostream& out, const char* text)
+{
+	out << '"';
+	for (const char* c = text; *c; c++) {
+		switch (*c) {
+			case '"': out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if ((unsigned char)*c >= 0x20) out << *c;
+				break;
+		}
+	}
+	out << '"';
+}
+
+bool CCTracer::stop(const char* path)
+{
+	on.store(false, std::memory_order_release);
+
+	std::ofstream out(path, std::ios::out | std::ios::trunc);
+	if (!out) return false;
+
+	out << "{\"traceEvents\":[\n";
+	bool first{ true };
+
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	for (auto& buffer : buffers) {
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		for (const Span& span : buffer->spans) {
+			if (!first) out << ",\n";
+			first = false;
+
+			out << "{\"name\":";
+			write_json_string(out, span.name);
+			out << ",\"cat\":";
+			write_json_string(out, span.category);
+			out << ",\"ph\":\"X\",\"ts\":" << span.start_us << ",\"dur\":" << span.duration_us;
+			out << ",\"pid\":1,\"tid\":" << buffer->tid;
+			if (!span.detail.empty()) {
+				out << ",\"args\":{\"detail\":";
+				write_json_string(out, span.detail.c_str());
+				out << "}";
+			}
+			out << "}";
+		}
+		buffer->spans.clear();
+	}
+
+	out << "\n]}\n";
+	return out.good();
+}
+
+void cycles_trace_start()
+{
+	tracer.start();
+}
+
+unsigned int cycles_trace_stop(const char* path)
+{
+	if (path == nullptr) return 0;
+	return tracer.stop(path) ? 1 : 0;
+}
@@ -0,0 +1,496 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+
+/* Renders tests/scene_cube.xml, the meshes in tests/objects and synthetic
+ * scenes of growing size headless, and writes one JSON object per scene to
+ * stdout for regression tracking. Progress goes to stderr. XML files are
+ * read with cycles_scene_load_xml, so their build time includes parsing.
+ *
+ *   ccycles_bench [options]
+ *
+ *   --tests <dir>        tests directory, default tests
+ *   --kernels <path>     kernel path for cycles_path_init
+ *   --device <n>         device index, default 0
+ *   --size <n>           image width and height, default 256
+ *   --samples <n>        samples per pixel, default 16
+ *   --max-tris <n>       largest triangle count, default 10000000
+ *   --max-objects <n>    largest object count, default 10000
+ *   --max-lights <n>     largest light count, default 1000
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma warning ( push )
+#pragma warning ( disable : 4244 )
+
+#include "nodes.h"
+#include "util_transform.h"
+#include "util_types.h"
+
+#pragma warning ( pop )
+
+#include "ccycles.h"
+
+using std::string;
+using std::vector;
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double seconds_since(bench_clock::time_point start)
+{
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+struct Options {
+	string tests{ "tests" };
+	const char* kernels{ nullptr };
+	unsigned int device{ 0 };
+	unsigned int size{ 256 };
+	int samples{ 16 };
+	unsigned int max_tris{ 10000000 };
+	unsigned int max_objects{ 10000 };
+	unsigned int max_lights{ 1000 };
+};
+
+struct MeshData {
+	vector<float> verts;
+	vector<int> faces;
+};
+
+/* Scene ids for one benchmark run. */
+struct BenchScene {
+	unsigned int client_id;
+	unsigned int scene_id;
+	unsigned int surface;
+	unsigned int emission;
+	unsigned int triangles;
+	unsigned int lights;
+};
+
+/* Frees the scene of bs when a benchmark returns before rendering it. Once
+ * a session took the scene, destroying the session already freed it and
+ * cycles_scene_destroy finds nothing left to do.
+ */
+struct BenchSceneGuard {
+	const BenchScene& bs;
+	~BenchSceneGuard()
+	{
+		if (bs.scene_id != UINT_MAX) cycles_scene_destroy(bs.client_id, bs.scene_id);
+	}
+};
+
+/* Result of one benchmark run, all times in seconds. */
+struct BenchResult {
+	double build;
+	double sync;
+	double first_pixel;
+	double render;
+	double samples_per_second;
+	double tile_copy;
+	double copy_mb_per_second;
+	unsigned int objects;
+	unsigned long long geometry_bytes;
+	unsigned long long mem_peak;
+	bool ok;
+};
+
+/* Square grid in the XY plane of at least tris triangles, two per cell,
+ * spanning -extent..extent.
+ */
+static void make_grid(unsigned int tris, float extent, MeshData& mesh)
+{
+	unsigned int cells = std::max(1u, (unsigned int)ceil(sqrt(tris / 2.0)));
+	unsigned int row = cells + 1;
+
+	mesh.verts.resize((size_t)row * row * 3);
+	mesh.faces.resize((size_t)cells * cells * 6);
+
+	float step = 2.0f * extent / cells;
+	for (unsigned int y = 0; y < row; y++) {
+		for (unsigned int x = 0; x < row; x++) {
+			float* v = &mesh.verts[((size_t)y * row + x) * 3];
+			v[0] = -extent + x * step;
+			v[1] = -extent + y * step;
+			/* A little relief so the BVH isn't flat. */
+			v[2] = 0.05f * sinf(x * 0.7f) * cosf(y * 0.7f);
+		}
+	}
+
+	int* f = &mesh.faces[0];
+	for (unsigned int y = 0; y < cells; y++) {
+		for (unsigned int x = 0; x < cells; x++) {
+			int v0 = (int)(y * row + x);
+			int v1 = v0 + 1;
+			int v2 = v0 + (int)row;
+			int v3 = v2 + 1;
+			*f++ = v0; *f++ = v1; *f++ = v3;
+			*f++ = v0; *f++ = v3; *f++ = v2;
+		}
+	}
+}
+
+static unsigned int add_mesh(const BenchScene& bs, const MeshData& mesh)
+{
+	unsigned int mesh_id = cycles_scene_add_mesh(bs.client_id, bs.scene_id, bs.surface);
+	cycles_mesh_set_verts(bs.client_id, bs.scene_id, mesh_id, const_cast<float*>(&mesh.verts[0]), (unsigned int)(mesh.verts.size() / 3));
+	cycles_mesh_set_tris(bs.client_id, bs.scene_id, mesh_id, const_cast<int*>(&mesh.faces[0]), (unsigned int)(mesh.faces.size() / 3), bs.surface, 0);
+	return mesh_id;
+}
+
+static void add_instance(BenchScene& bs, unsigned int mesh_id, unsigned int tris, float scale, float x, float y, float z)
+{
+	cycles_scene_add_mesh_instance(bs.client_id, bs.scene_id, mesh_id,
+		scale, 0.0f, 0.0f, x,
+		0.0f, scale, 0.0f, y,
+		0.0f, 0.0f, scale, z,
+		0.0f, 0.0f, 0.0f, 1.0f);
+	bs.triangles += tris;
+}
+
+static void add_point_light(BenchScene& bs, float x, float y, float z)
+{
+	unsigned int light_id = cycles_create_light(bs.client_id, bs.scene_id, bs.emission);
+	cycles_light_set_type(bs.client_id, bs.scene_id, light_id, light_type::Point);
+	cycles_light_set_size(bs.client_id, bs.scene_id, light_id, 0.05f);
+	cycles_light_set_co(bs.client_id, bs.scene_id, light_id, x, y, z);
+	cycles_light_set_cast_shadow(bs.client_id, bs.scene_id, light_id, 1);
+	cycles_light_set_use_mis(bs.client_id, bs.scene_id, light_id, 1);
+	bs.lights++;
+}
+
+/* Shader with a single closure node connected to the output node. */
+static unsigned int add_shader(const BenchScene& bs, shadernode_type type, const char* output, float strength)
+{
+	unsigned int shader_id = cycles_create_shader(bs.client_id);
+	unsigned int node_id = cycles_add_shader_node(bs.client_id, shader_id, type);
+	cycles_shadernode_set_attribute_vec(bs.client_id, shader_id, node_id, "Color", 0.8f, 0.8f, 0.8f);
+	if (strength > 0.0f) {
+		cycles_shadernode_set_attribute_float(bs.client_id, shader_id, node_id, "Strength", strength);
+	}
+	/* The output node is always the first node of a graph. */
+	cycles_shader_connect_nodes(bs.client_id, shader_id, node_id, output, 0, "Surface");
+	return cycles_scene_add_shader(bs.client_id, bs.scene_id, shader_id);
+}
+
+static BenchScene create_scene(unsigned int client_id, const Options& opt)
+{
+	BenchScene bs{ client_id, UINT_MAX, 0, 0, 0, 0 };
+
+	unsigned int scene_params_id = cycles_scene_params_create(client_id, 1, 1, 0, 0, 0); /* SVM, static BVH */
+	bs.scene_id = cycles_scene_create(client_id, scene_params_id, opt.device);
+	if (bs.scene_id == UINT_MAX) return bs;
+
+	bs.surface = add_shader(bs, shadernode_type::DIFFUSE, "BSDF", 0.0f);
+	bs.emission = add_shader(bs, shadernode_type::EMISSION, "Emission", 100.0f);
+	cycles_scene_set_default_surface_shader(client_id, bs.scene_id, bs.surface);
+
+	/* Same camera as tests/scene_cube.xml. */
+	cycles_camera_set_size(client_id, bs.scene_id, opt.size, opt.size);
+	cycles_camera_set_type(client_id, bs.scene_id, camera_type::PERSPECTIVE);
+	cycles_camera_set_matrix(client_id, bs.scene_id,
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, -5.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+	cycles_camera_compute_auto_viewplane(client_id, bs.scene_id);
+	cycles_camera_update(client_id, bs.scene_id);
+
+	return bs;
+}
+
+/* Render bs to completion, scene_start is when building it began. */
+static BenchResult render_scene(const BenchScene& bs, const Options& opt, bench_clock::time_point scene_start)
+{
+	BenchResult r{};
+
+	unsigned int session_params_id = cycles_session_params_create(bs.client_id, opt.device);
+	cycles_session_params_set_background(bs.client_id, session_params_id, 1);
+	cycles_session_params_set_progressive(bs.client_id, session_params_id, 0);
+	cycles_session_params_set_samples(bs.client_id, session_params_id, opt.samples);
+	cycles_session_params_set_tile_size(bs.client_id, session_params_id, 64, 64);
+	cycles_session_params_set_threads(bs.client_id, session_params_id, 0);
+
+	unsigned int session_id = cycles_session_create(bs.client_id, session_params_id, bs.scene_id);
+	if (session_id == UINT_MAX) return r;
+
+	cycles_session_reset(bs.client_id, session_id, opt.size, opt.size, (unsigned int)opt.samples);
+	r.build = seconds_since(scene_start);
+
+	cycles_instance_stats instance_stats{};
+	cycles_scene_get_instance_stats(bs.client_id, bs.scene_id, &instance_stats);
+	r.objects = instance_stats.objects;
+	r.geometry_bytes = instance_stats.bytes_stored;
+
+	/* First pixel is the first tile to reach the session buffer, events carry
+	 * the time since the render started.
+	 */
+	r.first_pixel = -1.0;
+	cycles_session_start(bs.client_id, session_id);
+
+	cycles_session_event events[64];
+	cycles_progress_snapshot snapshot{};
+	do {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		cycles_session_get_progress_snapshot(bs.client_id, session_id, &snapshot);
+		unsigned int count = cycles_session_poll_events(bs.client_id, session_id, events, 64);
+		for (unsigned int i = 0; i < count && r.first_pixel < 0.0; i++) {
+			if (events[i].type == (unsigned int)session_event::TILE_DONE || events[i].type == (unsigned int)session_event::TILE_UPDATE) {
+				r.first_pixel = events[i].time;
+			}
+		}
+	} while (snapshot.finished == 0 && snapshot.cancelled == 0 && snapshot.error == 0);
+	cycles_session_wait(bs.client_id, session_id);
+	if (snapshot.cancelled != 0 || snapshot.error != 0) {
+		cycles_session_destroy(bs.client_id, session_id);
+		return r;
+	}
+
+	cycles_session_stats stats;
+	cycles_session_get_stats(bs.client_id, session_id, &stats);
+	r.sync = stats.sync_time;
+	r.render = stats.render_time;
+	r.samples_per_second = stats.samples_per_second;
+	r.tile_copy = stats.copy_time;
+	r.mem_peak = stats.mem_peak;
+
+	/* Copy the finished frame until enough time has passed to be measurable. */
+	unsigned int buffer_size{ 0 };
+	unsigned int buffer_stride{ 0 };
+	cycles_session_get_buffer_info(bs.client_id, session_id, &buffer_size, &buffer_stride);
+	if (buffer_size > 0) {
+		vector<float> pixels(buffer_size);
+		unsigned int copies{ 0 };
+		auto copy_start = bench_clock::now();
+		double copy_seconds{ 0.0 };
+		do {
+			cycles_session_copy_buffer(bs.client_id, session_id, &pixels[0]);
+			copies++;
+			copy_seconds = seconds_since(copy_start);
+		} while (copy_seconds < 0.25 && copies < 1000);
+		r.copy_mb_per_second = (double)copies * buffer_size * sizeof(float) / (1024.0 * 1024.0) / copy_seconds;
+	}
+
+	cycles_session_destroy(bs.client_id, session_id);
+	r.ok = true;
+	return r;
+}
+
+/* Triangle and light counts are left out when they are 0, scenes read from
+ * XML don't know theirs.
+ */
+static void report(const string& name, const BenchScene& bs, const BenchResult& r)
+{
+	if (!r.ok) {
+		fprintf(stderr, "%s failed\n", name.c_str());
+		printf("{\"scene\":\"%s\",\"ok\":false}\n", name.c_str());
+		fflush(stdout);
+		return;
+	}
+
+	string counts;
+	if (bs.triangles > 0) counts += ",\"triangles\":" + std::to_string(bs.triangles);
+	counts += ",\"objects\":" + std::to_string(r.objects);
+	if (bs.lights > 0) counts += ",\"lights\":" + std::to_string(bs.lights);
+
+	fprintf(stderr, "%-24s %10u tris %6u objects %5u lights  build %8.3f s  sync %8.3f s  first pixel %8.3f s  %12.0f samples/s\n",
+		name.c_str(), bs.triangles, r.objects, bs.lights, r.build, r.sync, r.first_pixel, r.samples_per_second);
+	printf("{\"scene\":\"%s\",\"ok\":true%s,\"geometry_bytes\":%llu,"
+		"\"build_seconds\":%.6f,\"sync_seconds\":%.6f,\"first_pixel_seconds\":%.6f,\"render_seconds\":%.6f,"
+		"\"samples_per_second\":%.1f,\"tile_copy_seconds\":%.6f,\"copy_mb_per_second\":%.1f,\"mem_peak\":%llu}\n",
+		name.c_str(), counts.c_str(), r.geometry_bytes,
+		r.build, r.sync, r.first_pixel, r.render,
+		r.samples_per_second, r.tile_copy, r.copy_mb_per_second, r.mem_peak);
+	fflush(stdout);
+}
+
+/* A whole scene file, at the benchmark image size. */
+static void bench_scene_file(unsigned int client_id, const Options& opt, const char* name)
+{
+	string path = opt.tests + "/" + name + ".xml";
+
+	auto start = bench_clock::now();
+	BenchScene bs = create_scene(client_id, opt);
+	if (bs.scene_id == UINT_MAX) return;
+	BenchSceneGuard guard{ bs };
+	if (!cycles_scene_load_xml(client_id, bs.scene_id, path.c_str())) {
+		fprintf(stderr, "can't read %s, skipping\n", path.c_str());
+		return;
+	}
+	cycles_camera_set_size(client_id, bs.scene_id, opt.size, opt.size);
+	cycles_camera_compute_auto_viewplane(client_id, bs.scene_id);
+	cycles_camera_update(client_id, bs.scene_id);
+
+	report(name, bs, render_scene(bs, opt, start));
+}
+
+/* One mesh from tests/objects in front of the camera. */
+static void bench_object(unsigned int client_id, const Options& opt, const char* name)
+{
+	string path = opt.tests + "/objects/" + name + ".xml";
+
+	auto start = bench_clock::now();
+	BenchScene bs = create_scene(client_id, opt);
+	if (bs.scene_id == UINT_MAX) return;
+	BenchSceneGuard guard{ bs };
+
+	if (!cycles_scene_load_xml(client_id, bs.scene_id, path.c_str())) {
+		fprintf(stderr, "can't read %s, skipping\n", path.c_str());
+		return;
+	}
+
+	/* The file holds just the mesh, the last one the scene got. */
+	cycles_instance_stats stats{};
+	cycles_scene_get_instance_stats(client_id, bs.scene_id, &stats);
+	if (stats.meshes == 0) {
+		fprintf(stderr, "no mesh in %s, skipping\n", path.c_str());
+		return;
+	}
+	add_instance(bs, stats.meshes - 1, 0, 1.0f, 0.0f, 0.0f, 0.0f);
+	add_point_light(bs, 2.0f, 2.0f, -3.0f);
+
+	report(string("object_") + name, bs, render_scene(bs, opt, start));
+}
+
+/* A single grid mesh of tris triangles. */
+static void bench_triangles(unsigned int client_id, const Options& opt, unsigned int tris)
+{
+	MeshData mesh;
+	make_grid(tris, 2.0f, mesh);
+
+	auto start = bench_clock::now();
+	BenchScene bs = create_scene(client_id, opt);
+	if (bs.scene_id == UINT_MAX) return;
+	BenchSceneGuard guard{ bs };
+	unsigned int mesh_id = add_mesh(bs, mesh);
+	add_instance(bs, mesh_id, (unsigned int)(mesh.faces.size() / 3), 1.0f, 0.0f, 0.0f, 0.0f);
+	add_point_light(bs, 0.0f, 0.0f, -3.0f);
+
+	report("triangles_" + std::to_string(tris), bs, render_scene(bs, opt, start));
+}
+
+/* count instances of one small mesh laid out on a square grid. */
+static void bench_objects(unsigned int client_id, const Options& opt, unsigned int count)
+{
+	MeshData mesh;
+	make_grid(200, 1.0f, mesh);
+	unsigned int tris = (unsigned int)(mesh.faces.size() / 3);
+
+	auto start = bench_clock::now();
+	BenchScene bs = create_scene(client_id, opt);
+	if (bs.scene_id == UINT_MAX) return;
+	BenchSceneGuard guard{ bs };
+	unsigned int mesh_id = add_mesh(bs, mesh);
+
+	unsigned int side = std::max(1u, (unsigned int)ceil(sqrt((double)count)));
+	float spacing = 4.0f / side;
+	for (unsigned int i = 0; i < count; i++) {
+		float x = -2.0f + (i % side + 0.5f) * spacing;
+		float y = -2.0f + (i / side + 0.5f) * spacing;
+		add_instance(bs, mesh_id, tris, spacing * 0.4f, x, y, 0.0f);
+	}
+	add_point_light(bs, 0.0f, 0.0f, -3.0f);
+
+	report("objects_" + std::to_string(count), bs, render_scene(bs, opt, start));
+}
+
+/* A grid lit by count point lights spread out in front of it. */
+static void bench_lights(unsigned int client_id, const Options& opt, unsigned int count)
+{
+	MeshData mesh;
+	make_grid(20000, 2.0f, mesh);
+
+	auto start = bench_clock::now();
+	BenchScene bs = create_scene(client_id, opt);
+	if (bs.scene_id == UINT_MAX) return;
+	BenchSceneGuard guard{ bs };
+	unsigned int mesh_id = add_mesh(bs, mesh);
+	add_instance(bs, mesh_id, (unsigned int)(mesh.faces.size() / 3), 1.0f, 0.0f, 0.0f, 0.0f);
+
+	unsigned int side = std::max(1u, (unsigned int)ceil(sqrt((double)count)));
+	float spacing = 4.0f / side;
+	for (unsigned int i = 0; i < count; i++) {
+		float x = -2.0f + (i % side + 0.5f) * spacing;
+		float y = -2.0f + (i / side + 0.5f) * spacing;
+		add_point_light(bs, x, y, -1.0f);
+	}
+
+	report("lights_" + std::to_string(count), bs, render_scene(bs, opt, start));
+}
+
+static bool parse_options(int argc, char** argv, Options& opt)
+{
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (i + 1 >= argc) return false;
+		const char* value = argv[++i];
+		if (arg == "--tests") opt.tests = value;
+		else if (arg == "--kernels") opt.kernels = value;
+		else if (arg == "--device") opt.device = (unsigned int)strtoul(value, nullptr, 10);
+		else if (arg == "--size") opt.size = (unsigned int)strtoul(value, nullptr, 10);
+		else if (arg == "--samples") opt.samples = atoi(value);
+		else if (arg == "--max-tris") opt.max_tris = (unsigned int)strtoul(value, nullptr, 10);
+		else if (arg == "--max-objects") opt.max_objects = (unsigned int)strtoul(value, nullptr, 10);
+		else if (arg == "--max-lights") opt.max_lights = (unsigned int)strtoul(value, nullptr, 10);
+		else return false;
+	}
+	return opt.size > 0 && opt.samples > 0;
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parse_options(argc, argv, opt)) {
+		fprintf(stderr, "usage: ccycles_bench [--tests <dir>] [--kernels <path>] [--device <n>] [--size <n>] [--samples <n>]\n"
+			"                     [--max-tris <n>] [--max-objects <n>] [--max-lights <n>]\n");
+		return 2;
+	}
+
+	if (opt.kernels) {
+		cycles_path_init(opt.kernels, opt.kernels);
+	}
+	cycles_initialise();
+
+	unsigned int client_id = cycles_new_client();
+
+	bench_scene_file(client_id, opt, "scene_cube");
+	for (const char* name : { "cube", "uv_cube", "sphere", "suzanne" }) {
+		bench_object(client_id, opt, name);
+	}
+	/* Step in 64 bits, a maximum near UINT_MAX would wrap the last step. */
+	for (unsigned long long tris = 1000; tris <= opt.max_tris; tris *= 10) {
+		bench_triangles(client_id, opt, (unsigned int)tris);
+	}
+	for (unsigned long long count = 1; count <= opt.max_objects; count *= 10) {
+		bench_objects(client_id, opt, (unsigned int)count);
+	}
+	for (unsigned long long count = 1; count <= opt.max_lights; count *= 10) {
+		bench_lights(client_id, opt, (unsigned int)count);
+	}
+
+	cycles_release_client(client_id);
+	cycles_shutdown();
+
+	return 0;
+}
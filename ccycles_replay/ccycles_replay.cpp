@@ -0,0 +1,200 @@
+/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+
+/* Replays a log written by cycles_capture_start and reports where the
+ * time went, without the application that recorded it.
+ *
+ *   ccycles_replay <log> [kernel path]
+ *
+ * With a kernel path the recorded cycles_path_init calls are skipped,
+ * they point into the installation of the recording host.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#pragma warning ( push )
+#pragma warning ( disable : 4244 )
+
+#include "nodes.h"
+#include "util_transform.h"
+#include "util_types.h"
+
+#pragma warning ( pop )
+
+#include "ccycles.h"
+#include "capture_format.h"
+
+using std::string;
+
+typedef bool(*ReplayFunc)(CCCaptureReader& in);
+
+static const ReplayFunc replay_funcs[] = {
+#define CCCAPTURE_CALL(name) [](CCCaptureReader& in) { return capture_replay_call(in, &name); },
+#include "capture_calls.h"
+#undef CCCAPTURE_CALL
+};
+
+static const char* call_names[] = {
+#define CCCAPTURE_CALL(name) #name,
+#include "capture_calls.h"
+#undef CCCAPTURE_CALL
+};
+
+enum class phase {
+	SETUP,
+	SHADERS,
+	GEOMETRY,
+	SCENE,
+	SESSION,
+	RENDER,
+	COUNT
+};
+
+static const char* phase_names[] = { "setup", "shaders", "geometry", "scene", "session", "render" };
+
+/* Rendering happens between start and wait, the rest is grouped by what
+ * the call works on.
+ */
+static phase phase_of(const string& name)
+{
+	if (name == "cycles_session_start" || name == "cycles_session_wait") return phase::RENDER;
+	if (name.find("shader") != string::npos) return phase::SHADERS;
+	if (name.find("mesh") != string::npos || name.find("object") != string::npos) return phase::GEOMETRY;
+	if (name.find("session") != string::npos || name.find("progress") != string::npos) return phase::SESSION;
+	if (name.find("scene") != string::npos || name.find("camera") != string::npos || name.find("light") != string::npos
+		|| name.find("film") != string::npos || name.find("integrator") != string::npos) return phase::SCENE;
+	return phase::SETUP;
+}
+
+struct Timing {
+	unsigned int calls;
+	double seconds;
+};
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: ccycles_replay <log> [kernel path]\n");
+		return 2;
+	}
+
+	std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+	if (!file) {
+		fprintf(stderr, "can't open %s\n", argv[1]);
+		return 1;
+	}
+	std::vector<unsigned char> log((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	CCCaptureReader in(log.empty() ? nullptr : &log[0], log.size());
+	unsigned int magic = in.value<unsigned int>();
+	unsigned int version = in.value<unsigned int>();
+	unsigned int call_count = in.value<unsigned int>();
+	if (!in.ok() || magic != CAPTURE_MAGIC || version != CAPTURE_VERSION) {
+		fprintf(stderr, "%s is not a capture log of this version\n", argv[1]);
+		return 1;
+	}
+	if (call_count > (unsigned int)capture_call::COUNT) {
+		fprintf(stderr, "log was written by a newer ccycles, calls it added can't be replayed\n");
+	}
+
+	const char* kernel_path = argc > 2 ? argv[2] : nullptr;
+	if (kernel_path) {
+		cycles_path_init(kernel_path, kernel_path);
+	}
+	/* The capture may have started after initialising. */
+	cycles_initialise();
+
+	std::vector<Timing> per_call((size_t)capture_call::COUNT, Timing{ 0, 0.0 });
+	std::vector<Timing> per_phase((size_t)phase::COUNT, Timing{ 0, 0.0 });
+	bool shut_down{ false };
+	unsigned int replayed{ 0 };
+
+	auto replay_start = std::chrono::steady_clock::now();
+
+	while (!in.at_end()) {
+		size_t record_offset = in.offset();
+		unsigned short id = in.value<unsigned short>();
+		if (!in.ok() || id >= (unsigned short)capture_call::COUNT) {
+			fprintf(stderr, "unknown call %u at offset %zu, stopping\n", (unsigned int)id, record_offset);
+			break;
+		}
+
+		capture_call call = (capture_call)id;
+
+		auto call_start = std::chrono::steady_clock::now();
+		bool ok;
+		if (call == capture_call::cycles_path_init && kernel_path) {
+			/* Already set from the command line. */
+			CCCaptureArg<const char*>::get(in);
+			CCCaptureArg<const char*>::get(in);
+			ok = in.ok();
+		}
+		else {
+			ok = replay_funcs[id](in);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - call_start).count();
+		in.release();
+
+		if (!ok) {
+			fprintf(stderr, "log ends inside %s at offset %zu, stopping\n", call_names[id], record_offset);
+			break;
+		}
+
+		Timing& c = per_call[id];
+		c.calls++;
+		c.seconds += seconds;
+		Timing& p = per_phase[(size_t)phase_of(call_names[id])];
+		p.calls++;
+		p.seconds += seconds;
+
+		shut_down = call == capture_call::cycles_shutdown;
+		replayed++;
+	}
+
+	double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+
+	if (!shut_down) {
+		cycles_shutdown();
+	}
+
+	printf("replayed %u calls in %.3f s\n\n", replayed, total);
+
+	printf("%-10s %10s %12s\n", "phase", "calls", "seconds");
+	for (size_t i = 0; i < (size_t)phase::COUNT; i++) {
+		printf("%-10s %10u %12.4f\n", phase_names[i], per_phase[i].calls, per_phase[i].seconds);
+	}
+
+	std::vector<size_t> order;
+	for (size_t i = 0; i < per_call.size(); i++) {
+		if (per_call[i].calls > 0) order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [&per_call](size_t a, size_t b) { return per_call[a].seconds > per_call[b].seconds; });
+	if (order.size() > 10) order.resize(10);
+
+	printf("\n%-48s %10s %12s\n", "slowest calls", "calls", "seconds");
+	for (size_t i : order) {
+		printf("%-48s %10u %12.4f\n", call_names[i], per_call[i].calls, per_call[i].seconds);
+	}
+
+	return 0;
+}
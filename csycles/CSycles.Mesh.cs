@@ -57,6 +57,34 @@ namespace ccl
 			}
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_mesh_set_verts_float4", CallingConvention = CallingConvention.Cdecl)]
+		private unsafe static extern void cycles_mesh_set_verts_float4(uint clientId, uint sceneId, uint meshId, float* verts, uint vcount);
+		public static void mesh_set_verts_float4(uint clientId, uint sceneId, uint meshId, ref float[] verts, uint vcount)
+		{
+			unsafe
+			{
+				fixed (float* pverts = verts)
+				{
+					cycles_mesh_set_verts_float4(clientId, sceneId, meshId, pverts, vcount);
+				}
+			}
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_mesh_set_tris_bulk", CallingConvention = CallingConvention.Cdecl)]
+		private unsafe static extern void cycles_mesh_set_tris_bulk(uint clientId, uint sceneId, uint meshId, int* faces, uint fcount, uint* shaderIds, byte* smooth);
+		public static void mesh_set_tris_bulk(uint clientId, uint sceneId, uint meshId, ref int[] tris, uint fcount, ref uint[] shaderIds, byte[] smooth)
+		{
+			unsafe
+			{
+				fixed (int* ptris = tris)
+				fixed (uint* pshaders = shaderIds)
+				fixed (byte* psmooth = smooth)
+				{
+					cycles_mesh_set_tris_bulk(clientId, sceneId, meshId, ptris, fcount, pshaders, psmooth);
+				}
+			}
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_mesh_add_triangle", CallingConvention = CallingConvention.Cdecl)]
 		private static extern void cycles_mesh_add_triangle(uint clientId, uint sceneId, uint meshId, uint v0, uint v1, uint v2, uint shaderId, uint smooth);
 
@@ -98,6 +126,28 @@ namespace ccl
 			cycles_mesh_tag_rebuild(clientId, sceneId, meshId);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_mesh_load_binary", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_mesh_load_binary(uint clientId, uint sceneId, uint meshId, [MarshalAs(UnmanagedType.LPStr)] string path);
+
+		/// <summary>
+		/// Replace the geometry of meshId with a file written by mesh_save_binary.
+		/// </summary>
+		public static bool mesh_load_binary(uint clientId, uint sceneId, uint meshId, string path)
+		{
+			return cycles_mesh_load_binary(clientId, sceneId, meshId, path) == 1;
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_mesh_save_binary", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_mesh_save_binary(uint clientId, uint sceneId, uint meshId, [MarshalAs(UnmanagedType.LPStr)] string path);
+
+		/// <summary>
+		/// Write the geometry of meshId to a binary mesh file.
+		/// </summary>
+		public static bool mesh_save_binary(uint clientId, uint sceneId, uint meshId, string path)
+		{
+			return cycles_mesh_save_binary(clientId, sceneId, meshId, path) == 1;
+		}
+
 #endregion
 
 	}
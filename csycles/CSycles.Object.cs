@@ -34,6 +34,30 @@ namespace ccl
 			return cycles_scene_object_get_mesh(clientId, sceneId, objectId);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_add_mesh_instance", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_scene_add_mesh_instance(uint clientId, uint sceneId, uint meshId,
+			float a, float b, float c, float d,
+			float e, float f, float g, float h,
+			float i, float j, float k, float l,
+			float m, float n, float o, float p);
+		public static uint scene_add_mesh_instance(uint clientId, uint sceneId, uint meshId, Transform t)
+		{
+			return cycles_scene_add_mesh_instance(clientId, sceneId, meshId,
+				t.x.x, t.x.y, t.x.z, t.x.w,
+				t.y.x, t.y.y, t.y.z, t.y.w,
+				t.z.x, t.z.y, t.z.z, t.z.w,
+				t.w.x, t.w.y, t.w.z, t.w.w);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_get_instance_stats", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_scene_get_instance_stats(uint clientId, uint sceneId, out InstanceStats stats);
+		public static InstanceStats scene_get_instance_stats(uint clientId, uint sceneId)
+		{
+			InstanceStats stats;
+			cycles_scene_get_instance_stats(clientId, sceneId, out stats);
+			return stats;
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_object_set_visibility", CallingConvention = CallingConvention.Cdecl)]
 		private static extern void cycles_scene_object_set_visibility(uint clientId, uint sceneId, uint objectId, uint visibility);
 		public static void object_set_visibility(uint clientId, uint sceneId, uint objectId, PathRay visibility)
@@ -57,4 +81,36 @@ namespace ccl
 
 		#endregion
 	}
+
+	/// <summary>
+	/// Geometry sharing in a scene.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct InstanceStats
+	{
+		/// <summary>
+		/// Objects in the scene.
+		/// </summary>
+		public uint Objects;
+		/// <summary>
+		/// Meshes in the scene.
+		/// </summary>
+		public uint Meshes;
+		/// <summary>
+		/// Meshes used by more than one object.
+		/// </summary>
+		public uint InstancedMeshes;
+		/// <summary>
+		/// Objects using one of the instanced meshes.
+		/// </summary>
+		public uint Instances;
+		/// <summary>
+		/// Bytes of geometry data of all meshes in use, each counted once.
+		/// </summary>
+		public ulong BytesStored;
+		/// <summary>
+		/// Bytes that would have been stored additionally without sharing.
+		/// </summary>
+		public ulong BytesSaved;
+	}
 }
@@ -12,6 +12,13 @@ namespace ccl
 			return cycles_scene_create(clientId, sceneParamsId, deviceid);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_destroy", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_scene_destroy(uint clientId, uint sceneId);
+		public static void scene_destroy(uint clientId, uint sceneId)
+		{
+			cycles_scene_destroy(clientId, sceneId);
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_reset", CallingConvention = CallingConvention.Cdecl)]
 		private static extern void cycles_scene_reset(uint clientId, uint sceneId);
 		public static void scene_reset(uint clientId, uint sceneId)
@@ -40,6 +47,17 @@ namespace ccl
 			cycles_scene_unlock(clientId, sceneId);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_load_xml", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_scene_load_xml(uint clientId, uint sceneId, [MarshalAs(UnmanagedType.LPStr)] string path);
+		/// <summary>
+		/// Load a scene XML file into sceneId with the native reader.
+		/// </summary>
+		/// <returns>true if the whole file was read</returns>
+		public static bool scene_load_xml(uint clientId, uint sceneId, string path)
+		{
+			return cycles_scene_load_xml(clientId, sceneId, path) == 1;
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_add_object", CallingConvention = CallingConvention.Cdecl)]
 		private static extern uint cycles_scene_add_object(uint clientId, uint sceneId);
 		public static uint scene_add_object(uint clientId, uint sceneId)
@@ -61,6 +79,18 @@ namespace ccl
 			return cycles_scene_add_mesh(clientId, sceneId, shaderId);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_add_meshes_batch", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_scene_add_meshes_batch(uint clientId, uint sceneId, [In, Out] MeshDescriptor[] descs, uint count);
+		/// <summary>
+		/// Fill several meshes in one call. The arrays the descriptors point to
+		/// must stay pinned for the duration of the call.
+		/// </summary>
+		/// <returns>Number of meshes filled</returns>
+		public static uint scene_add_meshes_batch(uint clientId, uint sceneId, MeshDescriptor[] descs)
+		{
+			return cycles_scene_add_meshes_batch(clientId, sceneId, descs, (uint)descs.Length);
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_scene_set_background_shader",
 			CallingConvention = CallingConvention.Cdecl)]
 		private static extern void cycles_scene_set_background_shader(uint clientId, uint sceneId, uint shaderId);
@@ -179,4 +209,27 @@ namespace ccl
 
 
 	}
+
+	/// <summary>
+	/// Geometry for one mesh in a CSycles.scene_add_meshes_batch call.
+	/// Pointers can be IntPtr.Zero to skip that array.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct MeshDescriptor
+	{
+		/// <summary>
+		/// Mesh to fill, or uint.MaxValue to create a new one. Receives the new id.
+		/// </summary>
+		public uint meshId;
+		public uint shaderId;
+		public uint smooth;
+		public System.IntPtr verts;
+		public uint vcount;
+		public System.IntPtr faces;
+		public uint fcount;
+		public System.IntPtr vnormals;
+		public uint vnormalcount;
+		public System.IntPtr uvs;
+		public uint uvcount;
+	}
 }
@@ -13,6 +13,55 @@ namespace ccl
 			cycles_session_reset(clientId, sessionId, width, height, samples);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_reset_region", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_reset_region(uint clientId, uint sessionId, uint fullWidth, uint fullHeight, uint x, uint y, uint width, uint height, uint samples);
+		public static void session_reset_region(uint clientId, uint sessionId, uint fullWidth, uint fullHeight, uint x, uint y, uint width, uint height, uint samples)
+		{
+			cycles_session_reset_region(clientId, sessionId, fullWidth, fullHeight, x, y, width, height, samples);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_merge_region", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_merge_region([In, Out] float[] fullBuffer, uint fullWidth, uint fullHeight, [In] float[] regionBuffer, uint x, uint y, uint width, uint height, uint stride);
+		public static void merge_region(float[] fullBuffer, uint fullWidth, uint fullHeight, float[] regionBuffer, uint x, uint y, uint width, uint height, uint stride)
+		{
+			cycles_merge_region(fullBuffer, fullWidth, fullHeight, regionBuffer, x, y, width, height, stride);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_set_keep_raw_buffer", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_set_keep_raw_buffer(uint clientId, uint sessionId, uint keep);
+		public static void session_set_keep_raw_buffer(uint clientId, uint sessionId, bool keep)
+		{
+			cycles_session_set_keep_raw_buffer(clientId, sessionId, (uint)(keep ? 1 : 0));
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_raw_buffer_info", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_get_raw_buffer_info(uint clientId, uint sessionId, [Out] out uint width, [Out] out uint height, [Out] out uint passStride);
+		public static void session_get_raw_buffer_info(uint clientId, uint sessionId, out uint width, out uint height, out uint passStride)
+		{
+			cycles_session_get_raw_buffer_info(clientId, sessionId, out width, out height, out passStride);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_copy_raw_buffer", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_copy_raw_buffer(uint clientId, uint sessionId, [In, Out] float[] buffer, [In, Out] uint[] samples);
+		public static void session_copy_raw_buffer(uint clientId, uint sessionId, float[] buffer, uint[] samples)
+		{
+			cycles_session_copy_raw_buffer(clientId, sessionId, buffer, samples);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_import_raw_buffer", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_import_raw_buffer(uint clientId, uint sessionId, [In] float[] buffer, [In] uint[] samples);
+		public static void session_import_raw_buffer(uint clientId, uint sessionId, float[] buffer, uint[] samples)
+		{
+			cycles_session_import_raw_buffer(clientId, sessionId, buffer, samples);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_merge_raw_buffers", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_merge_raw_buffers([In, Out] float[] dst, [In, Out] uint[] dstSamples, [In] float[] src, [In] uint[] srcSamples, uint pixelCount, uint passStride);
+		public static void merge_raw_buffers(float[] dst, uint[] dstSamples, float[] src, uint[] srcSamples, uint pixelCount, uint passStride)
+		{
+			cycles_merge_raw_buffers(dst, dstSamples, src, srcSamples, pixelCount, passStride);
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_create", CallingConvention = CallingConvention.Cdecl)]
 		private static extern uint cycles_session_create(uint clientId, uint sessionParamsId, uint sceneId);
 		public static uint session_create(uint clientId, uint sessionParamsId, uint sceneId)
@@ -27,19 +76,105 @@ namespace ccl
 			return cycles_session_destroy(clientId, sceneId);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_pool_set_capacity", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_pool_set_capacity(uint clientId, uint capacity);
+		public static void session_pool_set_capacity(uint clientId, uint capacity)
+		{
+			cycles_session_pool_set_capacity(clientId, capacity);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_pool_prewarm", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_session_pool_prewarm(uint clientId, uint sessionParamsId, uint count);
+		public static uint session_pool_prewarm(uint clientId, uint sessionParamsId, uint count)
+		{
+			return cycles_session_pool_prewarm(clientId, sessionParamsId, count);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_pool_clear", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_pool_clear(uint clientId);
+		public static void session_pool_clear(uint clientId)
+		{
+			cycles_session_pool_clear(clientId);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_pool_get_stats", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_pool_get_stats(uint clientId, out SessionPoolStats stats);
+		public static SessionPoolStats session_pool_get_stats(uint clientId)
+		{
+			SessionPoolStats stats;
+			cycles_session_pool_get_stats(clientId, out stats);
+			return stats;
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_copy_buffer", CallingConvention = CallingConvention.Cdecl)]
 		private static extern void cycles_session_copy_buffer(uint clientId, uint sessionId, [In, Out] IntPtr buffer);
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_copy_buffer_sized", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_session_copy_buffer_sized(uint clientId, uint sessionId, IntPtr buffer, ulong bufferBytes);
+		/// <summary>
+		/// Copy the session buffer into buffer, throwing when buffer doesn't
+		/// match the size of the session buffer in its current format.
+		/// </summary>
+		private static void session_copy_buffer_sized(uint clientId, uint sessionId, Array buffer, string format)
+		{
+			var handle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+			var copied = cycles_session_copy_buffer_sized(clientId, sessionId, handle.AddrOfPinnedObject(), (ulong)Buffer.ByteLength(buffer));
+			handle.Free();
+			if (copied == 0)
+			{
+				throw new InvalidOperationException(string.Format("Session {0} buffer format isn't {1}", sessionId, format));
+			}
+		}
+
 		public static float[] session_copy_buffer(uint clientId, uint sessionId, uint bufferSize)
 		{
-			var alloc_mem = Marshal.AllocHGlobal((int)bufferSize * sizeof(float));
 			var to_return = new float[bufferSize];
-			cycles_session_copy_buffer(clientId, sessionId, alloc_mem);
-			Marshal.Copy(alloc_mem, to_return, 0, (int)bufferSize);
+			session_copy_buffer_sized(clientId, sessionId, to_return, "Float");
+			return to_return;
+		}
+
+		public static ushort[] session_copy_buffer_half(uint clientId, uint sessionId, uint bufferSize)
+		{
+			var to_return = new ushort[bufferSize];
+			session_copy_buffer_sized(clientId, sessionId, to_return, "Half");
+			return to_return;
+		}
 
-			Marshal.FreeHGlobal(alloc_mem);
+		public static byte[] session_copy_buffer_rgba8(uint clientId, uint sessionId, uint bufferSize)
+		{
+			var to_return = new byte[bufferSize];
+			session_copy_buffer_sized(clientId, sessionId, to_return, "Rgba8Srgb");
 			return to_return;
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_set_buffer_format", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_set_buffer_format(uint clientId, uint sessionId, BufferFormat format);
+		public static void session_set_buffer_format(uint clientId, uint sessionId, BufferFormat format)
+		{
+			cycles_session_set_buffer_format(clientId, sessionId, format);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_copy_dirty_regions", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int cycles_session_copy_dirty_regions(uint clientId, uint sessionId, IntPtr buffer, [Out] BufferRect[] rects, int maxRects);
+		/// <summary>
+		/// Update buffer with only the areas that changed since the previous copy.
+		/// buffer has to match the format set with session_set_buffer_format.
+		/// </summary>
+		/// <returns>Number of entries in rects that got filled</returns>
+		public static int session_copy_dirty_regions(uint clientId, uint sessionId, Array buffer, BufferRect[] rects)
+		{
+			var handle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+			var count = cycles_session_copy_dirty_regions(clientId, sessionId, handle.AddrOfPinnedObject(), rects, rects.Length);
+			handle.Free();
+			return count;
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_buffer_generation", CallingConvention = CallingConvention.Cdecl)]
+		private static extern ulong cycles_session_get_buffer_generation(uint clientId, uint sessionId);
+		public static ulong session_get_buffer_generation(uint clientId, uint sessionId)
+		{
+			return cycles_session_get_buffer_generation(clientId, sessionId);
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_buffer", CallingConvention = CallingConvention.Cdecl)]
 		private static extern IntPtr cycles_session_get_buffer(uint clientId, uint sessionId);
 		public static IntPtr session_get_buffer(uint clientId, uint sessionId)
@@ -54,6 +189,36 @@ namespace ccl
 			cycles_session_get_buffer_info(clientId, sessionId, out bufferSize, out bufferStride);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_add_pass", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_add_pass(uint clientId, uint sessionId, uint passType);
+		public static void session_add_pass(uint clientId, uint sessionId, PassType passType)
+		{
+			cycles_session_add_pass(clientId, sessionId, (uint)passType);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_pass_buffer_info", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_get_pass_buffer_info(uint clientId, uint sessionId, uint passType, [Out] out uint bufferSize, [Out] out uint bufferStride);
+		public static void session_get_pass_buffer_info(uint clientId, uint sessionId, PassType passType, out uint bufferSize, out uint bufferStride)
+		{
+			cycles_session_get_pass_buffer_info(clientId, sessionId, (uint)passType, out bufferSize, out bufferStride);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_pass_buffer", CallingConvention = CallingConvention.Cdecl)]
+		private static extern IntPtr cycles_session_get_pass_buffer(uint clientId, uint sessionId, uint passType);
+		public static IntPtr session_get_pass_buffer(uint clientId, uint sessionId, PassType passType)
+		{
+			return cycles_session_get_pass_buffer(clientId, sessionId, (uint)passType);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_copy_pass_buffer", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_copy_pass_buffer(uint clientId, uint sessionId, uint passType, [In, Out] float[] buffer);
+		public static float[] session_copy_pass_buffer(uint clientId, uint sessionId, PassType passType, uint bufferSize)
+		{
+			var to_return = new float[bufferSize];
+			cycles_session_copy_pass_buffer(clientId, sessionId, (uint)passType, to_return);
+			return to_return;
+		}
+
 		[UnmanagedFunctionPointer(CallingConvention.Cdecl)]
 		public delegate void UpdateCallback(uint sid);
 		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl, EntryPoint = "cycles_session_set_update_callback")]
@@ -96,6 +261,13 @@ namespace ccl
 			cycles_session_set_display_update_callback(clientId, sessionId, displayUpdateCallback);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_set_callback_rate", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_set_callback_rate(uint clientId, uint sessionId, float rate);
+		public static void session_set_callback_rate(uint clientId, uint sessionId, float rate)
+		{
+			cycles_session_set_callback_rate(clientId, sessionId, rate);
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_start", CallingConvention = CallingConvention.Cdecl)]
 		private static extern void cycles_session_start(uint clientId, uint sessionId);
 		public static void session_start(uint clientId, uint sessionId)
@@ -279,6 +451,13 @@ namespace ccl
 		{
 			cycles_session_params_set_shadingsystem(clientId, sessionParamsId, (uint)shadingSystem);
 		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_params_set_time_limit", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_params_set_time_limit(uint clientId, uint sessionParamsId, double timeLimit);
+		public static void session_params_set_time_limit(uint clientId, uint sessionParamsId, double timeLimit)
+		{
+			cycles_session_params_set_time_limit(clientId, sessionParamsId, timeLimit);
+		}
 #endregion
 
 #region progress
@@ -317,6 +496,53 @@ namespace ccl
 			cycles_tilemanager_get_sample_info(clientId, sessionId, out samples, out numSamples);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_tilemanager_get_tile_sample_info", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_tilemanager_get_tile_sample_info(uint clientId, uint sessionId, [Out] TileInfo[] tiles, uint maxTiles);
+		/// <summary>
+		/// Fill tiles with per-tile sample counts and convergence state.
+		/// </summary>
+		/// <returns>Number of entries filled</returns>
+		public static uint tilemanager_get_tile_sample_info(uint clientId, uint sessionId, TileInfo[] tiles)
+		{
+			return cycles_tilemanager_get_tile_sample_info(clientId, sessionId, tiles, (uint)tiles.Length);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_stats", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_get_stats(uint clientId, uint sessionId, out SessionStats stats);
+		public static SessionStats session_get_stats(uint clientId, uint sessionId)
+		{
+			SessionStats stats;
+			cycles_session_get_stats(clientId, sessionId, out stats);
+			return stats;
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_poll_events", CallingConvention = CallingConvention.Cdecl)]
+		private static extern uint cycles_session_poll_events(uint clientId, uint sessionId, [Out] SessionEvent[] events, uint maxEvents);
+		/// <summary>
+		/// Take the events that happened since the last poll, oldest first.
+		/// </summary>
+		/// <returns>Number of entries filled</returns>
+		public static uint session_poll_events(uint clientId, uint sessionId, SessionEvent[] events)
+		{
+			return cycles_session_poll_events(clientId, sessionId, events, (uint)events.Length);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_get_progress_snapshot", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_get_progress_snapshot(uint clientId, uint sessionId, out ProgressSnapshot snapshot);
+		public static ProgressSnapshot session_get_progress_snapshot(uint clientId, uint sessionId)
+		{
+			ProgressSnapshot snapshot;
+			cycles_session_get_progress_snapshot(clientId, sessionId, out snapshot);
+			return snapshot;
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_session_set_adaptive_sampling", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_session_set_adaptive_sampling(uint clientId, uint sessionId, float threshold, uint minSamples);
+		public static void session_set_adaptive_sampling(uint clientId, uint sessionId, float threshold, uint minSamples)
+		{
+			cycles_session_set_adaptive_sampling(clientId, sessionId, threshold, minSamples);
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_progress_get_status", CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl)]
 		private static extern IntPtr cycles_progress_get_status(uint clientId, uint sessionId);
 		public static string progress_get_status(uint clientId, uint sessionId)
@@ -334,4 +560,168 @@ namespace ccl
 
 #endregion
 	}
+
+	/// <summary>
+	/// Area of a session pixel buffer, in pixels.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct BufferRect
+	{
+		public int x;
+		public int y;
+		public int width;
+		public int height;
+	}
+
+	/// <summary>
+	/// Sampling state of one render tile.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct TileInfo
+	{
+		public int x;
+		public int y;
+		public int width;
+		public int height;
+		/// <summary>
+		/// Samples rendered so far.
+		/// </summary>
+		public uint samples;
+		/// <summary>
+		/// Estimated relative noise, float.MaxValue until known.
+		/// </summary>
+		public float error;
+		/// <summary>
+		/// Non-zero once error got below the adaptive sampling threshold.
+		/// </summary>
+		public uint converged;
+	}
+
+	/// <summary>
+	/// One session progress event.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct SessionEvent
+	{
+		public SessionEventType type;
+		/// <summary>
+		/// Tile area for TileDone and TileUpdate.
+		/// </summary>
+		public int x;
+		public int y;
+		public int width;
+		public int height;
+		/// <summary>
+		/// Samples per pixel at the time of the event.
+		/// </summary>
+		public int sample;
+		/// <summary>
+		/// Seconds since the render started.
+		/// </summary>
+		public double time;
+	}
+
+	/// <summary>
+	/// Progress of a session as of the latest update.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+	public struct ProgressSnapshot
+	{
+		/// <summary>
+		/// Increases with each update, 0 before the first one.
+		/// </summary>
+		public ulong Generation;
+		/// <summary>
+		/// 0 to 1.
+		/// </summary>
+		public float Progress;
+		public int Sample;
+		public int TotalSamples;
+		public int TilesDone;
+		public int TotalTiles;
+		public double TotalTime;
+		public double RenderTime;
+		public double TileTime;
+		public uint Finished;
+		public uint Cancelled;
+		public uint Error;
+		public uint EventsDropped;
+		[MarshalAs(UnmanagedType.ByValTStr, SizeConst = 128)]
+		public string Status;
+		[MarshalAs(UnmanagedType.ByValTStr, SizeConst = 128)]
+		public string Substatus;
+	}
+
+	/// <summary>
+	/// Throughput and timings of a session since its last reset. Times are
+	/// in seconds.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct SessionStats
+	{
+		public ulong PixelSamples;
+		public double SamplesPerSecond;
+		public double RenderTime;
+		/// <summary>
+		/// Tiles timed, with their mean and longest render time.
+		/// </summary>
+		public uint Tiles;
+		public double TileTimeMean;
+		public double TileTimeMax;
+		/// <summary>
+		/// Bucket i counts tiles that took less than 2^i milliseconds and at
+		/// least half that, the last bucket everything longer.
+		/// </summary>
+		[MarshalAs(UnmanagedType.ByValArray, SizeConst = 16)]
+		public uint[] TileTimeHistogram;
+		/// <summary>
+		/// Time spent copying tiles to the session buffers.
+		/// </summary>
+		public double CopyTime;
+		/// <summary>
+		/// Part of CopyTime spent waiting for the pixel buffer lock.
+		/// </summary>
+		public double PixelsLockWait;
+		/// <summary>
+		/// Time until rendering began, and the part of it spent on images,
+		/// shaders and meshes.
+		/// </summary>
+		public double SyncTime;
+		public double ImageTime;
+		public double ShaderTime;
+		public double MeshTime;
+		/// <summary>
+		/// Device memory in use now, and the most in use at any time.
+		/// </summary>
+		public ulong MemUsed;
+		public ulong MemPeak;
+	}
+
+	/// <summary>
+	/// Session pool use.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct SessionPoolStats
+	{
+		/// <summary>
+		/// Sessions created from the pool.
+		/// </summary>
+		public uint Hits;
+		/// <summary>
+		/// Sessions created from scratch.
+		/// </summary>
+		public uint Misses;
+		/// <summary>
+		/// Sessions waiting in the pool.
+		/// </summary>
+		public uint Idle;
+		/// <summary>
+		/// Average time to construct a session, in seconds.
+		/// </summary>
+		public double StartupSeconds;
+		/// <summary>
+		/// Construction time hits avoided, in seconds.
+		/// </summary>
+		public double SecondsSaved;
+	}
 }
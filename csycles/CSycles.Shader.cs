@@ -250,7 +250,56 @@ namespace ccl
 			cycles_shader_new_graph(clientId, shaderId);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, EntryPoint = "cycles_image_cache_get_stats", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void cycles_image_cache_get_stats(uint clientId, out ImageCacheStats stats);
+		public static ImageCacheStats image_cache_get_stats(uint clientId)
+		{
+			ImageCacheStats stats;
+			cycles_image_cache_get_stats(clientId, out stats);
+			return stats;
+		}
+
 
 #endregion
 	}
+
+	/// <summary>
+	/// Builtin images held for texture nodes.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct ImageCacheStats
+	{
+		/// <summary>
+		/// Images in the cache.
+		/// </summary>
+		public uint Images;
+		/// <summary>
+		/// Pixel buffers held. Images with equal pixels share one buffer.
+		/// </summary>
+		public uint Buffers;
+		/// <summary>
+		/// References shader graphs hold on cached images.
+		/// </summary>
+		public uint References;
+		/// <summary>
+		/// Bytes of pixel data held.
+		/// </summary>
+		public ulong BytesHeld;
+		/// <summary>
+		/// Bytes not held because images share a buffer.
+		/// </summary>
+		public ulong BytesSaved;
+		/// <summary>
+		/// Lookups that found an existing image.
+		/// </summary>
+		public uint Hits;
+		/// <summary>
+		/// Lookups that added a new image.
+		/// </summary>
+		public uint Misses;
+		/// <summary>
+		/// Images freed because no shader graph held them anymore.
+		/// </summary>
+		public uint Evictions;
+	}
 }
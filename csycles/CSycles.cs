@@ -201,6 +201,68 @@ namespace ccl
 			cycles_log_to_stdout(stdOut ? 1 : 0);
 		}
 
+		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl,
+			EntryPoint = "cycles_set_log_level")]
+		private static extern void cycles_set_log_level(uint level);
+		/**
+		 * Only log messages of level and up. LogLevel.None turns logging off.
+		 *
+		 * Note that this is global to the logger.
+		 */
+		public static void set_log_level(LogLevel level)
+		{
+			cycles_set_log_level((uint)level);
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl,
+			EntryPoint = "cycles_trace_start")]
+		private static extern void cycles_trace_start();
+		/**
+		 * Start recording a Chrome trace of API calls and render pipeline phases.
+		 *
+		 * Note that tracing is global to all clients and sessions.
+		 */
+		public static void trace_start()
+		{
+			cycles_trace_start();
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl,
+			EntryPoint = "cycles_trace_stop")]
+		private static extern uint cycles_trace_stop([MarshalAs(UnmanagedType.LPStr)] string path);
+		/**
+		 * Stop recording and write the trace to path. Returns false if the file
+		 * couldn't be written.
+		 */
+		public static bool trace_stop(string path)
+		{
+			return cycles_trace_stop(path) == 1;
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl,
+			EntryPoint = "cycles_capture_start")]
+		private static extern uint cycles_capture_start([MarshalAs(UnmanagedType.LPStr)] string path);
+		/**
+		 * Record all following API calls that change state to a log at path,
+		 * for replay with ccycles_replay. Start before creating the client.
+		 * Returns false if the log couldn't be opened.
+		 */
+		public static bool capture_start(string path)
+		{
+			return cycles_capture_start(path) == 1;
+		}
+
+		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl,
+			EntryPoint = "cycles_capture_stop")]
+		private static extern void cycles_capture_stop();
+		/**
+		 * Stop recording and close the log.
+		 */
+		public static void capture_stop()
+		{
+			cycles_capture_stop();
+		}
+
 		[DllImport("ccycles.dll", SetLastError = false, CallingConvention = CallingConvention.Cdecl,
 			EntryPoint = "cycles_new_client")]
 		private static extern uint cycles_new_client();
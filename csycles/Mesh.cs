@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 **/
 
+using System.Runtime.InteropServices;
+
 namespace ccl
 {
 	/// <summary>
@@ -97,6 +99,16 @@ namespace ccl
 			CSycles.mesh_set_verts(Client.Id, Client.Scene.Id, Id, ref verts, (uint) (verts.Length/3));
 		}
 
+		/// <summary>
+		/// Set vertex coordinates given as x,y,z,w. The w component is ignored,
+		/// but the layout lets Cycles copy the array in one go.
+		/// </summary>
+		/// <param name="verts"></param>
+		public void SetVertsFloat4(ref float[] verts)
+		{
+			CSycles.mesh_set_verts_float4(Client.Id, Client.Scene.Id, Id, ref verts, (uint) (verts.Length/4));
+		}
+
 		/// <summary>
 		/// Set trifaces
 		/// </summary>
@@ -107,6 +119,82 @@ namespace ccl
 			CSycles.mesh_set_tris(Client.Id, Client.Scene.Id, Id, ref faces, (uint) (faces.Length/3), Client.Scene.GetShaderSceneId(Shader), smooth);
 		}
 
+		/// <summary>
+		/// Set trifaces with a shader and smooth flag per face
+		/// </summary>
+		/// <param name="faces"></param>
+		/// <param name="shaders">Shader for each face</param>
+		/// <param name="smooth">Smooth flag for each face, null for all flat</param>
+		public void SetVertTris(ref int[] faces, Shader[] shaders, bool[] smooth)
+		{
+			var count = faces.Length/3;
+			var shaderIds = new uint[count];
+			var smoothFlags = smooth == null ? null : new byte[count];
+			for (var i = 0; i < count; i++)
+			{
+				shaderIds[i] = Client.Scene.GetShaderSceneId(shaders[i]);
+				if (smoothFlags != null) smoothFlags[i] = (byte)(smooth[i] ? 1 : 0);
+			}
+			CSycles.mesh_set_tris_bulk(Client.Id, Client.Scene.Id, Id, ref faces, (uint) count, ref shaderIds, smoothFlags);
+		}
+
+		/// <summary>
+		/// Set vertex coordinates, trifaces and optionally vertex normals and UVs
+		/// for several meshes at once. The meshes are filled in parallel.
+		///
+		/// All arrays are indexed like meshes. Entries of vertexNormals and uvs
+		/// may be null, as may the arrays themselves.
+		/// </summary>
+		/// <param name="client"></param>
+		/// <param name="meshes"></param>
+		/// <param name="verts">x,y,z per vertex</param>
+		/// <param name="faces">Three vertex indices per triangle</param>
+		/// <param name="vertexNormals">x,y,z per vertex</param>
+		/// <param name="uvs">u,v per triangle corner</param>
+		/// <param name="smooth"></param>
+		public static void SetBatch(Client client, Mesh[] meshes, float[][] verts, int[][] faces, float[][] vertexNormals, float[][] uvs, bool smooth)
+		{
+			var descs = new MeshDescriptor[meshes.Length];
+			var handles = new System.Collections.Generic.List<GCHandle>();
+
+			System.Func<System.Array, System.IntPtr> pin = arr =>
+			{
+				if (arr == null) return System.IntPtr.Zero;
+				var handle = GCHandle.Alloc(arr, GCHandleType.Pinned);
+				handles.Add(handle);
+				return handle.AddrOfPinnedObject();
+			};
+
+			try
+			{
+				for (var i = 0; i < meshes.Length; i++)
+				{
+					var vn = vertexNormals == null ? null : vertexNormals[i];
+					var uv = uvs == null ? null : uvs[i];
+					descs[i] = new MeshDescriptor
+					{
+						meshId = meshes[i].Id,
+						shaderId = client.Scene.GetShaderSceneId(meshes[i].Shader),
+						smooth = (uint)(smooth ? 1 : 0),
+						verts = pin(verts[i]),
+						vcount = (uint)(verts[i].Length/3),
+						faces = pin(faces[i]),
+						fcount = (uint)(faces[i].Length/3),
+						vnormals = pin(vn),
+						vnormalcount = (uint)(vn == null ? 0 : vn.Length/3),
+						uvs = pin(uv),
+						uvcount = (uint)(uv == null ? 0 : uv.Length/2),
+					};
+				}
+
+				CSycles.scene_add_meshes_batch(client.Id, client.Scene.Id, descs);
+			}
+			finally
+			{
+				foreach (var handle in handles) handle.Free();
+			}
+		}
+
 		/// <summary>
 		/// Set vertex normals
 		/// </summary>
@@ -42,6 +42,21 @@ namespace ccl
 			Id = CSycles.scene_add_object(Client.Id, Client.Scene.Id);
 		}
 
+		/// <summary>
+		/// Create a new object as instance of mesh. The mesh geometry is shared
+		/// with all other objects using it, and stored only once.
+		/// </summary>
+		/// <param name="client"></param>
+		/// <param name="mesh">Mesh to instance</param>
+		/// <param name="transform">Object transformation</param>
+		public Object(Client client, Mesh mesh, Transform transform)
+		{
+			Client = client;
+			m_mesh = mesh;
+
+			Id = CSycles.scene_add_mesh_instance(Client.Id, Client.Scene.Id, mesh.Id, transform);
+		}
+
 		private Mesh m_mesh;
 		/// <summary>
 		/// Get or set the mesh
@@ -165,6 +165,17 @@ namespace ccl
 			return null;
 		}
 
+		/// <summary>
+		/// Get statistics on meshes shared between objects.
+		/// </summary>
+		public InstanceStats InstanceStats
+		{
+			get
+			{
+				return CSycles.scene_get_instance_stats(Client.Id, Id);
+			}
+		}
+
 		/// <summary>
 		/// Get or set the default surface shader for this scene.
 		/// </summary>
@@ -149,6 +149,21 @@ namespace ccl
 			}
 		}
 
+		/// <summary>
+		/// Deliver the callbacks from a separate thread at most this many
+		/// times per second, coalescing what happens in between. Render
+		/// threads then never wait for callback code. 0 calls the callbacks
+		/// directly from the render threads.
+		/// </summary>
+		public float CallbackRate
+		{
+			set
+			{
+				if (Destroyed) return;
+				CSycles.session_set_callback_rate(Client.Id, Id, value);
+			}
+		}
+
 		/// <summary>
 		/// Start the rendering session. After this one should Wait() for
 		/// the session to complete.
@@ -179,6 +194,41 @@ namespace ccl
 			CSycles.session_cancel(Client.Id, Id, cancelMessage);
 		}
 
+		/// <summary>
+		/// Keep up to capacity destroyed sessions per device for reuse, so
+		/// new sessions skip device and thread startup. 0 keeps none.
+		/// </summary>
+		public static void SetPoolCapacity(Client client, uint capacity)
+		{
+			CSycles.session_pool_set_capacity(client.Id, capacity);
+		}
+
+		/// <summary>
+		/// Create count sessions for sessionParams ahead of time and put them
+		/// in the pool, no more than it has room for.
+		/// </summary>
+		/// <returns>Number of sessions created</returns>
+		public static uint PrewarmPool(Client client, SessionParameters sessionParams, uint count)
+		{
+			return CSycles.session_pool_prewarm(client.Id, sessionParams.Id, count);
+		}
+
+		/// <summary>
+		/// Destroy all sessions in the pool.
+		/// </summary>
+		public static void ClearPool(Client client)
+		{
+			CSycles.session_pool_clear(client.Id);
+		}
+
+		/// <summary>
+		/// Get pool hit rate and startup time saved.
+		/// </summary>
+		public static SessionPoolStats PoolStats(Client client)
+		{
+			return CSycles.session_pool_get_stats(client.Id);
+		}
+
 		/// <summary>
 		/// Destroy the session and all related.
 		/// </summary>
@@ -229,6 +279,80 @@ namespace ccl
 			return CSycles.session_copy_buffer(Client.Id, Id, bufSize);
 		}
 
+		/// <summary>
+		/// Copy the session buffer as half floats. Set BufferFormat to
+		/// BufferFormat.Half first.
+		/// </summary>
+		/// <exception cref="System.InvalidOperationException">BufferFormat isn't BufferFormat.Half</exception>
+		/// <returns>Half float bits, four per pixel</returns>
+		public ushort[] CopyBufferHalf()
+		{
+			if (Destroyed) return null;
+			uint bufStride = 0;
+			uint bufSize = 0;
+
+			BufferInfo(out bufSize, out bufStride);
+
+			return CSycles.session_copy_buffer_half(Client.Id, Id, bufSize);
+		}
+
+		/// <summary>
+		/// Copy the session buffer as 8-bit sRGB. Set BufferFormat to
+		/// BufferFormat.Rgba8Srgb first.
+		/// </summary>
+		/// <exception cref="System.InvalidOperationException">BufferFormat isn't BufferFormat.Rgba8Srgb</exception>
+		/// <returns>RGBA bytes, four per pixel</returns>
+		public byte[] CopyBufferRgba8()
+		{
+			if (Destroyed) return null;
+			uint bufStride = 0;
+			uint bufSize = 0;
+
+			BufferInfo(out bufSize, out bufStride);
+
+			return CSycles.session_copy_buffer_rgba8(Client.Id, Id, bufSize);
+		}
+
+		/// <summary>
+		/// Set the format the session buffer gets copied in. Conversion
+		/// happens natively as tiles arrive.
+		/// </summary>
+		public BufferFormat BufferFormat
+		{
+			set
+			{
+				if (Destroyed) return;
+				CSycles.session_set_buffer_format(Client.Id, Id, value);
+			}
+		}
+
+		/// <summary>
+		/// Update buffer, previously filled with CopyBuffer, with only the
+		/// areas that changed since the last copy.
+		/// </summary>
+		/// <param name="buffer">Full size pixel buffer to update, float[], ushort[] or byte[] matching BufferFormat</param>
+		/// <param name="rects">Receives the areas that got updated</param>
+		/// <returns>Number of entries in rects that got filled</returns>
+		public int CopyDirtyRegions(System.Array buffer, BufferRect[] rects)
+		{
+			if (Destroyed) return 0;
+			return CSycles.session_copy_dirty_regions(Client.Id, Id, buffer, rects);
+		}
+
+		/// <summary>
+		/// Generation of the most recently published frame. Increases with
+		/// each update, compare against the last seen value to skip CopyBuffer
+		/// when nothing changed.
+		/// </summary>
+		public ulong BufferGeneration
+		{
+			get
+			{
+				if (Destroyed) return 0;
+				return CSycles.session_get_buffer_generation(Client.Id, Id);
+			}
+		}
+
 		/// <summary>
 		/// Retrieve the buffer information for this Session
 		/// </summary>
@@ -245,6 +369,36 @@ namespace ccl
 			CSycles.session_get_buffer_info(Client.Id, Id, out bufferSize, out bufferStride);
 		}
 
+		/// <summary>
+		/// Register an additional render pass for this Session. The pass gets
+		/// filled during the same render as the combined pass.
+		///
+		/// Add passes before Reset and Start.
+		/// </summary>
+		/// <param name="passType">The pass to add</param>
+		public void AddPass(PassType passType)
+		{
+			if (Destroyed) return;
+			CSycles.session_add_pass(Client.Id, Id, passType);
+		}
+
+		/// <summary>
+		/// Copy the ccycles API level buffer for passType through CSycles.
+		/// </summary>
+		/// <param name="passType">The pass to copy</param>
+		/// <returns>Pixel data, or null if pass isn't registered</returns>
+		public float[] CopyPassBuffer(PassType passType)
+		{
+			if (Destroyed) return null;
+			uint bufStride = 0;
+			uint bufSize = 0;
+
+			CSycles.session_get_pass_buffer_info(Client.Id, Id, passType, out bufSize, out bufStride);
+			if (bufSize == 0) return null;
+
+			return CSycles.session_copy_pass_buffer(Client.Id, Id, passType, bufSize);
+		}
+
 		/// <summary>
 		/// Reset a Session
 		/// </summary>
@@ -258,6 +412,96 @@ namespace ccl
 			CSycles.session_reset(Client.Id, Id, width, height, samples);
 		}
 
+		/// <summary>
+		/// Reset a Session to render only a region of the frame. The camera
+		/// stays set up for the full frame, CopyBuffer returns just the region.
+		/// </summary>
+		/// <param name="fullWidth">Width of the full frame</param>
+		/// <param name="fullHeight">Height of the full frame</param>
+		/// <param name="x">Left edge of the region</param>
+		/// <param name="y">Top edge of the region</param>
+		/// <param name="width">Width of the region</param>
+		/// <param name="height">Height of the region</param>
+		/// <param name="samples">The amount of samples to reset with</param>
+		public void ResetRegion(uint fullWidth, uint fullHeight, uint x, uint y, uint width, uint height, uint samples)
+		{
+			if (Destroyed) return;
+			CSycles.progress_reset(Client.Id, Id);
+			CSycles.session_reset_region(Client.Id, Id, fullWidth, fullHeight, x, y, width, height, samples);
+		}
+
+		/// <summary>
+		/// Copy a region rendered with ResetRegion into the full frame buffer.
+		/// </summary>
+		/// <param name="fullBuffer">RGBA buffer of fullWidth x fullHeight pixels</param>
+		/// <param name="fullWidth">Width of the full frame</param>
+		/// <param name="fullHeight">Height of the full frame</param>
+		/// <param name="regionBuffer">RGBA buffer of the region, as returned by CopyBuffer</param>
+		/// <param name="x">Left edge of the region</param>
+		/// <param name="y">Top edge of the region</param>
+		/// <param name="width">Width of the region</param>
+		/// <param name="height">Height of the region</param>
+		public static void MergeRegion(float[] fullBuffer, uint fullWidth, uint fullHeight, float[] regionBuffer, uint x, uint y, uint width, uint height)
+		{
+			CSycles.merge_region(fullBuffer, fullWidth, fullHeight, regionBuffer, x, y, width, height, 4);
+		}
+
+		/// <summary>
+		/// Keep the raw, un-normalized render buffer so it can be merged with
+		/// renders of the same frame by other processes. Set before Reset.
+		/// </summary>
+		public bool KeepRawBuffer
+		{
+			set
+			{
+				if (Destroyed) return;
+				CSycles.session_set_keep_raw_buffer(Client.Id, Id, value);
+			}
+		}
+
+		/// <summary>
+		/// Copy the raw render buffer. Needs KeepRawBuffer.
+		/// </summary>
+		/// <param name="samples">Receives the sample count of each pixel</param>
+		/// <param name="passStride">Receives the number of floats per pixel</param>
+		/// <returns>Accumulated pass data, or null if no raw buffer is kept</returns>
+		public float[] CopyRawBuffer(out uint[] samples, out uint passStride)
+		{
+			samples = null;
+			passStride = 0;
+			if (Destroyed) return null;
+
+			uint width, height;
+			CSycles.session_get_raw_buffer_info(Client.Id, Id, out width, out height, out passStride);
+			if (width == 0 || height == 0 || passStride == 0) return null;
+
+			var buffer = new float[width * height * passStride];
+			samples = new uint[width * height];
+			CSycles.session_copy_raw_buffer(Client.Id, Id, buffer, samples);
+			return buffer;
+		}
+
+		/// <summary>
+		/// Replace the raw render buffer, for instance with the merged result
+		/// of several processes, and update the render result from it.
+		/// </summary>
+		/// <param name="buffer">Accumulated pass data, as from CopyRawBuffer</param>
+		/// <param name="samples">Sample count of each pixel</param>
+		public void ImportRawBuffer(float[] buffer, uint[] samples)
+		{
+			if (Destroyed) return;
+			CSycles.session_import_raw_buffer(Client.Id, Id, buffer, samples);
+		}
+
+		/// <summary>
+		/// Add the raw buffer src to dst. Merging the raw buffers of renders
+		/// with different seeds gives the same result as one longer render.
+		/// </summary>
+		public static void MergeRawBuffers(float[] dst, uint[] dstSamples, float[] src, uint[] srcSamples, uint passStride)
+		{
+			CSycles.merge_raw_buffers(dst, dstSamples, src, srcSamples, (uint)dstSamples.Length, passStride);
+		}
+
 		/// <summary>
 		/// Pause or un-pause a render session.
 		/// </summary>
@@ -268,6 +512,70 @@ namespace ccl
 			CSycles.session_set_pause(Client.Id, Id, pause);
 		}
 
+		/// <summary>
+		/// Enable adaptive sampling. The render ends once every tile has an
+		/// estimated relative noise below threshold, after at least minSamples.
+		/// Works with progressive rendering and progressive refine.
+		/// </summary>
+		/// <param name="threshold">Noise threshold, 0 to disable</param>
+		/// <param name="minSamples">Samples to take before a tile can converge</param>
+		public void SetAdaptiveSampling(float threshold, uint minSamples)
+		{
+			if (Destroyed) return;
+			CSycles.session_set_adaptive_sampling(Client.Id, Id, threshold, minSamples);
+		}
+
+		/// <summary>
+		/// Get the sample counts and convergence state of the tiles rendered so far.
+		/// </summary>
+		/// <param name="maxTiles">Maximum number of tiles to return</param>
+		public TileInfo[] TileSampleInfo(int maxTiles)
+		{
+			if (Destroyed) return new TileInfo[0];
+			var tiles = new TileInfo[maxTiles];
+			var count = CSycles.tilemanager_get_tile_sample_info(Client.Id, Id, tiles);
+			System.Array.Resize(ref tiles, (int)count);
+			return tiles;
+		}
+
+		/// <summary>
+		/// Take the progress events that happened since the last call.
+		/// </summary>
+		/// <param name="maxEvents">Maximum number of events to return</param>
+		public SessionEvent[] PollEvents(int maxEvents)
+		{
+			if (Destroyed) return new SessionEvent[0];
+			var events = new SessionEvent[maxEvents];
+			var count = CSycles.session_poll_events(Client.Id, Id, events);
+			System.Array.Resize(ref events, (int)count);
+			return events;
+		}
+
+		/// <summary>
+		/// Throughput and timing statistics since the last Reset.
+		/// </summary>
+		public SessionStats Stats
+		{
+			get
+			{
+				if (Destroyed) return new SessionStats();
+				return CSycles.session_get_stats(Client.Id, Id);
+			}
+		}
+
+		/// <summary>
+		/// Get all progress information in one lock-free call, meant for
+		/// polling once per UI frame.
+		/// </summary>
+		public ProgressSnapshot ProgressSnapshot
+		{
+			get
+			{
+				if (Destroyed) return new ProgressSnapshot();
+				return CSycles.session_get_progress_snapshot(Client.Id, Id);
+			}
+		}
+
 		/// <summary>
 		/// Set sample count for session to render. This can be used to increase the sample
 		/// count for an interactive render session.
@@ -235,5 +235,18 @@ namespace ccl
 				CSycles.session_params_set_shadingsystem(Client.Id, Id, value);
 			}
 		}
+
+		/// <summary>
+		/// Set a wall clock budget in seconds, 0 for none. The render picks the
+		/// largest sample count that fits, up to the requested samples, and
+		/// always ends with an evenly sampled frame. Turns on progressive refine.
+		/// </summary>
+		public double TimeLimit
+		{
+			set
+			{
+				CSycles.session_params_set_time_limit(Client.Id, Id, value);
+			}
+		}
 	}
 }
@@ -143,6 +143,41 @@ namespace ccl
 		Static
 	}
 
+	/// <summary>
+	/// Render passes that can be registered on a session
+	/// with Session.AddPass. Combined is always available.
+	/// </summary>
+	[FlagsAttribute]
+	public enum PassType : uint
+	{
+		None = 0,
+		Combined = (1 << 0),
+		Depth = (1 << 1),
+		Normal = (1 << 2),
+		UV = (1 << 3),
+		ObjectId = (1 << 4),
+		MaterialId = (1 << 5),
+		DiffuseColor = (1 << 6),
+		GlossyColor = (1 << 7),
+		TransmissionColor = (1 << 8),
+		DiffuseIndirect = (1 << 9),
+		GlossyIndirect = (1 << 10),
+		TransmissionIndirect = (1 << 11),
+		DiffuseDirect = (1 << 12),
+		GlossyDirect = (1 << 13),
+		TransmissionDirect = (1 << 14),
+		Emission = (1 << 15),
+		Background = (1 << 16),
+		AO = (1 << 17),
+		Shadow = (1 << 18),
+		Motion = (1 << 19),
+		MotionWeight = (1 << 20),
+		Mist = (1 << 21),
+		SubsurfaceDirect = (1 << 22),
+		SubsurfaceIndirect = (1 << 23),
+		SubsurfaceColor = (1 << 24),
+	}
+
 	public enum TileOrder : uint
 	{
 		Center,
@@ -152,6 +187,52 @@ namespace ccl
 		BottomToTop
 	}
 
+	/// <summary>
+	/// Formats session pixel data can be copied in.
+	/// </summary>
+	public enum BufferFormat : uint
+	{
+		/// <summary>32-bit float RGBA</summary>
+		Float,
+		/// <summary>16-bit half float RGBA</summary>
+		Half,
+		/// <summary>8-bit RGBA, RGB sRGB encoded, alpha linear</summary>
+		Rgba8Srgb
+	}
+
+	/// <summary>
+	/// Kinds of session progress events.
+	/// </summary>
+	public enum SessionEventType : uint
+	{
+		/// <summary>A finished tile got copied to the session buffer</summary>
+		TileDone,
+		/// <summary>All pixels got another pass of samples</summary>
+		SampleDone,
+		/// <summary>Status or substatus text changed</summary>
+		StatusChanged,
+		/// <summary>The render completed all samples</summary>
+		Finished,
+		/// <summary>The device reported an error</summary>
+		DeviceError,
+		/// <summary>A tile still being rendered got its progress so far copied to the session buffer</summary>
+		TileUpdate
+	}
+
+	/// <summary>
+	/// Log levels, lower is more verbose.
+	/// </summary>
+	public enum LogLevel : uint
+	{
+		Trace,
+		Debug,
+		Info,
+		Warning,
+		Error,
+		/// <summary>Log nothing</summary>
+		None
+	}
+
 	public enum CameraType : uint
 	{
 		Perspective,
@@ -0,0 +1,223 @@
+﻿/**
+Copyright 2014-2015 Robert McNeel and Associates
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+**/
+
+using System;
+using System.Diagnostics;
+using ccl;
+
+namespace csycles_bench
+{
+	/// <summary>
+	/// Measures how fast geometry gets through the API into Cycles.
+	///
+	/// Usage: csycles_bench [triangle count]
+	/// </summary>
+	class Program
+	{
+		static Client Client { get; set; }
+		static Scene Scene { get; set; }
+
+		/// <summary>
+		/// Grid of quads, two triangles each, with at least triCount triangles.
+		/// </summary>
+		static void MakeGrid(uint triCount, out float[] verts3, out float[] verts4, out int[] faces)
+		{
+			var side = (int)Math.Ceiling(Math.Sqrt(triCount / 2.0));
+			var vside = side + 1;
+
+			verts3 = new float[vside * vside * 3];
+			verts4 = new float[vside * vside * 4];
+			for (var y = 0; y < vside; y++)
+			{
+				for (var x = 0; x < vside; x++)
+				{
+					var v = y * vside + x;
+					verts3[v * 3] = verts4[v * 4] = x;
+					verts3[v * 3 + 1] = verts4[v * 4 + 1] = y;
+					verts3[v * 3 + 2] = verts4[v * 4 + 2] = 0.0f;
+				}
+			}
+
+			faces = new int[side * side * 6];
+			var f = 0;
+			for (var y = 0; y < side; y++)
+			{
+				for (var x = 0; x < side; x++)
+				{
+					var v = y * vside + x;
+					faces[f++] = v;
+					faces[f++] = v + 1;
+					faces[f++] = v + vside + 1;
+					faces[f++] = v;
+					faces[f++] = v + vside + 1;
+					faces[f++] = v + vside;
+				}
+			}
+		}
+
+		static void Report(string name, int triCount, Stopwatch sw)
+		{
+			var seconds = sw.Elapsed.TotalSeconds;
+			Console.WriteLine("{0,-34} {1,10:N0} tris {2,10:N3}s {3,14:N0} tris/s", name, triCount, seconds, triCount / seconds);
+		}
+
+		/// <summary>
+		/// Many small meshes, one after the other versus all in one batch.
+		/// </summary>
+		static void BenchBatch(Shader shader, int meshCount, int trisPerMesh)
+		{
+			float[] verts3;
+			float[] verts4;
+			int[] faces;
+			MakeGrid((uint)trisPerMesh, out verts3, out verts4, out faces);
+			var count = meshCount * (faces.Length / 3);
+
+			var verts = new float[meshCount][];
+			var meshFaces = new int[meshCount][];
+			for (var i = 0; i < meshCount; i++)
+			{
+				verts[i] = verts3;
+				meshFaces[i] = faces;
+			}
+
+			Console.WriteLine("Mesh ingest, {0:N0} meshes", meshCount);
+
+			var sw = Stopwatch.StartNew();
+			for (var i = 0; i < meshCount; i++)
+			{
+				var mesh = new Mesh(Client, shader);
+				mesh.SetVerts(ref verts3);
+				mesh.SetVertTris(ref faces, false);
+			}
+			sw.Stop();
+			Report("Sequential SetVerts + SetVertTris", count, sw);
+
+			sw = Stopwatch.StartNew();
+			var meshes = new Mesh[meshCount];
+			for (var i = 0; i < meshCount; i++)
+			{
+				meshes[i] = new Mesh(Client, shader);
+			}
+			Mesh.SetBatch(Client, meshes, verts, meshFaces, null, null, false);
+			sw.Stop();
+			Report("Mesh.SetBatch", count, sw);
+		}
+
+		static CSycles.LoggerCallback loggerCallback = msg => { };
+
+		/// <summary>
+		/// Many small mesh uploads, each logging, with logging on and off.
+		/// Only levels built into ccycles can be turned on, so run this
+		/// against a debug build to see the cost of logging.
+		/// </summary>
+		static void BenchLogging(Shader shader, int meshCount, int trisPerMesh)
+		{
+			float[] verts3;
+			float[] verts4;
+			int[] faces;
+			MakeGrid((uint)trisPerMesh, out verts3, out verts4, out faces);
+			var count = meshCount * (faces.Length / 3);
+
+			Console.WriteLine("Mesh ingest with logging, {0:N0} meshes", meshCount);
+
+			CSycles.set_logger(Client.Id, loggerCallback);
+
+			foreach (var level in new[] { LogLevel.Trace, LogLevel.None })
+			{
+				CSycles.set_log_level(level);
+
+				var sw = Stopwatch.StartNew();
+				for (var i = 0; i < meshCount; i++)
+				{
+					var mesh = new Mesh(Client, shader);
+					mesh.SetVerts(ref verts3);
+					mesh.SetVertTris(ref faces, false);
+				}
+				sw.Stop();
+				Report("Logging " + level, count, sw);
+			}
+
+			CSycles.remove_logger(Client.Id);
+			CSycles.set_log_level(LogLevel.Trace);
+		}
+
+		static void Main(string[] args)
+		{
+			uint triCount = 2000000;
+			if (args.Length > 0) triCount = uint.Parse(args[0]);
+
+			CSycles.initialise();
+
+			Client = new Client();
+			var sceneParams = new SceneParameters(Client, ShadingSystem.SVM, BvhType.Static, false, false, false);
+			Scene = new Scene(Client, sceneParams, Device.Default);
+			var shader = Scene.DefaultSurface;
+
+			float[] verts3;
+			float[] verts4;
+			int[] faces;
+			MakeGrid(triCount, out verts3, out verts4, out faces);
+			var count = faces.Length / 3;
+
+			var shaders = new Shader[count];
+			var smooth = new bool[count];
+			for (var i = 0; i < count; i++)
+			{
+				shaders[i] = shader;
+				smooth[i] = (i & 1) == 0;
+			}
+
+			Console.WriteLine("Mesh ingest, {0:N0} vertices", verts3.Length / 3);
+
+			var sw = Stopwatch.StartNew();
+			var mesh = new Mesh(Client, shader);
+			mesh.SetVerts(ref verts3);
+			for (var i = 0; i < count; i++)
+			{
+				mesh.AddTri((uint)faces[i * 3], (uint)faces[i * 3 + 1], (uint)faces[i * 3 + 2], shader, false);
+			}
+			sw.Stop();
+			Report("AddTri per face", count, sw);
+
+			sw = Stopwatch.StartNew();
+			mesh = new Mesh(Client, shader);
+			mesh.SetVerts(ref verts3);
+			mesh.SetVertTris(ref faces, false);
+			sw.Stop();
+			Report("SetVerts + SetVertTris", count, sw);
+
+			sw = Stopwatch.StartNew();
+			mesh = new Mesh(Client, shader);
+			mesh.SetVertsFloat4(ref verts4);
+			mesh.SetVertTris(ref faces, false);
+			sw.Stop();
+			Report("SetVertsFloat4 + SetVertTris", count, sw);
+
+			sw = Stopwatch.StartNew();
+			mesh = new Mesh(Client, shader);
+			mesh.SetVertsFloat4(ref verts4);
+			mesh.SetVertTris(ref faces, shaders, smooth);
+			sw.Stop();
+			Report("SetVertsFloat4 + per-face tris", count, sw);
+
+			BenchBatch(shader, 2000, count / 2000);
+
+			BenchLogging(shader, 20000, 100);
+
+			CSycles.shutdown();
+		}
+	}
+}
@@ -0,0 +1,77 @@
+﻿using NUnit.Framework;
+using ccl;
+
+namespace csycles_unittests
+{
+	[TestFixture]
+	public class TestMergeRawBuffers
+	{
+		const uint PassStride = 4;
+
+		/* Raw buffers hold per pixel sums over samples. */
+		private static void SetPixel(float[] buffer, uint[] samples, uint pixel, uint count, float r, float g, float b, float a)
+		{
+			samples[pixel] = count;
+			buffer[pixel * PassStride + 0] = r * count;
+			buffer[pixel * PassStride + 1] = g * count;
+			buffer[pixel * PassStride + 2] = b * count;
+			buffer[pixel * PassStride + 3] = a * count;
+		}
+
+		[Test]
+		public void TestMergeRawBuffersSampleWeighted()
+		{
+			var dst = new float[2 * PassStride];
+			var dstSamples = new uint[2];
+			var src = new float[2 * PassStride];
+			var srcSamples = new uint[2];
+
+			SetPixel(dst, dstSamples, 0, 4, 1.0f, 2.0f, 3.0f, 1.0f);
+			SetPixel(src, srcSamples, 0, 12, 3.0f, 3.0f, 3.0f, 1.0f);
+			SetPixel(dst, dstSamples, 1, 1, 0.0f, 0.0f, 0.0f, 1.0f);
+			SetPixel(src, srcSamples, 1, 3, 4.0f, 8.0f, 0.0f, 1.0f);
+
+			CSycles.merge_raw_buffers(dst, dstSamples, src, srcSamples, 2, PassStride);
+
+			Assert.AreEqual(16u, dstSamples[0]);
+			Assert.AreEqual(4u, dstSamples[1]);
+
+			/* Averages weighted by the sample count of each side. */
+			float[] expected = { 2.5f, 2.75f, 3.0f, 1.0f, 3.0f, 6.0f, 0.0f, 1.0f };
+			for (uint i = 0; i < expected.Length; i++)
+			{
+				Assert.AreEqual(expected[i], dst[i] / dstSamples[i / PassStride], 1e-6f, "component {0}", i);
+			}
+
+			/* src is left alone. */
+			Assert.AreEqual(12u, srcSamples[0]);
+			Assert.AreEqual(36.0f, src[0]);
+		}
+
+		[Test]
+		public void TestMergeRawBuffersZeroSamples()
+		{
+			var dst = new float[2 * PassStride];
+			var dstSamples = new uint[2];
+			var src = new float[2 * PassStride];
+			var srcSamples = new uint[2];
+
+			/* Pixel 0 has no samples in src, pixel 1 none in dst. */
+			SetPixel(dst, dstSamples, 0, 5, 0.5f, 0.25f, 1.0f, 1.0f);
+			SetPixel(src, srcSamples, 0, 0, 0.0f, 0.0f, 0.0f, 0.0f);
+			SetPixel(dst, dstSamples, 1, 0, 0.0f, 0.0f, 0.0f, 0.0f);
+			SetPixel(src, srcSamples, 1, 8, 2.0f, 4.0f, 6.0f, 1.0f);
+
+			CSycles.merge_raw_buffers(dst, dstSamples, src, srcSamples, 2, PassStride);
+
+			Assert.AreEqual(5u, dstSamples[0]);
+			Assert.AreEqual(8u, dstSamples[1]);
+
+			float[] expected = { 2.5f, 1.25f, 5.0f, 5.0f, 16.0f, 32.0f, 48.0f, 8.0f };
+			for (uint i = 0; i < expected.Length; i++)
+			{
+				Assert.AreEqual(expected[i], dst[i], "component {0}", i);
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+﻿using NUnit.Framework;
+using ccl;
+
+namespace csycles_unittests
+{
+	[TestFixture]
+	public class TestMergeRegion
+	{
+		const uint FullWidth = 4;
+		const uint FullHeight = 3;
+		const uint Stride = 4;
+
+		/* Region buffer where every float holds its own index plus one. */
+		private static float[] Region(uint width, uint height)
+		{
+			var region = new float[width * height * Stride];
+			for (int i = 0; i < region.Length; i++) region[i] = i + 1;
+			return region;
+		}
+
+		[TestCase(0u, 0u, 4u, 3u)]
+		[TestCase(1u, 1u, 2u, 2u)]
+		[TestCase(3u, 2u, 1u, 1u)]
+		[TestCase(0u, 2u, 4u, 1u)]
+		public void TestMergeRegionPlacement(uint x, uint y, uint width, uint height)
+		{
+			var full = new float[FullWidth * FullHeight * Stride];
+			var region = Region(width, height);
+
+			CSycles.merge_region(full, FullWidth, FullHeight, region, x, y, width, height, Stride);
+
+			for (uint py = 0; py < FullHeight; py++)
+			{
+				for (uint px = 0; px < FullWidth; px++)
+				{
+					bool inside = px >= x && px < x + width && py >= y && py < y + height;
+					for (uint c = 0; c < Stride; c++)
+					{
+						float expected = inside ? region[((py - y) * width + (px - x)) * Stride + c] : 0.0f;
+						Assert.AreEqual(expected, full[(py * FullWidth + px) * Stride + c], "pixel {0},{1} component {2}", px, py, c);
+					}
+				}
+			}
+		}
+
+		[TestCase(1u, 0u, 4u, 1u)]
+		[TestCase(0u, 1u, 1u, 3u)]
+		[TestCase(4u, 0u, 1u, 1u)]
+		[TestCase(0u, 3u, 1u, 1u)]
+		[TestCase(uint.MaxValue, 0u, 2u, 1u)]
+		[TestCase(0u, uint.MaxValue, 1u, 2u)]
+		public void TestMergeRegionOutOfRange(uint x, uint y, uint width, uint height)
+		{
+			var full = new float[FullWidth * FullHeight * Stride];
+			var region = Region(width, height);
+
+			CSycles.merge_region(full, FullWidth, FullHeight, region, x, y, width, height, Stride);
+
+			foreach (float f in full)
+			{
+				Assert.AreEqual(0.0f, f);
+			}
+		}
+	}
+}